@@ -1,4 +1,5 @@
 #include "matBasic_complex.hpp"
+#include "matBasic_split.hpp"
 #include "matBasic_testUtil.hpp"
 
 i_complex_matrix genTestMatrixA(const std::size_t nAnt)
@@ -81,6 +82,49 @@ i_complex_matrix genTestMatrixb(const std::size_t nAnt, const std::size_t nEq)
     return resMat;
 }
 
+// Same system as genTestMatrixA(nAnt), built row by row without a dense copy
+i_complex_sparse_matrix genSparseTestMatrixA(const std::size_t nAnt)
+{
+    const std::size_t nrows = (nAnt - 1) * nAnt + 1;
+    std::vector<std::vector<std::pair<std::size_t, i_complex_t>>> rowEntries(nrows);
+    for (std::size_t row{0}; row < nAnt; ++row)
+    {
+        for (std::size_t col{0}; col < row; ++col)
+        {
+            i_complex_t lambda{static_cast<i_float_t>(row + 1), static_cast<i_float_t>(col + 1)};
+            std::size_t row_this = col * (nAnt - 1) + row - (row > col);
+            std::size_t row_that = row * (nAnt - 1) + col;
+            rowEntries[row_this] = {{col, -1.0}, {row, lambda}};
+            rowEntries[row_that] = {{col, lambda}, {row, -1.0}};
+        }
+    }
+    rowEntries[nrows - 1] = {{0, 1.0}};
+    i_complex_sparse_matrix resMat(0, nAnt);
+    for (const auto &entries : rowEntries)
+    {
+        resMat.appendRow(entries);
+    }
+    return resMat;
+}
+
+// Incomplete baseline graph: antenna i only pairs with i + offset (mod nAnt), two rows per baseline plus the reference row
+i_complex_sparse_matrix genSparseBaselineMatrixA(const std::size_t nAnt, const std::vector<std::size_t> &offsets, const i_float_t drift = 0.0)
+{
+    i_complex_sparse_matrix resMat(0, nAnt);
+    for (std::size_t row{0}; row < nAnt; ++row)
+    {
+        for (const std::size_t offset : offsets)
+        {
+            const std::size_t col{(row + offset) % nAnt};
+            const i_complex_t lambda{i_complex_t{static_cast<i_float_t>((row * 7 + col) % 97 + 2), static_cast<i_float_t>((row + col) % 13)} * (1.0 + drift)};
+            resMat.appendRow({{row, -1.0}, {col, lambda}});
+            resMat.appendRow({{row, lambda}, {col, -1.0}});
+        }
+    }
+    resMat.appendRow({{0, 1.0}});
+    return resMat;
+}
+
 void pinvTest(bool doLargeMatTest = true)
 {
     std::cout << "\n\n******************** pinv test ********************\n\n";
@@ -243,10 +287,1509 @@ void determinantTest()
     timer.toc("large matrix determinant");
 }
 
+void denseMatrixTest()
+{
+    std::cout << "\n\n******************** dense matrix test ********************\n\n";
+    i_complex_matrix matA = {
+        {{1.0, 0.0}, {2.0, 0.0}, {3.0, 2.0}},
+        {{2.0, 0.0}, {5.0, 0.0}, {3.0, 0.0}},
+        {{0.0, 7.0}, {4.0, 0.0}, {3.0, 0.0}}};
+    i_complex_dense_matrix denseA = toDenseMatrix(matA);
+    std::cout << "denseA: " << denseA.rows() << " x " << denseA.cols() << ", stride = " << denseA.stride() << "\n";
+    showMatrix(toNestedMatrix(denseA), "toNestedMatrix(denseA)");
+    showMatrix(inv(denseA), "inv(denseA)");
+    std::cout << "det(denseA) = " << det(denseA) << "\n\n\n";
+
+    std::size_t nAnt = 64;
+    i_complex_dense_matrix largeA = toDenseMatrix(genTestMatrixA(nAnt));
+    i_complex_dense_matrix largeb = toDenseMatrix(genTestMatrixb(nAnt));
+    TestTimer timer;
+    timer.tic();
+    i_complex_dense_matrix largex = leftDiv(largeA, largeb);
+    timer.toc("dense pinv2 method");
+    showMatrix(largex, "dense mat x");
+}
+
+void simdKernelTest()
+{
+    std::cout << "\n\n******************** SIMD kernel test ********************\n\n";
+    std::cout << "Detected instruction set: " << simdLevelName(simdLevel()) << "\n";
+    const std::size_t nSize{500};
+    i_complex_dense_matrix matA = initComplexDenseMatrix(nSize, nSize);
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            matA(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j) % 13) - 6.0, static_cast<i_float_t>((i + 3 * j) % 5)};
+        }
+    }
+
+    const i_simd_level detected{simdLevel()};
+    i_complex_dense_matrix reference;
+    TestTimer timer;
+    for (int level{static_cast<int>(detected)}; level >= 0; --level)
+    {
+        setSimdLevel(static_cast<i_simd_level>(level));
+        timer.tic();
+        i_complex_dense_matrix matC = matMul(matA, transpose(matA));
+        timer.toc(simdLevelName(simdLevel()));
+        if (reference.empty())
+        {
+            reference = matC;
+            continue;
+        }
+        i_float_t maxDiff{0.0};
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            for (std::size_t j{0}; j < nSize; ++j)
+            {
+                maxDiff = std::max(maxDiff, static_cast<i_float_t>(std::abs(matC(i, j) - reference(i, j))));
+            }
+        }
+        std::cout << "max |C - C_" << simdLevelName(detected) << "| = " << maxDiff << "\n";
+    }
+    setSimdLevel(detected);
+}
+
+void splitComplexTest()
+{
+    std::cout << "\n\n******************** split complex test ********************\n\n";
+    i_complex_matrix matA = {
+        {{0.0, 0.0}, {2.0, 0.0}, {3.0, 2.0}, {5.0, 0.0}},
+        {{2.0, 0.0}, {0.0, 0.0}, {3.0, 0.0}, {6.0, 0.0}},
+        {{0.0, 7.0}, {4.0, 0.0}, {0.0, 0.0}, {1.0, 0.0}},
+        {{-6.0, 0.0}, {3.0, 0.0}, {1.0, 0.0}, {0.0, 0.0}}};
+    i_split_complex_matrix splitA = toSplitComplexMatrix(matA);
+    showMatrix(splitA, "splitA");
+    std::cout << "det(splitA) = " << det(splitA) << ", det(matA) = " << det(matA) << "\n";
+    showMatrix(inv(splitA), "inv(splitA)");
+    showMatrix(inv(matA), "inv(matA)");
+    showMatrix(matMul(splitA, transpose(splitA)), "splitA * splitA'");
+
+    const std::size_t nSize{500};
+    i_complex_dense_matrix largeA = initComplexDenseMatrix(nSize, nSize);
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            largeA(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j) % 13) - 6.0, static_cast<i_float_t>((i + 3 * j) % 5)};
+        }
+        largeA(i, i) += 50.0;
+    }
+    i_split_complex_matrix largeSplitA = toSplitComplexMatrix(largeA);
+    TestTimer timer;
+    timer.tic();
+    i_complex_dense_matrix largeC = matMul(largeA, largeA);
+    timer.toc("interleaved matMul");
+    timer.tic();
+    i_split_complex_matrix largeSplitC = matMul(largeSplitA, largeSplitA);
+    timer.toc("split matMul");
+    timer.tic();
+    i_split_complex_matrix largeSplitInv = inv(largeSplitA);
+    timer.toc("split inv");
+    timer.tic();
+    i_complex_dense_matrix largeInv = inv(largeA);
+    timer.toc("interleaved inv");
+
+    i_complex_dense_matrix interleavedC = toInterleavedMatrix(largeSplitC), interleavedInv = toInterleavedMatrix(largeSplitInv);
+    i_float_t maxDiffC{0.0}, maxDiffInv{0.0};
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            maxDiffC = std::max(maxDiffC, std::abs(interleavedC(i, j) - largeC(i, j)));
+            maxDiffInv = std::max(maxDiffInv, std::abs(interleavedInv(i, j) - largeInv(i, j)));
+        }
+    }
+    std::cout << "max |C_split - C| = " << maxDiffC << ", max |inv_split - inv| = " << maxDiffInv << "\n";
+}
+
+void luFactorizationTest()
+{
+    std::cout << "\n\n******************** LU factorization test ********************\n\n";
+    i_complex_dense_matrix matA = toDenseMatrix(i_complex_matrix{
+        {{4.0, 1.0}, {2.0, 0.0}, {3.0, -1.0}},
+        {{2.0, 0.0}, {5.0, 2.0}, {3.0, 0.0}},
+        {{1.0, -2.0}, {4.0, 0.0}, {1.0, 1.0}}});
+    i_complex_lu_factorization factorA(matA);
+    i_complex_dense_matrix matb = toDenseMatrix(i_complex_matrix{{{1.0, 0.0}}, {{2.0, 1.0}}, {{3.0, 0.0}}});
+    showMatrix(factorA.solve(matb), "factorA.solve(b)");
+    showMatrix(factorA.inverse(), "factorA.inverse()");
+    std::cout << "factorA.det() = " << factorA.det() << ", logdet = " << factorA.logdet() << ", sign = " << factorA.detSign() << "\n\n";
+
+    const std::size_t nSize{600}, nrhs{8};
+    i_complex_dense_matrix largeA = initComplexDenseMatrix(nSize, nSize);
+    i_complex_dense_matrix largeB = initComplexDenseMatrix(nSize, nrhs);
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            largeA(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j * 3) % 17) - 8.0 + (i == j ? 16.0 : 0.0),
+                                       static_cast<i_float_t>((i + 5 * j) % 7) - 3.0};
+        }
+        for (std::size_t j{0}; j < nrhs; ++j)
+        {
+            largeB(i, j) = i_complex_t{static_cast<i_float_t>((i + j) % 5) - 2.0, static_cast<i_float_t>(j % 3)};
+        }
+    }
+    TestTimer timer;
+    timer.tic();
+    i_complex_lu_factorization factorLarge(largeA);
+    timer.toc("LU factorization (600 x 600)");
+    timer.tic();
+    i_complex_dense_matrix largeX = factorLarge.solve(largeB);
+    timer.toc("LU solve (8 right-hand sides)");
+    timer.tic();
+    i_complex_dense_matrix largeInv = factorLarge.inverse();
+    timer.toc("LU inverse (reusing the factors)");
+
+    i_complex_dense_matrix residual = matMul(largeA, largeX);
+    i_float_t maxResidual{0.0};
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nrhs; ++j)
+        {
+            maxResidual = std::max(maxResidual, std::abs(residual(i, j) - largeB(i, j)));
+        }
+    }
+    i_complex_dense_matrix identity = matMul(largeA, largeInv);
+    i_float_t maxIdentity{0.0};
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            maxIdentity = std::max(maxIdentity, std::abs(identity(i, j) - (i == j ? i_complex_t{1.0} : i_complex_t{0.0})));
+        }
+    }
+    std::cout << "max |A * X - B| = " << maxResidual << "\n";
+    std::cout << "max |A * inv(A) - I| = " << maxIdentity << "\n";
+    std::cout << "logdet(A) = " << factorLarge.logdet() << ", sign = " << factorLarge.detSign() << "\n";
+}
+
+void leftDivTest()
+{
+    std::cout << "\n\n******************** leftDiv test ********************\n\n";
+    i_complex_matrix matA = {
+        {{4.0, 1.0}, {2.0, 0.0}, {3.0, -1.0}},
+        {{2.0, 0.0}, {5.0, 2.0}, {3.0, 0.0}},
+        {{1.0, -2.0}, {4.0, 0.0}, {1.0, 1.0}}};
+    i_complex_matrix matb = {{{1.0, 0.0}}, {{2.0, 1.0}}, {{3.0, 0.0}}};
+    showMatrix(leftDiv(matA, matb), "A \\ b (square, LU)");
+    i_complex_matrix matF = {
+        {1.0, 2.0, {3.0, 2.0}, 0.0},
+        {2.0, 5.0, 3.0, 0.0},
+        {{0.0, 7.0}, 4.0, 3.0, 0.0},
+        {-6.0, 3.0, 1.0, 0.0},
+        {3.0, 2.0, {1.0, 5.0}, 0.0}};
+    i_complex_matrix matbF = {{1.0}, {2.0}, {{3.0, 1.0}}, {4.0}, {5.0}};
+    showMatrix(leftDiv(matF, matbF), "F \\ b (rank deficient, pinv)");
+    showMatrix(matMul(pinv2(matF), matbF), "pinv2(F) * b");
+
+    std::size_t nAnt = 64;
+    std::size_t nEq = 4032;
+    i_complex_dense_matrix largeA = toDenseMatrix(genTestMatrixA(nAnt, nEq));
+    i_complex_dense_matrix largeb = toDenseMatrix(genTestMatrixb(nAnt, nEq));
+    TestTimer timer;
+    timer.tic();
+    i_complex_dense_matrix largex = leftDiv(largeA, largeb);
+    timer.toc("leftDiv, tall system (QR)");
+    timer.tic();
+    i_complex_dense_matrix largex_pinv = matMul(pinv2(largeA), largeb);
+    timer.toc("pinv2(A) * b, tall system");
+    i_float_t maxDiff{0.0};
+    for (std::size_t i{0}; i < largex.rows(); ++i)
+    {
+        maxDiff = std::max(maxDiff, std::abs(largex(i, 0) - largex_pinv(i, 0)));
+    }
+    std::cout << "max |x - pinv2(A) * b| = " << maxDiff << "\n";
+
+    const std::size_t nSize{300}, nrhs{64};
+    i_complex_dense_matrix squareA = initComplexDenseMatrix(nSize, nSize);
+    i_complex_dense_matrix squareB = initComplexDenseMatrix(nSize, nrhs);
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            squareA(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j * 3) % 17) - 8.0 + (i == j ? 16.0 : 0.0),
+                                        static_cast<i_float_t>((i + 5 * j) % 7) - 3.0};
+        }
+        for (std::size_t j{0}; j < nrhs; ++j)
+        {
+            squareB(i, j) = i_complex_t{static_cast<i_float_t>((i + j) % 5) - 2.0, static_cast<i_float_t>(j % 3)};
+        }
+    }
+    timer.tic();
+    i_complex_dense_matrix squareX = leftDiv(squareA, squareB);
+    timer.toc("leftDiv, 300 x 300 with 64 right-hand sides (LU)");
+    timer.tic();
+    i_complex_dense_matrix squareX_pinv = matMul(pinv2(squareA), squareB);
+    timer.toc("pinv2(A) * B, 300 x 300 with 64 right-hand sides");
+    maxDiff = 0.0;
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nrhs; ++j)
+        {
+            maxDiff = std::max(maxDiff, std::abs(squareX(i, j) - squareX_pinv(i, j)));
+        }
+    }
+    std::cout << "max |X - pinv2(A) * B| = " << maxDiff << "\n";
+}
+
+void qrLeastSquaresTest()
+{
+    std::cout << "\n\n******************** QR least squares test ********************\n\n";
+    const std::size_t nrows{600}, ncols{10};
+    i_complex_dense_matrix matA = initComplexDenseMatrix(nrows, ncols);
+    i_complex_dense_matrix matb = initComplexDenseMatrix(nrows, 1);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        const i_float_t t{static_cast<i_float_t>(i) / static_cast<i_float_t>(nrows - 1)};
+        const i_complex_t z{t * std::cos(t), t * std::sin(t)};
+        i_complex_t power{1.0};
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            matA(i, j) = power; // Complex Vandermonde matrix, ill-conditioned
+            matb(i, 0) += power; // Exact solution x = [1; 1; ...; 1]
+            power *= z;
+        }
+    }
+    i_complex_qr_factorization factorQR(matA);
+    i_complex_dense_matrix matxQR = factorQR.solve(matb);
+    i_complex_dense_matrix matxPinv = matMul(pinv2(matA), matb);
+    i_float_t errQR{0.0}, errPinv{0.0};
+    for (std::size_t j{0}; j < ncols; ++j)
+    {
+        errQR = std::max(errQR, std::abs(matxQR(j, 0) - 1.0));
+        errPinv = std::max(errPinv, std::abs(matxPinv(j, 0) - 1.0));
+    }
+    std::cout << "Vandermonde " << nrows << " x " << ncols << ", max |x - 1|: QR = " << errQR << ", pinv2 (A' * A) = " << errPinv << "\n";
+
+    std::size_t nAnt = 64;
+    std::size_t nEq = 4032;
+    i_complex_dense_matrix largeA = toDenseMatrix(genTestMatrixA(nAnt, nEq));
+    i_complex_dense_matrix largeb = toDenseMatrix(genTestMatrixb(nAnt, nEq));
+    TestTimer timer;
+    timer.tic();
+    i_complex_qr_factorization factorLarge(largeA);
+    timer.toc("QR factorization (4033 x 64)");
+    timer.tic();
+    i_complex_dense_matrix largex = factorLarge.solve(largeb);
+    timer.toc("QR solve");
+    showMatrix(largex, "QR mat x");
+}
+
+void gramKernelTest()
+{
+    std::cout << "\n\n******************** Gram matrix (herk) test ********************\n\n";
+    const std::size_t nrows{4000}, ncols{256};
+    i_complex_dense_matrix matG = initComplexDenseMatrix(nrows, ncols);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            matG(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j) % 13) - 6.0, static_cast<i_float_t>((i + 3 * j) % 5)};
+        }
+    }
+    i_complex_dense_matrix matGtG = initComplexDenseMatrix(ncols, ncols), matHerk = initComplexDenseMatrix(ncols, ncols);
+    TestTimer timer;
+    timer.tic();
+    i_kernel::gemm(ncols, ncols, nrows, matG.data(), matG.stride(), true, matG.data(), matG.stride(), false, matGtG.data(), matGtG.stride());
+    timer.toc("G' * G, full GEMM");
+    timer.tic();
+    i_kernel::herk(ncols, nrows, matG.data(), matG.stride(), true, matHerk.data(), matHerk.stride());
+    timer.toc("G' * G, lower triangle (herk)");
+    i_float_t maxDiff{0.0}, maxUpper{0.0};
+    for (std::size_t i{0}; i < ncols; ++i)
+    {
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            if (j <= i)
+            {
+                maxDiff = std::max(maxDiff, static_cast<i_float_t>(std::abs(matHerk(i, j) - matGtG(i, j))));
+            }
+            else
+            {
+                maxUpper = std::max(maxUpper, static_cast<i_float_t>(std::abs(matHerk(i, j))));
+            }
+        }
+    }
+    std::cout << "max |lower(herk) - lower(gemm)| = " << maxDiff << ", max |upper(herk)| = " << maxUpper << "\n";
+    timer.tic();
+    std::size_t rankG = rank(matG);
+    timer.toc("rank(G)");
+    std::cout << "rank(G) = " << rankG << "\n";
+}
+
+void threadPoolTest()
+{
+    std::cout << "\n\n******************** Thread pool test ********************\n\n";
+    const std::size_t nSize{800}, defaultThreads{threadCount()};
+    i_complex_dense_matrix matA = initComplexDenseMatrix(nSize, nSize), matB = initComplexDenseMatrix(nSize, nSize);
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            matA(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j * 3) % 17) - 8.0 + (i == j ? 16.0 : 0.0), static_cast<i_float_t>((i + 2 * j) % 5) - 2.0};
+            matB(i, j) = i_complex_t{static_cast<i_float_t>((i + j * 5) % 11) - 5.0, static_cast<i_float_t>((i * 3 + j) % 7) - 3.0};
+        }
+    }
+    i_complex_dense_matrix matHpd = initComplexDenseMatrix(nSize, nSize);
+    i_kernel::herk(nSize, nSize, matA.data(), matA.stride(), true, matHpd.data(), matHpd.stride());
+
+    i_complex_dense_matrix serialMul, serialInv, serialChol;
+    for (const std::size_t nthreads : {std::size_t{1}, std::size_t{4}})
+    {
+        setThreadCount(nthreads);
+        std::cout << "threads = " << threadCount() << "\n";
+        TestTimer timer;
+        timer.tic();
+        i_complex_dense_matrix matC = matMul(matA, matB);
+        timer.toc("matMul (800 x 800)");
+        timer.tic();
+        i_complex_dense_matrix matInv = inv(matA);
+        timer.toc("inv (LU, 800 x 800)");
+        timer.tic();
+        i_complex_cholesky_factorization factorHpd(matHpd);
+        timer.toc("Cholesky of A' * A (800 x 800)");
+        if (nthreads == 1)
+        {
+            serialMul = matC;
+            serialInv = matInv;
+            serialChol = factorHpd.lower();
+            continue;
+        }
+        std::cout << "max |matMul - serial| = " << maxAbsDiff(matC, serialMul) << "\n";
+        std::cout << "max |inv - serial| = " << maxAbsDiff(matInv, serialInv) << "\n";
+        std::cout << "max |chol - serial| = " << maxAbsDiff(factorHpd.lower(), serialChol) << "\n";
+    }
+    setThreadCount(defaultThreads);
+}
+
+void taskGraphTest()
+{
+    std::cout << "\n\n******************** Task graph (tiled Cholesky & LU) test ********************\n\n";
+    const std::size_t nrows{700}, ncols{500}, nrank{300}, defaultThreads{threadCount()};
+    i_complex_dense_matrix matX = initComplexDenseMatrix(nrows, nrank), matY = initComplexDenseMatrix(nrank, ncols);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        for (std::size_t j{0}; j < nrank; ++j)
+        {
+            matX(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j * 3) % 17) - 8.0, static_cast<i_float_t>((i + j) % 3) - 1.0} + (i == j ? 20.0 : 0.0);
+        }
+    }
+    for (std::size_t i{0}; i < nrank; ++i)
+    {
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            matY(i, j) = i_complex_t{static_cast<i_float_t>((i * 5 + j) % 13) - 6.0, static_cast<i_float_t>((2 * i + j) % 5) - 2.0} + (i == j ? 20.0 : 0.0);
+        }
+    }
+    const i_complex_dense_matrix matG = matMul(matX, matY); // 700 x 500, rank 300
+    i_complex_dense_matrix matSquare = initComplexDenseMatrix(ncols, ncols);
+    for (std::size_t i{0}; i < ncols; ++i)
+    {
+        std::copy_n(matG.row(i), ncols, matSquare.row(i));
+        matSquare(i, i) += 1000.0;
+    }
+
+    i_complex_dense_matrix serialPinv;
+    for (const std::size_t nthreads : {std::size_t{1}, std::size_t{4}})
+    {
+        setThreadCount(nthreads);
+        std::cout << "threads = " << threadCount() << "\n";
+        TestTimer timer;
+        timer.tic();
+        const std::size_t rankG{rank(matG)};
+        timer.toc("rank(G), tiled Cholesky of G' * G");
+        timer.tic();
+        const i_complex_dense_matrix pinvG = pinv2(matG);
+        timer.toc("pinv2(G)");
+        timer.tic();
+        const i_complex_lu_factorization factorSquare(matSquare);
+        timer.toc("tiled LU (500 x 500)");
+        std::cout << "rank(G) = " << rankG << ", logdet = " << factorSquare.logdet() << "\n";
+        if (nthreads == 1)
+        {
+            serialPinv = pinvG;
+            continue;
+        }
+        i_float_t maxDiff{0.0};
+        for (std::size_t i{0}; i < pinvG.rows(); ++i)
+        {
+            for (std::size_t j{0}; j < pinvG.cols(); ++j)
+            {
+                maxDiff = std::max(maxDiff, static_cast<i_float_t>(std::abs(pinvG(i, j) - serialPinv(i, j))));
+            }
+        }
+        std::cout << "max |pinv2 - serial| = " << maxDiff << "\n";
+    }
+    setThreadCount(defaultThreads);
+}
+
+void sparseTest()
+{
+    std::cout << "\n\n******************** Sparse (CSR) test ********************\n\n";
+    const std::size_t nAnt{64};
+    const i_complex_dense_matrix denseA = toDenseMatrix(genTestMatrixA(nAnt)), denseb = toDenseMatrix(genTestMatrixb(nAnt));
+    const i_complex_sparse_matrix sparseA = genSparseTestMatrixA(nAnt);
+    std::cout << "A: " << sparseA.rows() << " x " << sparseA.cols() << ", nnz = " << sparseA.nnz() << " (dense " << denseA.size() << ")\n";
+    std::cout << "max |dense(sparse A) - A| = " << maxAbsDiff(toDenseMatrix(sparseA), denseA) << "\n";
+    std::cout << "max |sparse(A)' * b - A' * b| = " << maxAbsDiff(adjointMul(toSparseMatrix(denseA), denseb), matMul(transpose(denseA), denseb)) << "\n";
+
+    TestTimer timer;
+    timer.tic();
+    const i_complex_dense_matrix densex = leftDiv(denseA, denseb);
+    timer.toc("leftDiv, dense (QR)");
+    timer.tic();
+    const i_complex_dense_matrix sparsex = leftDiv(sparseA, denseb);
+    timer.toc("leftDiv, sparse (normal equations)");
+    std::cout << "max |x_sparse - x_dense| = " << maxAbsDiff(sparsex, densex) << "\n";
+    timer.tic();
+    const i_complex_dense_matrix densePinv = pinv2(denseA);
+    timer.toc("pinv2, dense");
+    timer.tic();
+    const i_complex_dense_matrix sparsePinv = pinv2(sparseA);
+    timer.toc("pinv2, sparse");
+    std::cout << "max |pinv2(sparse A) - pinv2(A)| = " << maxAbsDiff(sparsePinv, densePinv) << "\n";
+
+    const std::size_t nAntLarge{300};
+    const i_complex_sparse_matrix largeA = genSparseTestMatrixA(nAntLarge);
+    i_complex_dense_matrix largeb = initComplexDenseMatrix(largeA.rows(), 1);
+    largeb(largeA.rows() - 1, 0) = 1.0;
+    timer.tic();
+    const i_complex_dense_matrix largex = leftDiv(largeA, largeb);
+    timer.toc("leftDiv, sparse (nAnt = 300)");
+    i_complex_dense_matrix residual = matMul(largeA, largex);
+    for (std::size_t i{0}; i < residual.rows(); ++i)
+    {
+        residual(i, 0) -= largeb(i, 0);
+    }
+    const i_complex_dense_matrix normalResidual = adjointMul(largeA, residual);
+    std::cout << "A: " << largeA.rows() << " x " << largeA.cols() << ", nnz = " << largeA.nnz()
+              << ", max |A' * (A * x - b)| = " << maxAbsDiff(normalResidual, initComplexDenseMatrix(nAntLarge, 1)) << "\n";
+}
+
+void iterativeSolverTest()
+{
+    std::cout << "\n\n******************** Iterative least squares (CGLS, LSQR, LSMR) test ********************\n\n";
+    const std::size_t nAnt{64};
+    const i_complex_sparse_matrix sparseA = genSparseTestMatrixA(nAnt);
+    const i_complex_sparse_operator opA(sparseA);
+    const i_complex_dense_matrix matb = toDenseMatrix(genTestMatrixb(nAnt));
+    const i_complex_dense_matrix directx = leftDiv(sparseA, matb);
+    const auto report = [&](const char *name, const i_iterative_info &info, const i_complex_dense_matrix &matx, const i_complex_dense_matrix &reference) {
+        std::cout << name << ": iterations = " << info.iterations << ", converged = " << info.converged
+                  << ", ||A' * r|| / ||A' * b|| = " << info.normalResidual << ", max |x - leftDiv| = " << maxAbsDiff(matx, reference) << "\n";
+    };
+
+    // Next snapshot: every measurement drifts by up to 0.1 %
+    i_complex_dense_matrix nextb = matb;
+    for (std::size_t i{0}; i < nextb.rows(); ++i)
+    {
+        nextb(i, 0) *= 1.0 + 1.0e-3 * (static_cast<i_complex_t>(i % 7) - 3.0) / 3.0;
+    }
+    const i_complex_dense_matrix nextx = leftDiv(sparseA, nextb);
+
+    TestTimer timer;
+    using solver_t = i_iterative_info (*)(const i_complex_linear_operator &, const i_complex_dense_matrix &, i_complex_dense_matrix &, i_float_t, std::size_t);
+    const std::pair<const char *, solver_t> solvers[]{{"cgls", cgls<i_complex_t>}, {"lsqr", lsqr<i_complex_t>}, {"lsmr", lsmr<i_complex_t>}};
+    for (const auto &solver : solvers)
+    {
+        i_complex_dense_matrix matx;
+        timer.tic();
+        const i_iterative_info coldInfo = solver.second(opA, matb, matx, 1.0e-10, 0);
+        timer.toc(solver.first);
+        report("cold start", coldInfo, matx, directx);
+        timer.tic();
+        const i_iterative_info warmInfo = solver.second(opA, nextb, matx, 1.0e-10, 0); // matx still holds the previous solution
+        timer.toc(solver.first);
+        report("warm start, next snapshot", warmInfo, matx, nextx);
+    }
+
+    // Same problem through a dense operator & a matrix-free one that only forwards the two products
+    const i_complex_dense_matrix denseA = toDenseMatrix(sparseA);
+    i_complex_dense_matrix densex;
+    report("lsmr (dense operator)", lsmr(i_complex_dense_operator(denseA), matb, densex), densex, directx);
+    const i_complex_function_operator opFunc(
+        sparseA.rows(), sparseA.cols(),
+        [&opA](const i_complex_t *x, i_complex_t *y) { opA.apply(x, y); },
+        [&opA](const i_complex_t *x, i_complex_t *y) { opA.applyAdjoint(x, y); });
+    i_complex_dense_matrix funcx;
+    report("lsqr (function operator)", lsqr(opFunc, matb, funcx), funcx, directx);
+
+    // Single precision with the default tolerance, defaultTolerance<std::complex<float>>() = 1e-4
+    const i_dense_matrix<std::complex<float>> floatA = castMatrix<std::complex<float>>(denseA), floatb = castMatrix<std::complex<float>>(matb);
+    const i_dense_operator<std::complex<float>> floatOpA(floatA);
+    i_dense_matrix<std::complex<float>> cglsFloatx, lsqrFloatx, lsmrFloatx;
+    const i_iterative_info cglsFloatInfo = cgls(floatOpA, floatb, cglsFloatx), lsqrFloatInfo = lsqr(floatOpA, floatb, lsqrFloatx), lsmrFloatInfo = lsmr(floatOpA, floatb, lsmrFloatx);
+    report("cgls (float)", cglsFloatInfo, castMatrix<i_complex_t>(cglsFloatx), directx);
+    report("lsqr (float)", lsqrFloatInfo, castMatrix<i_complex_t>(lsqrFloatx), directx);
+    report("lsmr (float)", lsmrFloatInfo, castMatrix<i_complex_t>(lsmrFloatx), directx);
+}
+
+void sparseCholeskyTest()
+{
+    std::cout << "\n\n******************** Sparse Cholesky (LDL', AMD ordering) test ********************\n\n";
+    const std::size_t nAnt{2000};
+    const std::vector<std::size_t> offsets{1, 37, 211};
+    const i_complex_sparse_matrix matA = genSparseBaselineMatrixA(nAnt, offsets);
+    i_complex_dense_matrix matb = initComplexDenseMatrix(matA.rows(), 1);
+    for (std::size_t i{0}; i < matA.rows(); ++i)
+    {
+        matb(i, 0) = static_cast<i_float_t>(i % 5) - 2.0;
+    }
+
+    const i_complex_sparse_matrix matN = sparseGramMatrix(matA);
+    const i_complex_dense_matrix matAtb = adjointMul(matA, matb);
+    std::cout << "A: " << matA.rows() << " x " << matA.cols() << ", nnz(A' * A) = " << matN.nnz() << " of " << nAnt * nAnt << "\n";
+    std::cout << "max |sparseGramMatrix(A) - gramMatrix(A)| = " << maxAbsDiff(toDenseMatrix(matN), gramMatrix(matA)) << "\n";
+
+    TestTimer timer;
+    i_complex_sparse_cholesky_factorization natural;
+    natural.analyze(matN, false);
+    timer.tic();
+    i_complex_sparse_cholesky_factorization factorN;
+    factorN.analyze(matN);
+    timer.toc("analyze (AMD ordering, elimination tree)");
+    std::cout << "nnz(L): natural order = " << natural.nnzL() << ", AMD = " << factorN.nnzL() << "\n";
+    timer.tic();
+    factorN.factorize(matN);
+    timer.toc("factorize");
+    timer.tic();
+    const i_complex_dense_matrix sparsex = factorN.solve(matAtb);
+    timer.toc("solve");
+    timer.tic();
+    const i_complex_cholesky_factorization denseFactor(toDenseMatrix(matN));
+    const i_complex_dense_matrix densex = denseFactor.solve(matAtb);
+    timer.toc("dense Cholesky factor & solve");
+    std::cout << "positive definite = " << factorN.positiveDefinite() << ", max |x_sparse - x_dense| = " << maxAbsDiff(sparsex, densex) << "\n";
+
+    // Next snapshot: same baselines, new values, the analysis is reused
+    const i_complex_sparse_matrix nextA = genSparseBaselineMatrixA(nAnt, offsets, 1.0e-3);
+    const i_complex_sparse_matrix nextN = sparseGramMatrix(nextA);
+    timer.tic();
+    factorN.factorize(nextN);
+    const i_complex_dense_matrix nextx = factorN.solve(adjointMul(nextA, matb));
+    timer.toc("factorize & solve, next snapshot (analysis reused)");
+    i_complex_dense_matrix residual = matMul(nextA, nextx);
+    for (std::size_t i{0}; i < residual.rows(); ++i)
+    {
+        residual(i, 0) -= matb(i, 0);
+    }
+    std::cout << "max |A' * (A * x - b)| = " << maxAbsDiff(adjointMul(nextA, residual), initComplexDenseMatrix(nAnt, 1)) << "\n";
+    timer.tic();
+    const i_complex_dense_matrix leftDivx = leftDiv(nextA, matb);
+    timer.toc("leftDiv, sparse (sparse LDL')");
+    std::cout << "max |leftDiv - x| = " << maxAbsDiff(leftDivx, nextx) << "\n";
+
+    // Same nnz, different pattern: refused instead of writing outside the analyzed columns of L
+    i_complex_sparse_cholesky_factorization smallFactor;
+    smallFactor.analyze(toSparseMatrix(toDenseMatrix(i_complex_matrix{{4.0, 1.0, 0.0}, {1.0, 4.0, 0.0}, {0.0, 0.0, 4.0}})), false);
+    const bool otherPattern{smallFactor.factorize(toSparseMatrix(toDenseMatrix(i_complex_matrix{{4.0, 0.0, 1.0}, {0.0, 4.0, 0.0}, {1.0, 0.0, 4.0}})))};
+    std::cout << "factorize with another pattern of the same nnz: " << otherPattern << ", positive definite = " << smallFactor.positiveDefinite() << "\n";
+}
+
+void batchTest()
+{
+    std::cout << "\n\n******************** Batched small-matrix test ********************\n\n";
+    i_complex_matrix_batch smallBatch(3, 2, 2);
+    smallBatch.setMatrix(0, toDenseMatrix(i_complex_matrix{{4.0, 7.0}, {2.0, 6.0}}));
+    smallBatch.setMatrix(1, toDenseMatrix(i_complex_matrix{{0.0, i_complex_t{0.0, 1.0}}, {1.0, 0.0}}));
+    smallBatch.setMatrix(2, toDenseMatrix(i_complex_matrix{{1.0, 2.0}, {2.0, 4.0}})); // Singular
+    const std::vector<i_complex_t> smallDet = det(smallBatch);
+    std::cout << "det = " << smallDet[0] << ", " << smallDet[1] << ", " << smallDet[2] << "\n";
+    const i_complex_matrix_batch smallInv = inv(smallBatch);
+    showMatrix(toNestedMatrix(smallInv.matrix(0)), "inv(batch)[0]");
+    showMatrix(toNestedMatrix(smallInv.matrix(1)), "inv(batch)[1]");
+
+    const std::size_t count{100000};
+    std::size_t seed{12345};
+    for (const std::size_t nSize : {std::size_t{2}, std::size_t{4}, std::size_t{8}})
+    {
+        i_complex_matrix_batch batchA(count, nSize, nSize), batchB(count, nSize, 1);
+        for (std::size_t b{0}; b < count; ++b)
+        {
+            for (std::size_t i{0}; i < nSize; ++i)
+            {
+                for (std::size_t j{0}; j < nSize; ++j)
+                {
+                    seed = seed * 6364136223846793005u + 1442695040888963407u;
+                    batchA.set(b, i, j, static_cast<i_float_t>(seed >> 11) / 9007199254740992.0 - 0.5);
+                }
+                batchB.set(b, i, 0, static_cast<i_float_t>(i + 1));
+            }
+        }
+        std::vector<i_complex_dense_matrix> matrices(count);
+        for (std::size_t b{0}; b < count; ++b)
+        {
+            matrices[b] = batchA.matrix(b);
+        }
+
+        std::cout << "\n" << count << " matrices of " << nSize << " x " << nSize << "\n";
+        TestTimer timer;
+        timer.tic();
+        std::vector<i_complex_dense_matrix> loopInv(count);
+        std::vector<i_complex_t> loopDet(count);
+        for (std::size_t b{0}; b < count; ++b)
+        {
+            loopInv[b] = inv(matrices[b]);
+            loopDet[b] = det(matrices[b]);
+        }
+        const double loopTime{timer.toc("inv & det, one call per matrix")};
+        timer.tic();
+        const i_complex_matrix_batch batchInv = inv(batchA);
+        const std::vector<i_complex_t> batchDet = det(batchA);
+        const double batchTime{timer.toc("inv & det, batched")};
+        timer.tic();
+        const i_complex_matrix_batch batchX = leftDiv(batchA, batchB);
+        timer.toc("leftDiv, batched");
+        std::cout << "batched: " << static_cast<double>(count) / batchTime * 1.0e-6 << " M matrices/s (inv & det), speedup " << loopTime / batchTime << "\n";
+
+        i_float_t maxInvDiff{0.0}, maxDetDiff{0.0}, maxResidual{0.0};
+        for (std::size_t b{0}; b < count; ++b)
+        {
+            maxDetDiff = std::max(maxDetDiff, static_cast<i_float_t>(std::abs(batchDet[b] - loopDet[b]) / std::max<i_float_t>(1.0, std::abs(loopDet[b]))));
+            for (std::size_t i{0}; i < nSize; ++i)
+            {
+                i_complex_t residual{-batchB.get(b, i, 0)};
+                for (std::size_t j{0}; j < nSize; ++j)
+                {
+                    maxInvDiff = std::max(maxInvDiff, static_cast<i_float_t>(std::abs(batchInv.get(b, i, j) - loopInv[b](i, j)) / std::max<i_float_t>(1.0, std::abs(loopInv[b](i, j)))));
+                    residual += batchA.get(b, i, j) * batchX.get(b, j, 0);
+                }
+                maxResidual = std::max(maxResidual, static_cast<i_float_t>(std::abs(residual)));
+            }
+        }
+        std::cout << "max relative |inv_batch - inv| = " << maxInvDiff << ", max relative |det_batch - det| = " << maxDetDiff << ", max |A * x - b| = " << maxResidual << "\n";
+    }
+}
+
+void fixedMatrixTest()
+{
+    std::cout << "\n\n******************** Fixed-size matrix test ********************\n\n";
+    const i_complex_fixed_matrix<2, 2> fixedA({{{4.0, 1.0}, 7.0}, {2.0, {6.0, -2.0}}});
+    const i_complex_fixed_matrix<3, 3> fixedB({{0.0, {2.0, 1.0}, 3.0}, {2.0, 5.0, {0.0, 3.0}}, {1.0, 4.0, 1.0}});
+    const i_complex_fixed_matrix<4, 4> fixedC({{1.0, 2.0, 3.0, 5.0}, {2.0, 5.0, 3.0, 6.0}, {0.0, 4.0, 1.0, 5.0}, {-6.0, {3.0, -1.0}, 9.0, 1.0}});
+    const i_complex_fixed_matrix<5, 5> fixedD({{0.0, 1.0, 1.0, 4.0, 5.0}, {4.0, 0.0, 1.0, 9.0, 1.0}, {8.0, 1.0, 0.0, 0.0, 9.0}, {1.0, 1.0, 1.0, 0.0, 4.0}, {1.0, 4.0, 8.0, 1.0, 0.0}});
+    showMatrix(toNestedMatrix(toDenseMatrix(inv(fixedB))), "inv(fixedB)");
+    std::cout << "det: 2 x 2 = " << det(fixedA) << " (" << det(toDenseMatrix(fixedA)) << "), 3 x 3 = " << det(fixedB) << " (" << det(toDenseMatrix(fixedB))
+              << "), 4 x 4 = " << det(fixedC) << " (" << det(toDenseMatrix(fixedC)) << "), 5 x 5 = " << det(fixedD) << " (" << det(toDenseMatrix(fixedD)) << ")\n";
+    std::cout << "max |inv - dense inv|: 2 x 2 = " << maxAbsDiff(toDenseMatrix(inv(fixedA)), inv(toDenseMatrix(fixedA)))
+              << ", 3 x 3 = " << maxAbsDiff(toDenseMatrix(inv(fixedB)), inv(toDenseMatrix(fixedB)))
+              << ", 4 x 4 = " << maxAbsDiff(toDenseMatrix(inv(fixedC)), inv(toDenseMatrix(fixedC)))
+              << ", 5 x 5 = " << maxAbsDiff(toDenseMatrix(inv(fixedD)), inv(toDenseMatrix(fixedD))) << "\n";
+    const i_complex_fixed_matrix<4, 1> fixedb({{1.0}, {2.0}, {3.0}, {4.0}});
+    std::cout << "max |C \\ b - dense leftDiv| = " << maxAbsDiff(toDenseMatrix(leftDiv(fixedC, fixedb)), leftDiv(toDenseMatrix(fixedC), toDenseMatrix(fixedb))) << "\n";
+    const i_complex_fixed_matrix<5, 3> fixedTall({{1.0, 2.0, 3.0}, {2.0, 5.0, 3.0}, {7.0, 4.0, 3.0}, {-6.0, 3.0, 1.0}, {3.0, 2.0, 1.0}});
+    const i_complex_fixed_matrix<5, 1> fixedbTall({{1.0}, {2.0}, {3.0}, {4.0}, {5.0}});
+    std::cout << "max |tall \\ b - dense leftDiv| = " << maxAbsDiff(toDenseMatrix(leftDiv(fixedTall, fixedbTall)), leftDiv(toDenseMatrix(fixedTall), toDenseMatrix(fixedbTall))) << "\n";
+    std::cout << "max |C * C' - dense| = " << maxAbsDiff(toDenseMatrix(matMul(fixedC, transpose(fixedC))), matMul(toDenseMatrix(fixedC), transpose(toDenseMatrix(fixedC)))) << "\n";
+    inv(i_complex_fixed_matrix<3, 3>({{1.0, 2.0, 3.0}, {2.0, 4.0, 6.0}, {0.0, 1.0, 1.0}})); // Singular: warning & zero matrix
+    // matMul(fixedB, fixedC); // Does not compile: "matMul: dimension not match (columns of A != rows of B)"
+
+    // Per-sample transforms: x_k = inv(T_k) * y_k
+    const std::size_t nSamples{200000};
+    i_complex_t checksumDense{0.0}, checksumFixed{0.0};
+    TestTimer timer;
+    timer.tic();
+    for (std::size_t k{0}; k < nSamples; ++k)
+    {
+        i_complex_dense_matrix matT = toDenseMatrix(fixedC);
+        matT(0, 0) += static_cast<i_float_t>(k % 17);
+        checksumDense += matMul(inv(matT), toDenseMatrix(fixedb))(3, 0);
+    }
+    timer.toc("4 x 4 inv & matMul, dynamic matrices");
+    timer.tic();
+    for (std::size_t k{0}; k < nSamples; ++k)
+    {
+        i_complex_fixed_matrix<4, 4> matT{fixedC};
+        matT(0, 0) += static_cast<i_float_t>(k % 17);
+        checksumFixed += matMul(inv(matT), fixedb)(3, 0);
+    }
+    timer.toc("4 x 4 inv & matMul, fixed-size matrices");
+    std::cout << "checksum: dynamic = " << checksumDense << ", fixed = " << checksumFixed << "\n";
+    timer.tic();
+    for (std::size_t k{0}; k < nSamples; ++k)
+    {
+        i_complex_dense_matrix matT = toDenseMatrix(fixedB);
+        matT(0, 0) += static_cast<i_float_t>(k % 17);
+        checksumDense += det(matT);
+    }
+    timer.toc("3 x 3 det, dynamic matrices");
+    timer.tic();
+    for (std::size_t k{0}; k < nSamples; ++k)
+    {
+        i_complex_fixed_matrix<3, 3> matT{fixedB};
+        matT(0, 0) += static_cast<i_float_t>(k % 17);
+        checksumFixed += det(matT);
+    }
+    timer.toc("3 x 3 det, fixed-size matrices");
+    std::cout << "checksum: dynamic = " << checksumDense << ", fixed = " << checksumFixed << "\n";
+}
+
+void streamingLeastSquaresTest()
+{
+    std::cout << "\n\n******************** Streaming least squares test ********************\n\n";
+
+    // Equations arrive one by one after the reference row (the last row of genTestMatrixA)
+    const std::size_t nAnt{32}, maxEq{(nAnt - 1) * nAnt};
+    const i_complex_dense_matrix allA = toDenseMatrix(genTestMatrixA(nAnt, maxEq));
+    const i_complex_dense_matrix allb = toDenseMatrix(genTestMatrixb(nAnt, maxEq));
+    std::vector<i_complex_dense_matrix> streamx(maxEq + 1), rebuildx(maxEq + 1);
+    TestTimer timer;
+    timer.tic();
+    i_complex_streaming_least_squares stream(nAnt);
+    stream.addRow(allA.row(maxEq), allb.row(maxEq));
+    for (std::size_t nEq{1}; nEq <= maxEq; ++nEq)
+    {
+        stream.addRow(allA.row(nEq - 1), allb.row(nEq - 1));
+        if (nEq >= nAnt)
+        {
+            streamx[nEq] = stream.solve();
+        }
+    }
+    timer.toc("streaming, add one equation & solve, every step");
+    std::vector<i_complex_dense_matrix> systemA(maxEq + 1), systemb(maxEq + 1);
+    for (std::size_t nEq{nAnt}; nEq <= maxEq; ++nEq)
+    {
+        systemA[nEq] = toDenseMatrix(genTestMatrixA(nAnt, nEq));
+        systemb[nEq] = toDenseMatrix(genTestMatrixb(nAnt, nEq));
+    }
+    timer.tic();
+    for (std::size_t nEq{nAnt}; nEq <= maxEq; ++nEq)
+    {
+        rebuildx[nEq] = leftDiv(systemA[nEq], systemb[nEq]);
+    }
+    timer.toc("leftDiv on the whole system, every step");
+    i_float_t maxDiff{0.0};
+    for (std::size_t nEq{nAnt}; nEq <= maxEq; ++nEq)
+    {
+        maxDiff = std::max(maxDiff, maxAbsDiff(streamx[nEq], rebuildx[nEq]));
+    }
+    std::cout << "equations: " << stream.count() << ", max |x_stream - leftDiv| over all steps = " << maxDiff << "\n";
+
+    // Forgetting factor: the row added k rows ago is weighted by sqrt(lambda)^k, row blocks give the same result
+    const std::size_t nSmall{8}, nSmallEq{(nSmall - 1) * nSmall};
+    const i_float_t lambda{0.95};
+    const i_complex_dense_matrix smallA = toDenseMatrix(genTestMatrixA(nSmall, nSmallEq));
+    i_complex_dense_matrix smallb = toDenseMatrix(genTestMatrixb(nSmall, nSmallEq));
+    for (std::size_t i{0}; i < nSmallEq; ++i)
+    {
+        smallb(i, 0) = static_cast<i_float_t>(i % 5) - 2.0; // Inconsistent, so the weighting matters
+    }
+    i_complex_streaming_least_squares rowStream(nSmall, 1, lambda), blockStream(nSmall, 1, lambda);
+    rowStream.addRow(smallA.row(nSmallEq), smallb.row(nSmallEq));
+    blockStream.addRow(smallA.row(nSmallEq), smallb.row(nSmallEq));
+    i_complex_dense_matrix weightedA = initComplexDenseMatrix(nSmallEq + 1, nSmall), weightedb = initComplexDenseMatrix(nSmallEq + 1, 1);
+    for (std::size_t i{0}; i <= nSmallEq; ++i)
+    {
+        if (i < nSmallEq)
+        {
+            rowStream.addRow(smallA.row(i), smallb.row(i));
+        }
+        const i_float_t weight{std::pow(std::sqrt(lambda), static_cast<i_float_t>(i < nSmallEq ? nSmallEq - 1 - i : nSmallEq))};
+        for (std::size_t j{0}; j < nSmall; ++j)
+        {
+            weightedA(i, j) = weight * smallA(i, j);
+        }
+        weightedb(i, 0) = weight * smallb(i, 0);
+    }
+    for (std::size_t i{0}; i < nSmallEq; i += 20)
+    {
+        const std::size_t nBlock{std::min<std::size_t>(20, nSmallEq - i)};
+        i_complex_dense_matrix blockA = initComplexDenseMatrix(nBlock, nSmall), blockb = initComplexDenseMatrix(nBlock, 1);
+        for (std::size_t r{0}; r < nBlock; ++r)
+        {
+            std::copy_n(smallA.row(i + r), nSmall, blockA.row(r));
+            blockb(r, 0) = smallb(i + r, 0);
+        }
+        blockStream.addRows(blockA, blockb);
+    }
+    const i_complex_dense_matrix weightedx = leftDiv(weightedA, weightedb);
+    const i_complex_dense_matrix residual = matMul(weightedA, weightedx);
+    i_float_t residualNorm2{0.0};
+    for (std::size_t i{0}; i <= nSmallEq; ++i)
+    {
+        residualNorm2 += std::norm(residual(i, 0) - weightedb(i, 0));
+    }
+    std::cout << "lambda = " << lambda << ", max |x_stream - weighted leftDiv|: rows = " << maxAbsDiff(rowStream.solve(), weightedx)
+              << ", blocks = " << maxAbsDiff(blockStream.solve(), weightedx) << "\n";
+    std::cout << "weighted residual ||r||^2: rows = " << rowStream.residualNorm2()[0] << ", blocks = " << blockStream.residualNorm2()[0]
+              << ", direct = " << residualNorm2 << "\n";
+}
+
+void slidingWindowTest()
+{
+    std::cout << "\n\n******************** Cholesky update / downdate & sliding window test ********************\n\n";
+
+    // Rank-k update & downdate against a fresh factorization
+    const std::size_t nSize{300}, nRank{4};
+    i_complex_dense_matrix matG = initComplexDenseMatrix(2 * nSize, nSize), matX = initComplexDenseMatrix(nSize, nRank);
+    for (std::size_t i{0}; i < 2 * nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            matG(i, j) = static_cast<i_float_t>((i * 7 + j * 3) % 17) - 8.0 + (i == j ? 9.0 : 0.0);
+        }
+    }
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nRank; ++j)
+        {
+            matX(i, j) = static_cast<i_float_t>((i + 5 * j) % 9) - 4.0;
+        }
+    }
+    const i_complex_dense_matrix matA = matMul(transpose(matG), matG);
+    const i_complex_dense_matrix matAX = matMul(matX, transpose(matX));
+    i_complex_dense_matrix matAplus = matA;
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            matAplus(i, j) += matAX(i, j);
+        }
+    }
+    i_complex_cholesky_factorization factorA(matA);
+    TestTimer timer;
+    timer.tic();
+    factorA.update(matX);
+    timer.toc("rank-4 update, 300 x 300");
+    timer.tic();
+    const i_complex_cholesky_factorization factorPlus(matAplus);
+    timer.toc("refactorization, 300 x 300");
+    std::cout << "max |L_update - L_refactor| = " << maxAbsDiff(factorA.lower(), factorPlus.lower()) << "\n";
+    timer.tic();
+    factorA.downdate(matX);
+    timer.toc("rank-4 downdate, 300 x 300");
+    std::cout << "max |L_downdate - L| = " << maxAbsDiff(factorA.lower(), i_complex_cholesky_factorization(matA).lower()) << "\n";
+    i_complex_dense_matrix matBig = matX;
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        matBig(i, 0) *= 1.0e3;
+    }
+    const bool downdated{factorA.downdate(matBig)};
+    std::cout << "downdate losing positive definiteness returns " << downdated << ", factor kept: max |L - L_before| = "
+              << maxAbsDiff(factorA.lower(), i_complex_cholesky_factorization(matA).lower()) << "\n";
+
+    // Window of the last 200 equations, compared with leftDiv on the rows in the window at every step
+    const std::size_t nAnt{32}, maxEq{(nAnt - 1) * nAnt}, nWindow{200};
+    const i_complex_dense_matrix allA = toDenseMatrix(genTestMatrixA(nAnt, maxEq));
+    i_complex_dense_matrix allb = initComplexDenseMatrix(maxEq, 1);
+    for (std::size_t i{0}; i < maxEq; ++i)
+    {
+        allb(i, 0) = static_cast<i_float_t>(i % 5) - 2.0;
+    }
+    std::vector<i_complex_dense_matrix> windowx(maxEq + 1), rebuildx(maxEq + 1), systemA(maxEq + 1), systemb(maxEq + 1);
+    for (std::size_t nEq{nWindow}; nEq <= maxEq; ++nEq)
+    {
+        systemA[nEq] = initComplexDenseMatrix(nWindow, nAnt);
+        systemb[nEq] = initComplexDenseMatrix(nWindow, 1);
+        for (std::size_t r{0}; r < nWindow; ++r)
+        {
+            std::copy_n(allA.row(nEq - nWindow + r), nAnt, systemA[nEq].row(r));
+            systemb[nEq](r, 0) = allb(nEq - nWindow + r, 0);
+        }
+    }
+    timer.tic();
+    i_complex_sliding_window_least_squares window(nAnt, nWindow);
+    for (std::size_t nEq{1}; nEq <= maxEq; ++nEq)
+    {
+        window.addRow(allA.row(nEq - 1), allb.row(nEq - 1));
+        if (nEq >= nWindow)
+        {
+            windowx[nEq] = window.solve();
+        }
+    }
+    timer.toc("sliding window, add one equation, drop the oldest & solve, every step");
+    timer.tic();
+    for (std::size_t nEq{nWindow}; nEq <= maxEq; ++nEq)
+    {
+        rebuildx[nEq] = leftDiv(systemA[nEq], systemb[nEq]);
+    }
+    timer.toc("leftDiv on the window, every step");
+    i_float_t maxDiff{0.0}, maxNorm{0.0};
+    for (std::size_t nEq{nWindow}; nEq <= maxEq; ++nEq)
+    {
+        maxDiff = std::max(maxDiff, maxAbsDiff(windowx[nEq], rebuildx[nEq]));
+        maxNorm = std::max(maxNorm, maxAbsDiff(rebuildx[nEq], initComplexDenseMatrix(nAnt, 1)));
+    }
+    std::cout << "window rows: " << window.count() << ", max |x_window - leftDiv| over all steps = " << maxDiff << " (max |x| = " << maxNorm << ")\n";
+}
+
+void pinvUpdateTest()
+{
+    std::cout << "\n\n******************** Incremental pseudo-inverse (column insert / remove) test ********************\n\n";
+    const auto removeCol = [](const i_complex_dense_matrix &matA, const std::size_t index) {
+        i_complex_dense_matrix resMat = initComplexDenseMatrix(matA.rows(), matA.cols() - 1);
+        for (std::size_t i{0}; i < matA.rows(); ++i)
+        {
+            for (std::size_t j{0}; j + 1 < matA.cols(); ++j)
+            {
+                resMat(i, j) = matA(i, j < index ? j : j + 1);
+            }
+        }
+        return resMat;
+    };
+    const auto column = [](const i_complex_dense_matrix &matA, const std::size_t index) {
+        i_complex_dense_matrix resMat = initComplexDenseMatrix(matA.rows(), 1);
+        for (std::size_t i{0}; i < matA.rows(); ++i)
+        {
+            resMat(i, 0) = matA(i, index);
+        }
+        return resMat;
+    };
+
+    // Small rank deficient case: Greville build, a duplicated column in & out
+    const i_complex_dense_matrix matF = toDenseMatrix(i_complex_matrix{{1.0, 2.0, 3.0}, {2.0, 5.0, 3.0}, {7.0, 4.0, 3.0}, {-6.0, 3.0, 1.0}, {3.0, 2.0, 1.0}});
+    i_complex_incremental_pinv smallPinv(matF);
+    smallPinv.appendColumn(column(matF, 1)); // Rank stays 3
+    showMatrix(toNestedMatrix(smallPinv.pinv()), "pinv([F, F(:, 2)]), incremental");
+    showMatrix(toNestedMatrix(pinv2(smallPinv.matrix())), "pinv2([F, F(:, 2)])");
+    std::cout << "rank = " << smallPinv.rank() << ", max |pinv_inc - pinv2|: duplicate column in = " << maxAbsDiff(smallPinv.pinv(), pinv2(smallPinv.matrix()));
+    smallPinv.removeColumn(0);
+    std::cout << ", first column out = " << maxAbsDiff(smallPinv.pinv(), pinv2(smallPinv.matrix()));
+    smallPinv.removeColumn(0);
+    std::cout << ", second column out (rank " << smallPinv.rank() << ") = " << maxAbsDiff(smallPinv.pinv(), pinv2(smallPinv.matrix())) << "\n";
+
+    // Antenna 5 goes offline & comes back
+    const std::size_t nAnt{64}, offline{5};
+    const i_complex_dense_matrix largeA = toDenseMatrix(genTestMatrixA(nAnt));
+    TestTimer timer;
+    timer.tic();
+    i_complex_incremental_pinv largePinv(largeA, pinv2(largeA));
+    timer.toc("pinv2, 4033 x 64");
+    timer.tic();
+    largePinv.removeColumn(offline);
+    timer.toc("remove column (antenna offline)");
+    timer.tic();
+    const i_complex_dense_matrix offlineP = pinv2(removeCol(largeA, offline));
+    timer.toc("pinv2 from scratch, 4033 x 63");
+    std::cout << "max |pinv_inc - pinv2| = " << maxAbsDiff(largePinv.pinv(), offlineP) << " (max |pinv2| = " << maxAbsDiff(offlineP, initComplexDenseMatrix(offlineP.rows(), offlineP.cols())) << ")\n";
+    timer.tic();
+    largePinv.insertColumn(offline, column(largeA, offline));
+    timer.toc("insert column (antenna back)");
+    std::cout << "rank = " << largePinv.rank() << ", max |pinv_inc - pinv2(A)| = " << maxAbsDiff(largePinv.pinv(), pinv2(largeA)) << "\n";
+}
+
+void woodburyTest()
+{
+    std::cout << "\n\n******************** Sherman-Morrison-Woodbury update test ********************\n\n";
+    const std::size_t nSize{500}, nRank{4}, nrhs{8};
+    i_complex_dense_matrix matA = initComplexDenseMatrix(nSize, nSize), matU = initComplexDenseMatrix(nSize, nRank), matV = initComplexDenseMatrix(nSize, nRank);
+    i_complex_dense_matrix matB = initComplexDenseMatrix(nSize, nrhs), matI = initComplexDenseMatrix(nSize, nSize);
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            matA(i, j) = static_cast<i_float_t>((i * 7 + j * 3) % 17) - 8.0 + (i == j ? 16.0 : 0.0);
+        }
+        for (std::size_t j{0}; j < nRank; ++j)
+        {
+            matU(i, j) = static_cast<i_float_t>((i + 3 * j) % 7) - 3.0;
+            matV(i, j) = static_cast<i_float_t>((2 * i + j) % 5) - 2.0;
+        }
+        for (std::size_t j{0}; j < nrhs; ++j)
+        {
+            matB(i, j) = static_cast<i_float_t>((i + j) % 5) - 2.0;
+        }
+        matI(i, i) = 1.0;
+    }
+    const auto lowRank = [&](const i_complex_dense_matrix &matX, const i_complex_dense_matrix &matY) {
+        i_complex_dense_matrix resMat = matMul(matX, transpose(matY));
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            for (std::size_t j{0}; j < nSize; ++j)
+            {
+                resMat(i, j) += matA(i, j);
+            }
+        }
+        return resMat;
+    };
+
+    const i_complex_dense_matrix matAinv = inv(matA);
+    const i_complex_lu_factorization factorA(matA);
+    const i_complex_dense_matrix matAnew = lowRank(matU, matV);
+    i_woodbury_info info;
+    TestTimer timer;
+    timer.tic();
+    const i_complex_dense_matrix updatedInv = woodburyInverse(matAinv, matU, matV, woodburyTolerance<i_complex_t>(), &info);
+    timer.toc("woodburyInverse, 500 x 500, rank 4");
+    timer.tic();
+    const i_complex_dense_matrix directInv = inv(matAnew);
+    timer.toc("inv on the whole matrix");
+    std::cout << "capacitance ratio = " << info.capacitanceRatio << ", refactored = " << info.refactored
+              << ", max |inv_woodbury - inv| = " << maxAbsDiff(updatedInv, directInv) << "\n";
+    timer.tic();
+    const i_complex_dense_matrix updatedX = woodburySolve(factorA, matU, matV, matB, woodburyTolerance<i_complex_t>(), &info);
+    timer.toc("woodburySolve from LU, 8 right-hand sides");
+    timer.tic();
+    const i_complex_dense_matrix directX = leftDiv(matAnew, matB);
+    timer.toc("leftDiv on the whole matrix");
+    std::cout << "max |X_woodbury - leftDiv| = " << maxAbsDiff(updatedX, directX) << "\n";
+
+    // v' * inv(A) * u close to -1: A(:, 0) scaled by 1e-10, the update cancels & falls back to refactorization
+    i_complex_dense_matrix vecU = initComplexDenseMatrix(nSize, 1), vecV = initComplexDenseMatrix(nSize, 1);
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        vecU(i, 0) = -(1.0 - 1.0e-10) * matA(i, 0);
+    }
+    vecV(0, 0) = 1.0;
+    const i_complex_dense_matrix matAcancel = lowRank(vecU, vecV);
+    const i_complex_dense_matrix cancelInv = woodburyInverse(matAinv, vecU, vecV, woodburyTolerance<i_complex_t>(), &info);
+    std::cout << "cancelling update: capacitance ratio = " << info.capacitanceRatio << ", refactored = " << info.refactored
+              << ", max |(A + u * v') * X - I| = " << maxAbsDiff(matMul(matAcancel, cancelInv), matI);
+    const i_complex_dense_matrix cancelX = woodburySolve(factorA, vecU, vecV, matB, woodburyTolerance<i_complex_t>(), &info);
+    std::cout << ", solve refactored = " << info.refactored << ", max |(A + u * v') * X - B| = " << maxAbsDiff(matMul(matAcancel, cancelX), matB) << "\n";
+}
+
+void matrixFileTest()
+{
+    std::cout << "\n\n******************** Memory-mapped matrix file test ********************\n\n";
+    const std::size_t nrows{2000}, ncols{1003}, nBlock{500}, nCov{64}, nStack{3};
+    const char *path{"matBasic_file_test.bin"};
+    i_complex_dense_matrix matG = initComplexDenseMatrix(nrows, ncols);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            matG(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j * 3) % 17) - 8.0, 0.125 * static_cast<i_float_t>(j % 3)};
+        }
+    }
+
+    TestTimer timer;
+    timer.tic();
+    const bool written{writeMatrixFile(path, matG)};
+    timer.toc("writeMatrixFile, 2000 x 1003");
+    timer.tic();
+    const i_complex_dense_matrix matRead = readMatrixFile<i_complex_t>(path);
+    timer.toc("readMatrixFile (copy)");
+    timer.tic();
+    i_complex_dense_matrix matMapped = mapMatrixFile<i_complex_t>(path);
+    timer.toc("mapMatrixFile (zero-copy)");
+    std::cout << "written = " << written << ", mapped = " << matMapped.borrowed() << ", size = " << matMapped.rows() << " x " << matMapped.cols()
+              << ", max |read - G| = " << maxAbsDiff(matRead, matG) << ", max |mapped - G| = " << maxAbsDiff(matMapped, matG) << "\n";
+    const i_complex_dense_matrix matGt = transpose(matG);
+    std::cout << "max |mapped * G' - G * G'| = " << maxAbsDiff(matMul(matMapped, matGt), matMul(matG, matGt));
+    matMapped(0, 0) = i_complex_t{1.0e6, 0.0}; // Copy-on-write page, the file keeps its value
+    std::cout << ", file after writing to the mapping: " << mapMatrixFile<i_complex_t>(path)(0, 0) << " (G(0, 0) = " << matG(0, 0) << ")\n";
+
+    // Streamed out block by block, and a stack of covariance matrices sharing one mapping
+    {
+        i_complex_matrix_file_writer writer(path, ncols);
+        for (std::size_t b{0}; b < nrows; b += nBlock)
+        {
+            i_complex_dense_matrix matBlock = initComplexDenseMatrix(nBlock, ncols);
+            for (std::size_t i{0}; i < nBlock; ++i)
+            {
+                std::copy_n(matG.row(b + i), ncols, matBlock.row(i));
+            }
+            writer.write(matBlock);
+        }
+    }
+    std::cout << "streamed in " << nrows / nBlock << " blocks: max |mapped - G| = " << maxAbsDiff(mapMatrixFile<i_complex_t>(path), matG) << "\n";
+    std::vector<i_complex_dense_matrix> covStack;
+    for (std::size_t b{0}; b < nStack; ++b)
+    {
+        i_complex_dense_matrix matR = initComplexDenseMatrix(nCov, ncols);
+        for (std::size_t i{0}; i < nCov; ++i)
+        {
+            std::copy_n(matG.row(b * nCov + i), ncols, matR.row(i));
+        }
+        covStack.push_back(matMul(matR, transpose(matR)));
+    }
+    writeMatrixFile(path, covStack);
+    std::vector<i_complex_dense_matrix> mappedStack = mapMatrixStack<i_complex_t>(path);
+    i_float_t stackDiff{0.0};
+    for (std::size_t b{0}; b < mappedStack.size(); ++b)
+    {
+        stackDiff = std::max(stackDiff, maxAbsDiff(mappedStack[b], covStack[b]));
+    }
+    const i_complex_dense_matrix lastCov = mappedStack.back();
+    mappedStack.pop_back();
+    std::cout << "stack: " << mappedStack.size() + 1 << " of " << nCov << " x " << nCov << ", max |mapped - R * R'| = " << stackDiff
+              << ", copy borrowed = " << lastCov.borrowed() << "\n";
+    const i_dense_matrix<std::complex<float>> wrongType = mapMatrixFile<std::complex<float>>(path);
+    std::cout << "wrong element type gives an empty matrix: " << wrongType.empty() << "\n";
+    {
+        // count * rows = 2^64 wraps to a zero payload size, the header must still be rejected
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        const std::uint64_t hugeShape[2]{std::uint64_t{1} << 52, std::uint64_t{1} << 12};
+        file.seekp(16);
+        file.write(reinterpret_cast<const char *>(hugeShape), sizeof(hugeShape));
+    }
+    const bool rejected{mapMatrixStack<i_complex_t>(path).empty()};
+    std::cout << "overflowing shape gives an empty stack: " << rejected << "\n";
+    std::remove(path);
+}
+
+void tsqrTest()
+{
+    std::cout << "\n\n******************** Out-of-core TSQR least squares test ********************\n\n";
+    const std::size_t nrows{400000}, ncols{32}, nrhs{2}, nBlock{20000};
+    const char *pathA{"matBasic_tsqr_A.bin"}, *pathB{"matBasic_tsqr_b.bin"};
+    // Row i of A & b, generated on demand: the whole system is never needed at once
+    const auto fillRow = [&](const std::size_t i, i_complex_t *rowA, i_complex_t *rowb) {
+        std::size_t seed{i * 2654435761u + 12345u};
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            seed = seed * 6364136223846793005u + 1442695040888963407u;
+            rowA[j] = i_complex_t{static_cast<i_float_t>(seed >> 11 & 0xfffff) / 1048576.0 - 0.5 + (i % ncols == j ? 0.5 : 0.0), static_cast<i_float_t>(seed >> 43) / 2097152.0 - 0.5};
+        }
+        for (std::size_t j{0}; j < nrhs; ++j)
+        {
+            rowb[j] = static_cast<i_float_t>(j + 1) * (rowA[j] - rowA[ncols - 1 - j]) + 1.0e-3 * static_cast<i_float_t>(static_cast<int>(seed >> 40 & 0xff) - 128) / 128.0;
+        }
+    };
+    {
+        i_complex_matrix_file_writer writerA(pathA, ncols), writerB(pathB, nrhs);
+        i_complex_dense_matrix blockA = initComplexDenseMatrix(nBlock, ncols), blockb = initComplexDenseMatrix(nBlock, nrhs);
+        for (std::size_t b{0}; b < nrows; b += nBlock)
+        {
+            for (std::size_t i{0}; i < nBlock; ++i)
+            {
+                fillRow(b + i, blockA.row(i), blockb.row(i));
+            }
+            writerA.write(blockA);
+            writerB.write(blockb);
+        }
+    }
+
+    TestTimer timer;
+    const i_complex_dense_matrix matA = readMatrixFile<i_complex_t>(pathA), matb = readMatrixFile<i_complex_t>(pathB);
+    timer.tic();
+    const i_complex_dense_matrix directX = leftDiv(matA, matb);
+    timer.toc("leftDiv in memory, 400000 x 32");
+    timer.tic();
+    const i_complex_dense_matrix fileX = tsqrLeftDiv<i_complex_t>(pathA, pathB);
+    timer.toc("tsqrLeftDiv from mapped files");
+    std::cout << "max |x_tsqr - x_leftDiv| = " << maxAbsDiff(fileX, directX) << "\n";
+
+    std::size_t nextRow{0};
+    const i_complex_row_block_source source{[&](i_complex_dense_matrix &blockA, i_complex_dense_matrix &blockb) {
+        const std::size_t nFilled{std::min(blockA.rows(), nrows - nextRow)};
+        for (std::size_t i{0}; i < nFilled; ++i)
+        {
+            fillRow(nextRow + i, blockA.row(i), blockb.row(i));
+        }
+        nextRow += nFilled;
+        return nFilled;
+    }};
+    timer.tic();
+    const StreamingLeastSquares<i_complex_t> factor = tsqrFactor<i_complex_t>(ncols, nrhs, source, 5000);
+    timer.toc("tsqrFactor from a callback, blocks of 5000 rows");
+    i_float_t residual{0.0};
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        for (std::size_t j{0}; j < nrhs; ++j)
+        {
+            i_complex_t value{-matb(i, j)};
+            for (std::size_t k{0}; k < ncols; ++k)
+            {
+                value += matA(i, k) * directX(k, j);
+            }
+            residual += std::norm(value);
+        }
+    }
+    std::cout << "rows = " << factor.count() << ", max |x_callback - x_leftDiv| = " << maxAbsDiff(factor.solve(), directX)
+              << ", residual sum of squares = " << factor.residualNorm2()[0] + factor.residualNorm2()[1] << " (direct " << residual << ")\n";
+    std::remove(pathA);
+    std::remove(pathB);
+}
+
+void outOfCoreMatMulTest()
+{
+    std::cout << "\n\n******************** Out-of-core tiled matMul test ********************\n\n";
+    const std::size_t nrows{1500}, depth{1300}, ncols{1100};
+    const char *pathA{"matBasic_ooc_A.bin"}, *pathB{"matBasic_ooc_B.bin"}, *pathC{"matBasic_ooc_C.bin"};
+    i_complex_dense_matrix matA = initComplexDenseMatrix(nrows, depth), matB = initComplexDenseMatrix(depth, ncols);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        for (std::size_t j{0}; j < depth; ++j)
+        {
+            matA(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j * 3) % 17) - 8.0, static_cast<i_float_t>((i + j) % 5) - 2.0};
+        }
+    }
+    for (std::size_t i{0}; i < depth; ++i)
+    {
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            matB(i, j) = i_complex_t{static_cast<i_float_t>((i * 5 + j * 11) % 13) - 6.0, static_cast<i_float_t>((2 * i + j) % 7) - 3.0};
+        }
+    }
+    writeMatrixFile(pathA, matA);
+    writeMatrixFile(pathB, matB);
+
+    TestTimer timer;
+    timer.tic();
+    const i_complex_dense_matrix directC = matMul(matA, matB);
+    timer.toc("matMul in memory, 1500 x 1300 x 1100");
+    timer.tic();
+    const bool done{matMulFile<i_complex_t>(pathA, pathB, pathC, 5 * 512 * 512 * sizeof(i_complex_t))};
+    timer.toc("matMulFile, 512 x 512 tiles (27 steps)");
+    i_matrix_file_header header;
+    readMatrixFileHeader(pathC, header);
+    std::cout << "done = " << done << ", C file: " << header.rows << " x " << header.cols
+              << ", max |C_file - C| = " << maxAbsDiff(readMatrixFile<i_complex_t>(pathC), directC) << "\n";
+
+    // Mapped operands, result in memory, the default budget is a single tile here
+    i_complex_dense_matrix tiledC = initComplexDenseMatrix(nrows, ncols);
+    matMulTiled(mapMatrixFile<i_complex_t>(pathA), mapMatrixFile<i_complex_t>(pathB), tiledC);
+    std::cout << "matMulTiled, default budget: max |C_tiled - C| = " << maxAbsDiff(tiledC, directC) << "\n";
+    const bool smallBudget{matMulTiled(mapMatrixFile<i_complex_t>(pathA), mapMatrixFile<i_complex_t>(pathB), tiledC, std::size_t{1} << 20)};
+    std::cout << "1 MB budget (below 5 tiles of 256 x 256) accepted: " << smallBudget << "\n";
+    std::remove(pathA);
+    std::remove(pathB);
+    std::remove(pathC);
+}
+
+void textIOTest()
+{
+    std::cout << "\n\n******************** Fast text import / export test ********************\n\n";
+    const auto sameBits = [](const i_complex_dense_matrix &matX, const i_complex_dense_matrix &matY) {
+        if (matX.rows() != matY.rows() || matX.cols() != matY.cols())
+        {
+            return false;
+        }
+        for (std::size_t i{0}; i < matX.rows(); ++i)
+        {
+            if (std::memcmp(matX.row(i), matY.row(i), matX.cols() * sizeof(i_complex_t)) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    const std::size_t nSize{1000};
+    const char *path{"matBasic_text_test.m"};
+    i_complex_dense_matrix matG = initComplexDenseMatrix(nSize, nSize);
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            matG(i, j) = std::polar(std::pow(10.0, static_cast<i_float_t>(static_cast<int>(j % 9) - 4)), static_cast<i_float_t>(i * nSize + j));
+        }
+    }
+
+    TestTimer timer;
+    timer.tic();
+    {
+        std::ofstream file(path);
+        file.precision(17);
+        file << "matG = [";
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            for (std::size_t j{0}; j < nSize; ++j)
+            {
+                file << matG(i, j) << (j + 1 < nSize ? ", " : ";\n");
+            }
+        }
+        file << "];\n";
+    }
+    timer.toc("operator<< per element, 1000 x 1000, 17 digits");
+    timer.tic();
+    writeMatrixText(path, matG, i_text_format::matlab, "matG");
+    timer.toc("writeMatrixText, MATLAB");
+    timer.tic();
+    const i_complex_dense_matrix matlabG = readMatrixText<i_complex_t>(path);
+    timer.toc("readMatrixText, MATLAB");
+    writeMatrixText(path, matG, i_text_format::csv);
+    const i_complex_dense_matrix csvG = readMatrixText<i_complex_t>(path);
+    std::cout << "exact round trip: MATLAB = " << sameBits(matlabG, matG) << ", CSV = " << sameBits(csvG, matG) << "\n";
+
+    // Special values, hand-written text & errors
+    i_complex_dense_matrix matS = initComplexDenseMatrix(1, 4);
+    matS(0, 0) = i_complex_t{-std::numeric_limits<i_float_t>::infinity(), 1.0};
+    matS(0, 1) = i_complex_t{0.0, std::numeric_limits<i_float_t>::quiet_NaN()};
+    matS(0, 2) = i_complex_t{-0.0, -0.0};
+    matS(0, 3) = i_complex_t{5e-324, 0.1};
+    writeMatrixText(std::cout, matS, i_text_format::matlab, "matS");
+    writeMatrixText(path, matS, i_text_format::csv);
+    const i_complex_dense_matrix readS = readMatrixText<i_complex_t>(path);
+    std::cout << "special values read back: " << (readS.cols() == 4 && std::isinf(std::abs(readS(0, 0))) && std::isnan(std::abs(readS(0, 1)))
+                                                  && sameBits(parseMatrixText<i_complex_t>("[" + std::string("-inf+1i nani -0-0i 4.9406564584124654e-324+0.1j") + "]"), readS)) << "\n";
+    showMatrix(parseMatrixText<i_complex_t>("A = [1 2.5i, -3-1i % first row\n     4e-2 +5+0.5i 6];"), "hand-written", true);
+    const bool raggedEmpty{parseMatrixText<i_complex_t>("[1, 2; 3]").empty()};
+    std::cout << "ragged rows give an empty matrix: " << raggedEmpty << "\n";
+    const bool trailingEmpty{parseMatrixText<i_complex_t>("A = [1 2]; B = [3 4];").empty()};
+    std::cout << "second matrix after ']' gives an empty matrix: " << trailingEmpty
+              << ", comment after ']' accepted: " << parseMatrixText<i_complex_t>("[1 2]; % done\n").cols() << " columns\n";
+    std::remove(path);
+}
+
+void npyTest()
+{
+    std::cout << "\n\n******************** NumPy .npy / .npz test ********************\n\n";
+    // A file as another NumPy build might write it: dict header & raw bytes given by hand
+    const auto writeRawNpy = [](const char *path, std::string dict, const std::string &bytes) {
+        dict.append(63 - (dict.size() + 10) % 64, ' ');
+        dict.push_back('\n');
+        std::ofstream file(path, std::ios::binary);
+        file << "\x93NUMPY\x01" << '\0' << static_cast<char>(dict.size() & 0xff) << static_cast<char>(dict.size() >> 8) << dict << bytes;
+    };
+    const std::size_t nrows{2000}, ncols{1024};
+    const char *path{"matBasic_npy_test.npy"}, *pathZ{"matBasic_npy_test.npz"};
+    i_complex_dense_matrix matG = initComplexDenseMatrix(nrows, ncols), matOdd = initComplexDenseMatrix(7, 5);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            matG(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j * 3) % 17) - 8.0, 0.125 * static_cast<i_float_t>(j % 3)};
+        }
+    }
+    for (std::size_t i{0}; i < 7; ++i)
+    {
+        for (std::size_t j{0}; j < 5; ++j)
+        {
+            matOdd(i, j) = matG(i, j);
+        }
+    }
+
+    TestTimer timer;
+    timer.tic();
+    writeNpy(path, matG);
+    timer.toc("writeNpy, 2000 x 1024");
+    timer.tic();
+    const i_complex_dense_matrix readG = readNpy<i_complex_t>(path);
+    timer.toc("readNpy (copy)");
+    timer.tic();
+    const i_complex_dense_matrix mappedG = mapNpy<i_complex_t>(path);
+    timer.toc("mapNpy (zero-copy)");
+    std::cout << "mapped = " << mappedG.borrowed() << ", max |read - G| = " << maxAbsDiff(readG, matG) << ", max |mapped - G| = " << maxAbsDiff(mappedG, matG) << "\n";
+    writeNpy(path, matOdd);
+    const i_complex_dense_matrix mappedOdd = mapNpy<i_complex_t>(path);
+    std::cout << "7 x 5 (rows not 64-byte aligned): mapped = " << mappedOdd.borrowed() << ", max |mapped - G| = " << maxAbsDiff(mappedOdd, matOdd) << "\n";
+
+    std::map<std::string, i_complex_dense_matrix> arrays{{"G", matG}, {"odd", matOdd}};
+    writeNpz(pathZ, arrays);
+    std::map<std::string, i_complex_dense_matrix> mappedZ = mapNpz<i_complex_t>(pathZ);
+    std::cout << "npz: " << mappedZ.size() << " arrays, G mapped = " << mappedZ["G"].borrowed() << ", max |G| diff = " << maxAbsDiff(mappedZ["G"], matG)
+              << ", max |odd| diff = " << maxAbsDiff(mappedZ["odd"], matOdd) << "\n";
+
+    // Fortran order, other element type & byte order, 1-D shape
+    writeRawNpy(path, "{'descr': '<c8', 'fortran_order': True, 'shape': (2, 2), }", std::string("\x00\x00\x80\x3f\x00\x00\x80\xbf\x00\x00\x40\x40\x00\x00\x00\x3f\x00\x00\x00\x40\x00\x00\x00\x00\x00\x00\x80\x40\x00\x00\x00\xc0", 32));
+    showMatrix(readNpy<i_complex_t>(path), "complex64 Fortran order", true);
+    writeRawNpy(path, "{'descr': '>f8', 'fortran_order': False, 'shape': (2,), }", std::string("\x3f\xf8\0\0\0\0\0\0\xc0\x04\0\0\0\0\0\0", 16));
+    showMatrix(readNpy<i_complex_t>(path), "big endian float64, shape (2,)", true);
+    writeRawNpy(path, "{'descr': '<c16', 'fortran_order': False, 'shape': (4611686018427387904, 4), }", std::string(16, '\0'));
+    const bool overflowRefused{readNpy<i_complex_t>(path).empty()}; // 2^62 * 4 elements wrap the byte count around to 0
+    std::cout << "overflowing shape gives an empty matrix: " << overflowRefused << "\n";
+    writeRawNpy(path, "{'descr': '<c16', 'fortran_order': False, 'shape': (99999999999999999999999, 3), }", std::string(16, '\0'));
+    const bool hugeRefused{readNpy<i_complex_t>(path).empty()};
+    std::cout << "dimension above 2^64 gives an empty matrix: " << hugeRefused << "\n";
+    {
+        // First central directory record claims a 60000-byte name, far past the end of the directory
+        writeNpz(pathZ, arrays);
+        std::fstream file(pathZ, std::ios::in | std::ios::out | std::ios::binary);
+        unsigned char dirOffset[4]{};
+        file.seekg(-6, std::ios::end);
+        file.read(reinterpret_cast<char *>(dirOffset), 4);
+        file.seekp(static_cast<std::streamoff>(dirOffset[0] | dirOffset[1] << 8 | dirOffset[2] << 16 | static_cast<std::uint32_t>(dirOffset[3]) << 24) + 28);
+        file.write("\x60\xea", 2);
+    }
+    const bool damagedRefused{mapNpz<i_complex_t>(pathZ).empty()};
+    std::cout << "damaged zip directory gives no arrays: " << damagedRefused << "\n";
+    std::remove(path);
+    std::remove(pathZ);
+}
+
+void mixedPrecisionTest()
+{
+    std::cout << "\n\n******************** Mixed precision test ********************\n\n";
+    const std::size_t nSize{600}, nrows{2000}, ncols{100};
+    i_complex_dense_matrix matA = initComplexDenseMatrix(nSize, nSize);
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            matA(i, j) = i_complex_t{static_cast<i_float_t>((i * 7 + j) % 13) - 6.0, static_cast<i_float_t>((i + 3 * j) % 5)};
+        }
+    }
+    const i_dense_matrix<std::complex<float>> matA32 = castMatrix<std::complex<float>>(matA);
+
+    // Small integers: float & double products are exact, on every instruction set
+    const i_simd_level detected{simdLevel()};
+    TestTimer timer;
+    timer.tic();
+    const i_complex_dense_matrix matC = matMul(matA, transpose(matA));
+    timer.toc("complex double matMul, 600 x 600");
+    for (int level{static_cast<int>(detected)}; level >= 0; --level)
+    {
+        setSimdLevel(static_cast<i_simd_level>(level));
+        const std::string info{std::string("complex float matMul, ") + simdLevelName(simdLevel())};
+        timer.tic();
+        const i_dense_matrix<std::complex<float>> matC32 = matMul(matA32, transpose(matA32));
+        timer.toc(info.c_str());
+        std::cout << "max |C_float - C_double| = " << maxAbsDiff(castMatrix<i_complex_t>(matC32), matC) << "\n";
+    }
+    setSimdLevel(detected);
+
+    // Signal chain: the data is produced in float, the final solve runs in double
+    i_complex_dense_matrix matX(ncols, 1);
+    i_dense_matrix<std::complex<float>> matG32(nrows, ncols);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            const double phase{0.7 * static_cast<double>(i) + 1.3 * static_cast<double>(j) + 0.01 * static_cast<double>(i * j)};
+            matG32(i, j) = std::complex<float>{static_cast<float>(std::sin(phase)), static_cast<float>(std::cos(1.7 * phase))};
+        }
+    }
+    for (std::size_t j{0}; j < ncols; ++j)
+    {
+        matX(j, 0) = i_complex_t{1.0 + static_cast<i_float_t>(j) / static_cast<i_float_t>(ncols), -0.5};
+    }
+    const i_complex_dense_matrix matG = castMatrix<i_complex_t>(matG32), matb = matMul(matG, matX);
+    const i_dense_matrix<std::complex<float>> matb32 = castMatrix<std::complex<float>>(matb);
+    timer.tic();
+    const i_dense_matrix<std::complex<float>> matX32 = leftDiv(matG32, matb32);
+    timer.toc("complex float leftDiv, 2000 x 100");
+    timer.tic();
+    const i_complex_dense_matrix matX64 = leftDiv(castMatrix<i_complex_t>(matG32), castMatrix<i_complex_t>(matb32));
+    timer.toc("double leftDiv on the float data");
+    std::cout << "max |x - x_true|: float solve " << maxAbsDiff(castMatrix<i_complex_t>(matX32), matX) << ", double solve " << maxAbsDiff(matX64, matX) << "\n";
+
+    // Rank decisions use defaultTolerance<std::complex<float>>() = 1e-4
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        matG32(i, ncols - 1) = matG32(i, 0) + matG32(i, 1);
+    }
+    const i_dense_matrix<std::complex<float>> matP32 = pinv2(matG32);
+    std::cout << "rank-deficient G: rank in complex float = " << rank(matG32) << ", in double = " << rank(castMatrix<i_complex_t>(matG32))
+              << ", max |G * pinv2(G) * G - G| in complex float = " << maxAbsDiff(castMatrix<i_complex_t>(matMul(matMul(matG32, matP32), matG32)), castMatrix<i_complex_t>(matG32)) << "\n";
+    i_dense_matrix<std::complex<float>> matS32(3, 3);
+    matS32(0, 0) = {4.0f, 1.0f}, matS32(0, 1) = 1.0f, matS32(1, 0) = {0.0f, 2.0f}, matS32(1, 1) = 3.0f, matS32(2, 2) = 0.5f;
+    std::cout << "det in complex float = " << det(matS32) << "\n";
+    showMatrix(inv(matS32), "inv in complex float");
+}
+
 int main(int argc, char **argv)
 {
     pinvTest(true);
     determinantTest();
+    denseMatrixTest();
+    simdKernelTest();
+    splitComplexTest();
+    luFactorizationTest();
+    leftDivTest();
+    qrLeastSquaresTest();
+    gramKernelTest();
+    threadPoolTest();
+    taskGraphTest();
+    sparseTest();
+    iterativeSolverTest();
+    sparseCholeskyTest();
+    batchTest();
+    fixedMatrixTest();
+    streamingLeastSquaresTest();
+    slidingWindowTest();
+    pinvUpdateTest();
+    woodburyTest();
+    matrixFileTest();
+    tsqrTest();
+    outOfCoreMatMulTest();
+    textIOTest();
+    npyTest();
+    mixedPrecisionTest();
     std::cin.get();
     return 0;
 }
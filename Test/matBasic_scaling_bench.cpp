@@ -0,0 +1,83 @@
+#include <cstdlib>
+#include <vector>
+#include "matBasic_real.hpp"
+#include "matBasic_testUtil.hpp"
+
+// Thread scaling of the task-graph factorizations:
+//     matBasic_scaling_bench [maxThreads] [size ...]
+// defaults: every power of two up to the hardware thread count (plus that count), sizes 1000 2000 4000 8000
+
+i_real_dense_matrix genBenchMatrix(const std::size_t nSize)
+{
+    i_real_dense_matrix matG = initRealDenseMatrix(nSize, nSize);
+    std::size_t seed{12345};
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            seed = seed * 6364136223846793005u + 1442695040888963407u; // 64-bit LCG, no <random> needed
+            matG(i, j) = static_cast<i_float_t>(seed >> 11) / 9007199254740992.0 - 0.5 + (i == j ? 1.0 : 0.0);
+        }
+    }
+    return matG;
+}
+
+void scalingBench(const std::size_t nSize, const std::vector<std::size_t> &threadCounts)
+{
+    std::cout << "\n\n******************** Scaling benchmark, " << nSize << " x " << nSize << " ********************\n\n";
+    const i_real_dense_matrix matG = genBenchMatrix(nSize);
+    i_real_dense_matrix matSpd = initRealDenseMatrix(nSize, nSize);
+    i_kernel::herk(nSize, nSize, matG.data(), matG.stride(), true, matSpd.data(), matSpd.stride()); // G' * G, lower triangle
+    const double nd{static_cast<double>(nSize)};
+    const double cholFlops{nd * nd * nd / 3.0}, luFlops{2.0 * nd * nd * nd / 3.0};
+
+    double cholSerial{0.0}, luSerial{0.0};
+    for (const std::size_t nthreads : threadCounts)
+    {
+        setThreadCount(nthreads);
+        TestTimer timer;
+        timer.tic();
+        const i_real_cholesky_factorization factorSpd(matSpd);
+        const double cholTime{timer.toc()};
+        timer.tic();
+        const i_real_lu_factorization factorG(matG);
+        const double luTime{timer.toc()};
+        if (nthreads == threadCounts.front())
+        {
+            cholSerial = cholTime;
+            luSerial = luTime;
+        }
+        std::cout << "threads = " << nthreads
+                  << " | Cholesky: " << cholTime * 1000.0 << " ms, " << cholFlops / cholTime * 1.0e-9 << " GFLOP/s, speedup " << cholSerial / cholTime
+                  << " | LU: " << luTime * 1000.0 << " ms, " << luFlops / luTime * 1.0e-9 << " GFLOP/s, speedup " << luSerial / luTime
+                  << (factorSpd.positiveDefinite() && !factorG.singular() ? "" : " (factorization failed)") << "\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t hardwareThreads{threadCount()};
+    const std::size_t maxThreads{argc > 1 ? static_cast<std::size_t>(std::strtoul(argv[1], nullptr, 10)) : hardwareThreads};
+    std::vector<std::size_t> threadCounts;
+    for (std::size_t nthreads{1}; nthreads < maxThreads; nthreads *= 2)
+    {
+        threadCounts.push_back(nthreads);
+    }
+    threadCounts.push_back(std::max<std::size_t>(1, maxThreads));
+
+    std::vector<std::size_t> sizes;
+    for (int i{2}; i < argc; ++i)
+    {
+        sizes.push_back(static_cast<std::size_t>(std::strtoul(argv[i], nullptr, 10)));
+    }
+    if (sizes.empty())
+    {
+        sizes = {1000, 2000, 4000, 8000};
+    }
+    for (const std::size_t nSize : sizes)
+    {
+        scalingBench(nSize, threadCounts);
+    }
+    setThreadCount(hardwareThreads);
+    return 0;
+}
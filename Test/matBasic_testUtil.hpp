@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
 #include <sys/time.h> // Performance test timer
 
@@ -57,3 +60,18 @@ private:
 
     bool m_running{false};
 };
+
+// Largest |X(i, j) - Y(i, j)| of two matrices (rows(), cols(), operator()), huge when the sizes differ
+template <typename M>
+double maxAbsDiff(const M &matX, const M &matY)
+{
+    double maxDiff{matX.rows() == matY.rows() && matX.cols() == matY.cols() ? 0.0 : 1.0e300};
+    for (std::size_t i{0}; i < std::min(matX.rows(), matY.rows()); ++i)
+    {
+        for (std::size_t j{0}; j < std::min(matX.cols(), matY.cols()); ++j)
+        {
+            maxDiff = std::max(maxDiff, static_cast<double>(std::abs(matX(i, j) - matY(i, j))));
+        }
+    }
+    return maxDiff;
+}
@@ -0,0 +1,499 @@
+#pragma once
+/*
+Mini Matrix Tools - Batched Small-Matrix det / inv / leftDiv
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+Thousands of same-sized small matrices (e.g. one 4 x 4 per subcarrier) stored lane by lane: element (i, j) of every
+matrix in the batch is one contiguous, aligned plane, so matrix b is lane b of every plane. Complex batches keep the
+real & imaginary parts in separate planes (split complex, see matBasic_split.hpp).
+Every kernel works on blocks of i_batch_lanes matrices at once: each scalar step of a partial pivoting LU becomes one
+SIMD instruction over the lanes. Pivot search & row swaps are per lane, done with compares & selects instead of
+branches. The block kernel is compiled for AVX2 / AVX-512 as well and picked at run time (see matBasic_simd.hpp),
+and the blocks of a large batch are spread over the thread pool (see matBasic_thread.hpp).
+
+Main Function List:
+[1] i_matrix_batch:   count matrices of rows x cols, get / set / matrix / setMatrix per matrix
+[2] toMatrixBatch:    std::vector<i_dense_matrix<T>> -> i_matrix_batch<T>
+[3] det:              Determinant of every matrix
+[4] inv:              Inverse of every matrix (singular ones give a zero matrix & a warning)
+[5] leftDiv:          X(b) = A(b) \ B(b) for square A(b), any number of right-hand sides
+*/
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_simd.hpp"
+#include "matBasic_thread.hpp"
+
+constexpr std::size_t i_batch_lanes{8}; // Matrices per block: one AVX-512 register of doubles, two AVX2 ones
+
+#if defined(__clang__)
+#define I_LANE_LOOP _Pragma("clang loop vectorize(assume_safety)") // Lanes of different planes never alias
+#elif defined(__GNUC__)
+#define I_LANE_LOOP _Pragma("GCC ivdep")
+#else
+#define I_LANE_LOOP
+#endif
+
+template <typename T>
+class i_matrix_batch
+{
+public:
+    using real_t = typename i_real_type<T>::type;
+    static constexpr bool isComplex{!std::is_same<T, real_t>::value};
+
+    i_matrix_batch() = default;
+
+    i_matrix_batch(const std::size_t count, const std::size_t nrows, const std::size_t ncols)
+        : m_count{count}, m_rows{nrows}, m_cols{ncols}, m_stride{(count + i_batch_lanes - 1) / i_batch_lanes * i_batch_lanes},
+          m_re(nrows * ncols * m_stride, real_t{0}), m_im(isComplex ? nrows * ncols * m_stride : 0, real_t{0})
+    {
+    }
+
+    std::size_t count() const { return m_count; }
+    std::size_t rows() const { return m_rows; }
+    std::size_t cols() const { return m_cols; }
+    std::size_t stride() const { return m_stride; } // Distance between two planes, count rounded up to whole blocks
+    bool empty() const { return m_count == 0 || m_rows == 0 || m_cols == 0; }
+
+    // Plane of element (i, j): lane b is matrix b. The imaginary plane is nullptr for a real batch
+    real_t *realPlane(const std::size_t i, const std::size_t j) { return m_re.data() + (i * m_cols + j) * m_stride; }
+    const real_t *realPlane(const std::size_t i, const std::size_t j) const { return m_re.data() + (i * m_cols + j) * m_stride; }
+    real_t *imagPlane(const std::size_t i, const std::size_t j) { return isComplex ? m_im.data() + (i * m_cols + j) * m_stride : nullptr; }
+    const real_t *imagPlane(const std::size_t i, const std::size_t j) const { return isComplex ? m_im.data() + (i * m_cols + j) * m_stride : nullptr; }
+
+    T get(const std::size_t b, const std::size_t i, const std::size_t j) const
+    {
+        const std::size_t offset{(i * m_cols + j) * m_stride + b};
+        if constexpr (isComplex)
+        {
+            return {m_re[offset], m_im[offset]};
+        }
+        else
+        {
+            return m_re[offset];
+        }
+    }
+
+    void set(const std::size_t b, const std::size_t i, const std::size_t j, const T value)
+    {
+        const std::size_t offset{(i * m_cols + j) * m_stride + b};
+        m_re[offset] = std::real(value);
+        if constexpr (isComplex)
+        {
+            m_im[offset] = std::imag(value);
+        }
+    }
+
+    i_dense_matrix<T> matrix(const std::size_t b) const
+    {
+        i_dense_matrix<T> resMat(m_rows, m_cols);
+        for (std::size_t i{0}; i < m_rows; ++i)
+        {
+            for (std::size_t j{0}; j < m_cols; ++j)
+            {
+                resMat(i, j) = get(b, i, j);
+            }
+        }
+        return resMat;
+    }
+
+    void setMatrix(const std::size_t b, const i_dense_matrix<T> &matA)
+    {
+        if (matA.rows() != m_rows || matA.cols() != m_cols)
+        {
+            std::cout << "Error when using i_matrix_batch::setMatrix: dimension not match.\n";
+            return;
+        }
+        for (std::size_t i{0}; i < m_rows; ++i)
+        {
+            for (std::size_t j{0}; j < m_cols; ++j)
+            {
+                set(b, i, j, matA(i, j));
+            }
+        }
+    }
+
+private:
+    std::size_t m_count{0};
+    std::size_t m_rows{0};
+    std::size_t m_cols{0};
+    std::size_t m_stride{0};
+    i_aligned_vector<real_t> m_re;
+    i_aligned_vector<real_t> m_im;
+};
+
+template <typename T>
+i_matrix_batch<T> toMatrixBatch(const std::vector<i_dense_matrix<T>> &matrices)
+{
+    i_matrix_batch<T> resBatch;
+    if (matrices.empty())
+    {
+        return resBatch;
+    }
+    resBatch = i_matrix_batch<T>(matrices.size(), matrices.front().rows(), matrices.front().cols());
+    for (std::size_t b{0}; b < matrices.size(); ++b)
+    {
+        resBatch.setMatrix(b, matrices[b]);
+    }
+    return resBatch;
+}
+
+namespace i_kernel
+{
+    // One block of i_batch_lanes matrices: A (n x n, planes aRe / aIm) is reduced to U by partial pivoting LU, the same
+    // row operations are applied to B (n x m), then B is overwritten by U \ B. det gets the determinant of every lane,
+    // singular gets 1 for a lane with a zero pivot (its B is left as is, the caller clears it).
+    // Plane (i, j) of A starts at a + (i * n + j) * stride, of B at b + (i * m + j) * stride; im pointers are unused for real data.
+    // work: 2 * n * i_batch_lanes reals
+    template <typename R, bool isComplex>
+    void batchLuBlock(const std::size_t n, const std::size_t m, const std::size_t stride, R *aRe, R *aIm, R *bRe, R *bIm,
+                      R *detRe, R *detIm, R *singular, R *work)
+    {
+        constexpr std::size_t W{i_batch_lanes};
+        R pivRe[W], pivIm[W], maxAbs[W], pivRow[W], recRe[W], recIm[W], fRe[W], fIm[W];
+        const auto planeA = [aRe, aIm, n, stride](const std::size_t i, const std::size_t j, const bool imag) {
+            return (imag ? aIm : aRe) + (i * n + j) * stride;
+        };
+        const auto planeB = [bRe, bIm, m, stride](const std::size_t i, const std::size_t j, const bool imag) {
+            return (imag ? bIm : bRe) + (i * m + j) * stride;
+        };
+        // Swap row k & row r of one plane pair where pivRow == r, as selects over the lanes
+        const auto swapRows = [&pivRow](R *rowK, R *rowR, const R r) {
+            I_LANE_LOOP
+            for (std::size_t l{0}; l < W; ++l)
+            {
+                const R valueK{rowK[l]}, valueR{rowR[l]};
+                const bool take{pivRow[l] == r};
+                rowK[l] = take ? valueR : valueK;
+                rowR[l] = take ? valueK : valueR;
+            }
+        };
+        // y -= f * x over the lanes (complex: split multiply-adds)
+        const auto updateRow = [&fRe, &fIm](R *yRe, R *yIm, const R *xRe, const R *xIm) {
+            if constexpr (isComplex)
+            {
+                I_LANE_LOOP
+                for (std::size_t l{0}; l < W; ++l)
+                {
+                    const R valRe{xRe[l]}, valIm{xIm[l]};
+                    yRe[l] -= fRe[l] * valRe - fIm[l] * valIm;
+                    yIm[l] -= fRe[l] * valIm + fIm[l] * valRe;
+                }
+                return;
+            }
+            I_LANE_LOOP
+            for (std::size_t l{0}; l < W; ++l)
+            {
+                yRe[l] -= fRe[l] * xRe[l];
+            }
+        };
+        // x *= f over the lanes
+        const auto scaleRow = [&fRe, &fIm](R *xRe, R *xIm) {
+            if constexpr (isComplex)
+            {
+                I_LANE_LOOP
+                for (std::size_t l{0}; l < W; ++l)
+                {
+                    const R valRe{xRe[l]}, valIm{xIm[l]};
+                    xRe[l] = fRe[l] * valRe - fIm[l] * valIm;
+                    xIm[l] = fRe[l] * valIm + fIm[l] * valRe;
+                }
+                return;
+            }
+            I_LANE_LOOP
+            for (std::size_t l{0}; l < W; ++l)
+            {
+                xRe[l] *= fRe[l];
+            }
+        };
+
+        R *reciprocal{work}; // 1 / U(k, k), kept for the back substitution
+        I_LANE_LOOP
+        for (std::size_t l{0}; l < W; ++l)
+        {
+            detRe[l] = R{1};
+            detIm[l] = R{0};
+            singular[l] = R{0};
+        }
+
+        // ******************** Step 1: partial pivoting LU, row operations applied to B as well ********************
+        for (std::size_t k{0}; k < n; ++k)
+        {
+            // Pivot: largest |re| + |im| in column k, per lane
+            {
+                const R *colRe{planeA(k, k, false)}, *colIm{isComplex ? planeA(k, k, true) : colRe};
+                I_LANE_LOOP
+                for (std::size_t l{0}; l < W; ++l)
+                {
+                    maxAbs[l] = std::abs(colRe[l]) + (isComplex ? std::abs(colIm[l]) : R{0});
+                    pivRow[l] = static_cast<R>(k);
+                }
+            }
+            for (std::size_t i{k + 1}; i < n; ++i)
+            {
+                const R *colRe{planeA(i, k, false)}, *colIm{isComplex ? planeA(i, k, true) : colRe};
+                const R rowIndex{static_cast<R>(i)};
+                I_LANE_LOOP
+                for (std::size_t l{0}; l < W; ++l)
+                {
+                    const R value{std::abs(colRe[l]) + (isComplex ? std::abs(colIm[l]) : R{0})};
+                    const bool larger{value > maxAbs[l]};
+                    maxAbs[l] = larger ? value : maxAbs[l];
+                    pivRow[l] = larger ? rowIndex : pivRow[l];
+                }
+            }
+            for (std::size_t i{k + 1}; i < n; ++i)
+            {
+                const R rowIndex{static_cast<R>(i)};
+                for (std::size_t j{k}; j < n; ++j)
+                {
+                    swapRows(planeA(k, j, false), planeA(i, j, false), rowIndex);
+                    if constexpr (isComplex)
+                    {
+                        swapRows(planeA(k, j, true), planeA(i, j, true), rowIndex);
+                    }
+                }
+                for (std::size_t j{0}; j < m; ++j)
+                {
+                    swapRows(planeB(k, j, false), planeB(i, j, false), rowIndex);
+                    if constexpr (isComplex)
+                    {
+                        swapRows(planeB(k, j, true), planeB(i, j, true), rowIndex);
+                    }
+                }
+            }
+
+            // det *= (swapped ? -1 : 1) * U(k, k); 1 / U(k, k), 0 for a singular lane so that it stays finite
+            {
+                const R *diagRe{planeA(k, k, false)}, *diagIm{isComplex ? planeA(k, k, true) : diagRe};
+                const R kIndex{static_cast<R>(k)};
+                R *rRe{reciprocal + k * W}, *rIm{reciprocal + (n + k) * W};
+                I_LANE_LOOP
+                for (std::size_t l{0}; l < W; ++l)
+                {
+                    pivRe[l] = diagRe[l];
+                    pivIm[l] = isComplex ? diagIm[l] : R{0};
+                    const R sign{pivRow[l] == kIndex ? R{1} : R{-1}};
+                    const R newRe{detRe[l] * pivRe[l] - detIm[l] * pivIm[l]}, newIm{detRe[l] * pivIm[l] + detIm[l] * pivRe[l]};
+                    detRe[l] = sign * newRe;
+                    detIm[l] = sign * newIm;
+                    const bool zero{maxAbs[l] == R{0}};
+                    singular[l] = zero ? R{1} : singular[l];
+                    const R norm{zero ? R{1} : pivRe[l] * pivRe[l] + pivIm[l] * pivIm[l]};
+                    recRe[l] = zero ? R{0} : pivRe[l] / norm;
+                    recIm[l] = zero ? R{0} : -pivIm[l] / norm;
+                    rRe[l] = recRe[l];
+                    rIm[l] = recIm[l];
+                }
+            }
+
+            for (std::size_t i{k + 1}; i < n; ++i)
+            {
+                // f = A(i, k) / U(k, k)
+                {
+                    const R *colRe{planeA(i, k, false)}, *colIm{isComplex ? planeA(i, k, true) : colRe};
+                    I_LANE_LOOP
+                    for (std::size_t l{0}; l < W; ++l)
+                    {
+                        const R valRe{colRe[l]}, valIm{isComplex ? colIm[l] : R{0}};
+                        fRe[l] = valRe * recRe[l] - valIm * recIm[l];
+                        fIm[l] = valRe * recIm[l] + valIm * recRe[l];
+                    }
+                }
+                for (std::size_t j{k + 1}; j < n; ++j)
+                {
+                    updateRow(planeA(i, j, false), isComplex ? planeA(i, j, true) : nullptr, planeA(k, j, false), isComplex ? planeA(k, j, true) : nullptr);
+                }
+                for (std::size_t j{0}; j < m; ++j)
+                {
+                    updateRow(planeB(i, j, false), isComplex ? planeB(i, j, true) : nullptr, planeB(k, j, false), isComplex ? planeB(k, j, true) : nullptr);
+                }
+            }
+        }
+
+        // ******************** Step 2: back substitution B = U \ B, bottom row first ********************
+        for (std::size_t ii{n}; ii > 0; --ii)
+        {
+            const std::size_t i{ii - 1};
+            for (std::size_t q{i + 1}; q < n; ++q)
+            {
+                const R *uRe{planeA(i, q, false)}, *uIm{isComplex ? planeA(i, q, true) : uRe};
+                I_LANE_LOOP
+                for (std::size_t l{0}; l < W; ++l)
+                {
+                    fRe[l] = uRe[l];
+                    fIm[l] = isComplex ? uIm[l] : R{0};
+                }
+                for (std::size_t j{0}; j < m; ++j)
+                {
+                    updateRow(planeB(i, j, false), isComplex ? planeB(i, j, true) : nullptr, planeB(q, j, false), isComplex ? planeB(q, j, true) : nullptr);
+                }
+            }
+            std::copy_n(reciprocal + i * W, W, fRe);
+            std::copy_n(reciprocal + (n + i) * W, W, fIm);
+            for (std::size_t j{0}; j < m; ++j)
+            {
+                scaleRow(planeB(i, j, false), isComplex ? planeB(i, j, true) : nullptr);
+            }
+        }
+    }
+
+#if I_SIMD_X86
+    // Same kernel compiled for wider registers: flatten inlines the portable code, which is then vectorized over the lanes
+    template <typename R, bool isComplex>
+    I_TARGET_AVX2 __attribute__((flatten)) void batchLuBlockAvx2(const std::size_t n, const std::size_t m, const std::size_t stride, R *aRe, R *aIm,
+                                                                 R *bRe, R *bIm, R *detRe, R *detIm, R *singular, R *work)
+    {
+        batchLuBlock<R, isComplex>(n, m, stride, aRe, aIm, bRe, bIm, detRe, detIm, singular, work);
+    }
+
+    template <typename R, bool isComplex>
+    I_TARGET_AVX512 __attribute__((flatten)) void batchLuBlockAvx512(const std::size_t n, const std::size_t m, const std::size_t stride, R *aRe, R *aIm,
+                                                                     R *bRe, R *bIm, R *detRe, R *detIm, R *singular, R *work)
+    {
+        batchLuBlock<R, isComplex>(n, m, stride, aRe, aIm, bRe, bIm, detRe, detIm, singular, work);
+    }
+#endif
+
+    template <typename R>
+    using batch_lu_kernel_t = void (*)(std::size_t, std::size_t, std::size_t, R *, R *, R *, R *, R *, R *, R *, R *);
+
+    template <typename R, bool isComplex>
+    batch_lu_kernel_t<R> batchLuKernel()
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return batchLuBlockAvx512<R, isComplex>;
+        case i_simd_level::avx2:
+            return batchLuBlockAvx2<R, isComplex>;
+        default:
+            break;
+        }
+#endif
+        return batchLuBlock<R, isComplex>;
+    }
+
+    // LU of every matrix in matA (overwritten by U) with matB (overwritten by A \ B, may have 0 columns);
+    // det & singular get one entry per matrix. Blocks of lanes run on the thread pool
+    template <typename T>
+    std::size_t batchLu(i_matrix_batch<T> &matA, i_matrix_batch<T> &matB, std::vector<T> &det)
+    {
+        using real_t = typename i_real_type<T>::type;
+        constexpr std::size_t W{i_batch_lanes};
+        const std::size_t n{matA.rows()}, m{matB.cols()}, stride{matA.stride()}, nblocks{stride / W};
+        std::vector<real_t> detRe(stride), detIm(stride), singular(stride);
+        const batch_lu_kernel_t<real_t> kernel{batchLuKernel<real_t, i_matrix_batch<T>::isComplex>()};
+        const std::size_t blockWork{W * n * n * (n + m) + 1}, grain{std::max<std::size_t>(1, i_parallel_min_work / 8 / blockWork)};
+        real_t *aRe{matA.realPlane(0, 0)}, *aIm{matA.imagPlane(0, 0)};
+        real_t *bRe{m > 0 ? matB.realPlane(0, 0) : nullptr}, *bIm{m > 0 ? matB.imagPlane(0, 0) : nullptr};
+        parallelFor(0, nblocks, grain, [&](const std::size_t blockBegin, const std::size_t blockEnd) {
+            std::vector<real_t> work(2 * n * W);
+            for (std::size_t blk{blockBegin}; blk < blockEnd; ++blk)
+            {
+                const std::size_t b0{blk * W};
+                kernel(n, m, stride, aRe + b0, aIm ? aIm + b0 : nullptr, bRe ? bRe + b0 : nullptr, bIm ? bIm + b0 : nullptr,
+                       detRe.data() + b0, detIm.data() + b0, singular.data() + b0, work.data());
+            }
+        });
+
+        std::size_t nsingular{0};
+        det.resize(matA.count());
+        for (std::size_t b{0}; b < matA.count(); ++b)
+        {
+            if constexpr (i_matrix_batch<T>::isComplex)
+            {
+                det[b] = T{detRe[b], detIm[b]};
+            }
+            else
+            {
+                det[b] = detRe[b];
+            }
+            if (singular[b] != real_t{0})
+            {
+                ++nsingular;
+                det[b] = T{};
+                for (std::size_t i{0}; i < n; ++i)
+                {
+                    for (std::size_t j{0}; j < m; ++j)
+                    {
+                        matB.set(b, i, j, T{});
+                    }
+                }
+            }
+        }
+        return nsingular;
+    }
+} // namespace i_kernel
+
+template <typename T>
+std::vector<T> det(const i_matrix_batch<T> &matA)
+{
+    std::vector<T> resDet;
+    if (matA.rows() != matA.cols())
+    {
+        std::cout << "Error when using det: matrix is not square.\n";
+        return resDet;
+    }
+    i_matrix_batch<T> matU{matA}, matNone(matA.count(), matA.rows(), 0);
+    i_kernel::batchLu(matU, matNone, resDet);
+    return resDet;
+}
+
+template <typename T>
+i_matrix_batch<T> inv(const i_matrix_batch<T> &matA)
+{
+    i_matrix_batch<T> resBatch;
+    if (matA.rows() != matA.cols())
+    {
+        std::cout << "Error when using inv: matrix is not square.\n";
+        return resBatch;
+    }
+    const std::size_t n{matA.rows()};
+    resBatch = i_matrix_batch<T>(matA.count(), n, n);
+    for (std::size_t i{0}; i < n; ++i)
+    {
+        std::fill_n(resBatch.realPlane(i, i), resBatch.stride(), typename i_matrix_batch<T>::real_t{1});
+    }
+    i_matrix_batch<T> matU{matA};
+    std::vector<T> resDet;
+    const std::size_t nsingular{i_kernel::batchLu(matU, resBatch, resDet)};
+    if (nsingular > 0)
+    {
+        std::cout << "Warning when using inv: " << nsingular << " singular matrices in the batch, their inverses are set to zero.\n";
+    }
+    return resBatch;
+}
+
+// X(b) = A(b) \ B(b), square A(b) only (LU with partial pivoting)
+template <typename T>
+i_matrix_batch<T> leftDiv(const i_matrix_batch<T> &matA, const i_matrix_batch<T> &matB)
+{
+    i_matrix_batch<T> resBatch;
+    if (matA.rows() != matA.cols())
+    {
+        std::cout << "Error when using leftDiv: batched version needs square matrices.\n";
+        return resBatch;
+    }
+    if (matA.count() != matB.count() || matA.rows() != matB.rows())
+    {
+        std::cout << "Error when using leftDiv: dimension not match.\n";
+        return resBatch;
+    }
+    resBatch = matB;
+    i_matrix_batch<T> matU{matA};
+    std::vector<T> resDet;
+    const std::size_t nsingular{i_kernel::batchLu(matU, resBatch, resDet)};
+    if (nsingular > 0)
+    {
+        std::cout << "Warning when using leftDiv: " << nsingular << " singular matrices in the batch, their solutions are set to zero.\n";
+    }
+    return resBatch;
+}
@@ -0,0 +1,319 @@
+#pragma once
+/*
+Mini Matrix Tools - Dense Cholesky Factorization
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+A = L * L' for a Hermitian (real: symmetric) positive definite matrix, L lower triangular.
+Tiled right-looking, PLASMA style [*1]: POTRF / TRSM / SYRK / GEMM tasks on i_cholesky_tile tiles, scheduled as a
+dependency graph (see matBasic_thread.hpp), so the next diagonal tile is factored while trailing updates still run.
+Diagonal & off-diagonal tiles use the row Cholesky-Crout form, one SIMD dot product per element.
+Solves normal equations & other Hermitian positive definite systems, e.g. A' * A * x = A' * b.
+A kept factorization follows A + X * X' & A - X * X' (rows of A' * A added / removed) in O(k * n^2) by k Givens /
+hyperbolic rotation sweeps [*2], instead of an O(n^3) refactorization.
+
+Main Function List:
+[1] CholeskyFactorization::solve:            X = A \ B for any number of right-hand sides (blocked triangular solves)
+[2] CholeskyFactorization::positiveDefinite: false if a pivot fell below tolerance * max(diag(A))
+[3] CholeskyFactorization::update / downdate: L * L' = A + X * X' / A - X * X', rank-1 (vector) or rank-k (n x k X)
+[4] i_kernel::choleskyTiled:                  The task-graph factorization, also the rank revealing Cholesky of rank & pinv2
+
+Reference:
+[*1] Alfredo Buttari, Julien Langou, Jakub Kurzak, Jack Dongarra, A Class of Parallel Tiled Linear Algebra Algorithms for Multicore Architectures, Parallel Computing 35(1), 2009
+[*2] Philip E. Gill, Gene H. Golub, Walter Murray, Michael A. Saunders, Methods for Modifying Matrix Factorizations, Math. Comp. 28(126), 1974
+*/
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_gemm.hpp"
+
+constexpr std::size_t i_cholesky_block{64}; // Block height of the triangular solves
+constexpr std::size_t i_cholesky_tile{128}; // Tile size of the task-graph factorization
+
+namespace i_kernel
+{
+    // Tiled Cholesky of the lower triangle of A (n x n) in place, as a graph of tile tasks run by the thread pool:
+    //     POTRF(k, k); TRSM(i, k) for i > k; SYRK(i, i) & GEMM(i, j) -= L(i, k) * L(j, k)' for k < j < i
+    // A pivot <= tol stops the factorization (skipDeficient = false) or leaves a zero column in L (skipDeficient = true,
+    // the rank revealing variant of rank & pinv2). Returns the number of accepted pivots; the upper triangle is not touched.
+    template <typename T>
+    std::size_t choleskyTiled(const std::size_t n, T *matA, const std::size_t lda, const typename i_real_type<T>::type tol, const bool skipDeficient)
+    {
+        using real_t = typename i_real_type<T>::type;
+        const std::size_t nb{i_cholesky_tile}, nt{(n + nb - 1) / nb};
+        std::atomic<std::size_t> accepted{0};
+        std::atomic<bool> failed{false};
+        const auto tile = [matA, lda, nb](const std::size_t i, const std::size_t j) { return matA + i * nb * lda + j * nb; };
+        const auto tileSize = [n, nb](const std::size_t i) { return std::min(nb, n - i * nb); };
+        // x(j) = (x(j) - conj(L(j, 0:j)) . x(0:j)) / L(j, j) for j < ncols, L a diagonal tile; 0 in a skipped column (L(j, j) = 0)
+        const auto solveRow = [lda](const T *tileL, T *rowX, const std::size_t ncols) {
+            for (std::size_t j{0}; j < ncols; ++j)
+            {
+                const T pivot{tileL[j * lda + j]};
+                rowX[j] = pivot == T{} ? T{} : (rowX[j] - dotc(j, tileL + j * lda, rowX)) / pivot;
+            }
+        };
+
+        const auto potrf = [&](const std::size_t k) {
+            T *tileL{tile(k, k)};
+            for (std::size_t i{0}; i < tileSize(k) && !failed.load(std::memory_order_relaxed); ++i)
+            {
+                T *rowL{tileL + i * lda};
+                solveRow(tileL, rowL, i);
+                const real_t pivot{std::real(rowL[i] - dotc(i, rowL, rowL))};
+                if (pivot > tol)
+                {
+                    rowL[i] = T{std::sqrt(pivot)};
+                    accepted.fetch_add(1, std::memory_order_relaxed);
+                }
+                else if (skipDeficient)
+                {
+                    rowL[i] = T{};
+                }
+                else
+                {
+                    failed.store(true); // Rank deficient or indefinite, the remaining tasks do nothing
+                }
+            }
+        };
+        const auto trsm = [&](const std::size_t i, const std::size_t k) {
+            for (std::size_t r{0}; r < tileSize(i) && !failed.load(std::memory_order_relaxed); ++r)
+            {
+                solveRow(tile(k, k), tile(i, k) + r * lda, tileSize(k));
+            }
+        };
+        const auto update = [&](const std::size_t i, const std::size_t j, const std::size_t k) {
+            if (failed.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            if (i == j)
+            {
+                herk(tileSize(i), tileSize(k), tile(i, k), lda, false, tile(i, i), lda, T{-1});
+            }
+            else
+            {
+                gemm(tileSize(i), tileSize(j), tileSize(k), tile(i, k), lda, false, tile(j, k), lda, true, tile(i, j), lda, T{-1});
+            }
+        };
+
+        i_task_graph graph(nt * nt);
+        for (std::size_t k{0}; k < nt; ++k)
+        {
+            graph.addTask([&potrf, k]() { potrf(k); }, {}, {k * nt + k}, 2);
+            for (std::size_t i{k + 1}; i < nt; ++i)
+            {
+                graph.addTask([&trsm, i, k]() { trsm(i, k); }, {k * nt + k}, {i * nt + k}, 1);
+            }
+            for (std::size_t i{k + 1}; i < nt; ++i)
+            {
+                for (std::size_t j{k + 1}; j <= i; ++j)
+                {
+                    // Updates of column k + 1 feed the next POTRF / TRSM, run them first
+                    graph.addTask([&update, i, j, k]() { update(i, j, k); }, {i * nt + k, j * nt + k}, {i * nt + j}, j == k + 1 ? 1 : 0);
+                }
+            }
+        }
+        graph.run();
+        return accepted.load();
+    }
+} // namespace i_kernel
+
+template <typename T>
+class CholeskyFactorization
+{
+public:
+    using real_t = typename i_real_type<T>::type;
+
+    CholeskyFactorization() = default;
+
+    // Only the lower triangle of matA is read
+    explicit CholeskyFactorization(const i_dense_matrix<T> &matA, const real_t tolerance = defaultTolerance<T>())
+    {
+        if (matA.rows() != matA.cols())
+        {
+            std::cout << "Error when using CholeskyFactorization: matrix is not square.\n";
+            return;
+        }
+        factor(matA, tolerance);
+    }
+
+    bool empty() const { return m_l.empty(); }
+    bool positiveDefinite() const { return m_positiveDefinite; }
+    std::size_t size() const { return m_l.rows(); }
+    const i_dense_matrix<T> &lower() const { return m_l; }
+
+    // X = A \ B: L * Y = B, then L' * X = Y
+    i_dense_matrix<T> solve(const i_dense_matrix<T> &matB) const
+    {
+        const std::size_t nSize{size()}, nrhs{matB.cols()}, ld{m_l.stride()};
+        i_dense_matrix<T> matX;
+        if (matB.rows() != nSize)
+        {
+            std::cout << "Error when using CholeskyFactorization::solve: row size not match.\n";
+            return matX;
+        }
+        if (!m_positiveDefinite)
+        {
+            std::cout << "Warning when using CholeskyFactorization::solve: matrix is not positive definite.\n";
+            return matX;
+        }
+        matX = matB;
+
+        // ******************** Step 1: forward substitution, top block first ********************
+        for (std::size_t jb{0}; jb < nSize; jb += i_cholesky_block)
+        {
+            const std::size_t je{std::min(jb + i_cholesky_block, nSize)};
+            i_kernel::gemm(je - jb, nrhs, jb, m_l.row(jb), ld, false, matX.data(), matX.stride(), false,
+                           matX.row(jb), matX.stride(), T{-1});
+            for (std::size_t i{jb}; i < je; ++i)
+            {
+                for (std::size_t q{jb}; q < i; ++q)
+                {
+                    i_kernel::axpy(nrhs, -m_l(i, q), matX.row(q), matX.row(i));
+                }
+                scaleRow(matX.row(i), nrhs, T{1} / m_l(i, i));
+            }
+        }
+
+        // ******************** Step 2: back substitution with L', bottom block first ********************
+        const std::size_t nBlocks{(nSize + i_cholesky_block - 1) / i_cholesky_block};
+        for (std::size_t b{nBlocks}; b > 0; --b)
+        {
+            const std::size_t jb{(b - 1) * i_cholesky_block}, je{std::min(jb + i_cholesky_block, nSize)};
+            i_kernel::gemm(je - jb, nrhs, nSize - je, m_l.row(je) + jb, ld, true, matX.row(je), matX.stride(), false,
+                           matX.row(jb), matX.stride(), T{-1}); // L(je:n, jb:je)' * X(je:n, :)
+            for (std::size_t i{je}; i > jb; --i)
+            {
+                const std::size_t ii{i - 1};
+                scaleRow(matX.row(ii), nrhs, T{1} / m_l(ii, ii));
+                for (std::size_t q{jb}; q < ii; ++q)
+                {
+                    i_kernel::axpy(nrhs, -conjScalar(m_l(ii, q)), matX.row(ii), matX.row(q));
+                }
+            }
+        }
+        return matX;
+    }
+
+    // A + x * x', x holds size() values
+    bool update(const T *x)
+    {
+        return modify(x, 1, 1, false);
+    }
+
+    // A + X * X', X is n x k: k rank-1 updates
+    bool update(const i_dense_matrix<T> &matX)
+    {
+        return matX.rows() == size() ? modify(matX.data(), matX.stride(), matX.cols(), false) : sizeError("update");
+    }
+
+    // A - x * x'; false (factor unchanged) if A - x * x' is not positive definite
+    bool downdate(const T *x)
+    {
+        return modify(x, 1, 1, true);
+    }
+
+    // A - X * X', X is n x k; false (factor unchanged) if some pivot falls to tolerance * its old value or below
+    bool downdate(const i_dense_matrix<T> &matX)
+    {
+        return matX.rows() == size() ? modify(matX.data(), matX.stride(), matX.cols(), true) : sizeError("downdate");
+    }
+
+private:
+    bool sizeError(const char *name) const
+    {
+        std::cout << "Error when using CholeskyFactorization::" << name << ": row size not match.\n";
+        return false;
+    }
+
+    // One sweep per column x = X(:, q) (stride ldx between elements), on a copy of L for a downdate. Row by row, so
+    // that L is read contiguously: row i first applies the rotations of columns k < i to (L(i, k), x(i)), then makes
+    // its own, which zeroes x(i) against L(i, i):
+    //     update:    r = sqrt(L(i, i)^2 + |x(i)|^2), Givens        L(:, i) = (L(:, i) + conj(s) * x) / c, x = c * x - s * L(:, i)
+    //     downdate:  r = sqrt(L(i, i)^2 - |x(i)|^2), hyperbolic    L(:, i) = (L(:, i) - conj(s) * x) / c, x = c * x - s * L(:, i)
+    // with c = r / L(i, i), s = x(i) / L(i, i)
+    bool modify(const T *matX, const std::size_t ldx, const std::size_t ncols, const bool isDowndate)
+    {
+        const std::size_t nSize{size()};
+        const char *name{isDowndate ? "downdate" : "update"};
+        if (!m_positiveDefinite)
+        {
+            std::cout << "Warning when using CholeskyFactorization::" << name << ": matrix is not positive definite.\n";
+            return false;
+        }
+        i_dense_matrix<T> matL;
+        if (isDowndate)
+        {
+            matL = m_l; // Kept unchanged if the downdate fails half way
+        }
+        i_dense_matrix<T> &workL{isDowndate ? matL : m_l};
+        const T sign{isDowndate ? T{-1} : T{1}};
+        std::vector<real_t> c(nSize), cInv(nSize);
+        std::vector<T> s(nSize);
+        for (std::size_t q{0}; q < ncols; ++q)
+        {
+            for (std::size_t i{0}; i < nSize; ++i)
+            {
+                T *rowL{workL.row(i)};
+                T valX{matX[i * ldx + q]};
+                for (std::size_t k{0}; k < i; ++k)
+                {
+                    rowL[k] = (rowL[k] + sign * conjScalar(s[k]) * valX) * cInv[k];
+                    valX = c[k] * valX - s[k] * rowL[k];
+                }
+                const real_t pivot{std::real(rowL[i])}, pivot2{pivot * pivot};
+                const real_t r2{isDowndate ? pivot2 - std::norm(valX) : pivot2 + std::norm(valX)};
+                if (!(r2 > m_tolerance * pivot2))
+                {
+                    std::cout << "Warning when using CholeskyFactorization::" << name << ": matrix is not positive definite.\n";
+                    return false;
+                }
+                const real_t r{std::sqrt(r2)};
+                c[i] = r / pivot;
+                cInv[i] = pivot / r;
+                s[i] = valX / pivot;
+                rowL[i] = T{r};
+            }
+        }
+        if (isDowndate)
+        {
+            m_l.swap(matL);
+        }
+        return true;
+    }
+
+    static void scaleRow(T *rowX, const std::size_t n, const T value)
+    {
+        for (std::size_t j{0}; j < n; ++j)
+        {
+            rowX[j] *= value;
+        }
+    }
+
+    void factor(const i_dense_matrix<T> &matA, const real_t tolerance)
+    {
+        const std::size_t nSize{matA.rows()};
+        real_t maxDiag{0};
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            maxDiag = std::max(maxDiag, static_cast<real_t>(std::real(matA(i, i))));
+        }
+
+        m_l = i_dense_matrix<T>(nSize, nSize); // Working copy of the lower triangle of A, overwritten by L
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            std::copy_n(matA.row(i), i + 1, m_l.row(i));
+        }
+        m_tolerance = tolerance;
+        m_positiveDefinite = i_kernel::choleskyTiled(nSize, m_l.data(), m_l.stride(), maxDiag * tolerance, false) == nSize;
+    }
+
+    i_dense_matrix<T> m_l;
+    real_t m_tolerance{defaultTolerance<T>()};
+    bool m_positiveDefinite{false};
+};
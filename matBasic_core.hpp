@@ -0,0 +1,458 @@
+#pragma once
+/*
+Mini Matrix Tools - Scalar-Generic Core
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+The dense algorithms of matBasic_real.hpp & matBasic_complex.hpp, written once as templates over the scalar type
+T = float, double, std::complex<float> or std::complex<double>. Every precision can be used in the same program:
+    i_dense_matrix<float> stages run the float kernels (see matBasic_simd_float.hpp), twice the lanes of double per register
+    & half the memory traffic; castMatrix<double> hands their result to a double precision solve
+    the tolerances default to defaultTolerance<T>() (see matBasic_dense.hpp): 1e-9 in double, 1e-4 in float
+    transpose is the conjugate transpose for complex T, the plain transpose for real T
+i_float_t only selects the precision of the i_real_* / i_complex_* aliases, the functions take any of the four types.
+
+Main Function List:
+[1] castMatrix: Element type conversion, e.g. i_dense_matrix<float> -> i_dense_matrix<double> or real -> complex
+[2] transpose:  Matrix transpose (conjugate transpose for complex matrices)
+[3] matMul:     Matrix multiplication, packed & cache-blocked GEMM
+[4] rank:       Matrix rank (Cholesky decomposition)
+[5] det:        Matrix determinant calculation (blocked LU with partial pivoting)
+[6] inv:        LU decomposition-based matrix inversion
+[7] pinv:       pinv(G) = inv(G' * G) * G' (WARNING: full-rank matrix only!)
+[8] pinv2:      Moore-Penrose pseudoinversion (same as pinv(G) in MATLAB), dense or sparse G
+[9] leftDiv:    x = A \ b, LU / Householder QR / pinv for dense A, normal equations for sparse A
+[10] showMatrix: Print a matrix, block or MATLAB format
+All of them also take std::vector<std::vector<T>>, converted to contiguous storage & back.
+
+Reference:
+[*1] Pierre Courrieu, Fast Computation of Moore-Penrose Inverse Matrices, https://arxiv.org/abs/0804.4809
+[*2] Permute Sign Calculation, page5 https://www.math.rutgers.edu/docman-lister/math-main/academics/course-materials/250/assignments/1493-250c-lab3-sakai-pdf/file
+[*3] LU Decomposition C++ Implementation, https://blog.csdn.net/xx_123_1_rj/article/details/39553809
+[*4] LU Decomposition, https://www.math.ucdavis.edu/~linear/old/notes11.pdf
+*/
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_gemm.hpp"
+#include "matBasic_lu.hpp"
+#include "matBasic_cholesky.hpp"
+#include "matBasic_qr.hpp"
+#include "matBasic_sparse.hpp"
+#include "matBasic_sparse_cholesky.hpp"
+#include "matBasic_text.hpp"
+
+using i_float_t = double; // Precision of the i_real_* & i_complex_* aliases, e.g. float; Notice: Do NOT use int type!
+
+// Element type conversion: float <-> double, real -> complex (complex -> real does not compile)
+template <typename U, typename T>
+i_dense_matrix<U> castMatrix(const i_dense_matrix<T> &matG)
+{
+    i_dense_matrix<U> resMat(matG.rows(), matG.cols());
+    for (std::size_t i{0}; i < matG.rows(); ++i)
+    {
+        const T *rowG{matG.row(i)};
+        U *rowRes{resMat.row(i)};
+        for (std::size_t j{0}; j < matG.cols(); ++j)
+        {
+            rowRes[j] = static_cast<U>(rowG[j]);
+        }
+    }
+    return resMat;
+}
+
+// Simply print matrix with description, can be either block or MATLAB format.
+// The MATLAB format goes through writeMatrixText (see matBasic_text.hpp): exact values, readable by parseMatrixText.
+template <typename T>
+void showMatrix(const i_dense_matrix<T> &matG, const char *describe = nullptr, bool matlabFormat = false)
+{
+    constexpr bool isComplex{!std::is_same<T, typename i_real_type<T>::type>::value};
+    const std::size_t nrows{matG.rows()}, ncols{matG.cols()};
+    if (describe && matlabFormat)
+    {
+        writeMatrixText(std::cout, matG, i_text_format::matlab, describe);
+        return;
+    }
+    if (describe)
+    {
+        std::cout << describe << " : " << nrows << " x " << ncols << (isComplex ? " Complex Matrix:\n" : " Real Matrix:\n");
+    }
+    for (std::size_t row{0}; row < nrows; ++row)
+    {
+        std::cout << "    row[" << row + 1 << "]: ";
+        for (std::size_t col{0}; col < ncols; ++col)
+        {
+            if constexpr (isComplex)
+            {
+                std::cout << matG(row, col).real();
+                const typename i_real_type<T>::type imag{matG(row, col).imag()};
+                if (imag != 0)
+                {
+                    std::cout << (imag > 0 ? "+" : "-") << std::abs(imag) << "i";
+                }
+            }
+            else
+            {
+                std::cout << matG(row, col);
+            }
+            if (col + 1 < ncols)
+            {
+                std::cout << ",  ";
+            }
+            else
+            {
+                std::cout << ";\n";
+            }
+        }
+    }
+    std::cout << "\n";
+}
+
+template <typename T>
+void showMatrix(const std::vector<std::vector<T>> &matG, const char *describe = nullptr, bool matlabFormat = false)
+{
+    showMatrix(toDenseMatrix(matG), describe, matlabFormat);
+}
+
+// Matrix transpose; conjugate transpose (a.k.a. Hermitian transpose, G' = G^H = conj(G^T)) for complex matrices
+template <typename T>
+i_dense_matrix<T> transpose(const i_dense_matrix<T> &matG)
+{
+    const std::size_t nrows{matG.rows()}, ncols{matG.cols()};
+    i_dense_matrix<T> matGt(ncols, nrows);
+    std::size_t i{0}, j{0};
+    for (i = 0; i < nrows; ++i)
+    {
+        const T *rowG{matG.row(i)};
+        for (j = 0; j < ncols; ++j)
+        {
+            matGt(j, i) = conjScalar(rowG[j]);
+        }
+    }
+    return matGt;
+}
+
+template <typename T>
+std::vector<std::vector<T>> transpose(const std::vector<std::vector<T>> &matG)
+{
+    return toNestedMatrix(transpose(toDenseMatrix(matG)));
+}
+
+// Matrix multiplication, packed & cache-blocked GEMM (see matBasic_gemm.hpp)
+template <typename T>
+i_dense_matrix<T> matMul(const i_dense_matrix<T> &matA, const i_dense_matrix<T> &matB)
+{
+    const std::size_t nrowsA{matA.rows()}, ncolsA{matA.cols()}, nrowsB{matB.rows()}, ncolsB{matB.cols()};
+    i_dense_matrix<T> resMat;
+    if (ncolsA != nrowsB)
+    {
+        std::cout << "Error when using matMul: dimension not match.\n";
+        return resMat;
+    }
+    resMat = i_dense_matrix<T>(nrowsA, ncolsB);
+    i_kernel::gemm(nrowsA, ncolsB, ncolsA, matA.data(), matA.stride(), false, matB.data(), matB.stride(), false, resMat.data(), resMat.stride());
+    return resMat;
+}
+
+template <typename T>
+std::vector<std::vector<T>> matMul(const std::vector<std::vector<T>> &matA, const std::vector<std::vector<T>> &matB)
+{
+    return toNestedMatrix(matMul(toDenseMatrix(matA), toDenseMatrix(matB)));
+}
+
+// Calculate matrix rank (Cholesky decomposition) [*1]
+template <typename T>
+std::size_t rank(const i_dense_matrix<T> &matG, const typename i_real_type<T>::type tolerance = defaultTolerance<T>())
+{
+    using real_t = typename i_real_type<T>::type;
+    const std::size_t nrows{matG.rows()}, ncols{matG.cols()};
+    std::size_t nSize{ncols};
+    std::size_t i{0};
+
+    i_dense_matrix<T> matA;
+    if (nrows < nSize)
+    {
+        nSize = nrows;
+        matA = i_dense_matrix<T>(nSize, nSize);
+        i_kernel::herk(nSize, ncols, matG.data(), matG.stride(), false, matA.data(), matA.stride()); // A = G * G', lower triangle only
+    }
+    else
+    {
+        matA = i_dense_matrix<T>(nSize, nSize);
+        i_kernel::herk(nSize, nrows, matG.data(), matG.stride(), true, matA.data(), matA.stride()); // A = G' * G, lower triangle only
+    }
+
+    // Full rank Cholesky decomposition of A, tiled task graph (see matBasic_cholesky.hpp)
+    real_t tol{std::abs(matA(0, 0))};
+    for (i = 0; i < nSize; ++i)
+    {
+        if (std::real(matA(i, i)) > 0)
+        {
+            const real_t temp{std::abs(matA(i, i))};
+            if (temp < tol)
+            {
+                tol = temp;
+            }
+        }
+    }
+    tol *= tolerance;
+
+    return i_kernel::choleskyTiled(nSize, matA.data(), matA.stride(), tol, true); // rank(G) = rank(A) = number of accepted pivots
+}
+
+template <typename T>
+std::size_t rank(const std::vector<std::vector<T>> &matG, const typename i_real_type<T>::type tolerance = defaultTolerance<T>())
+{
+    return rank(toDenseMatrix(matG), tolerance);
+}
+
+// LU decomposition-based matrix determinant calculation, blocked LU with partial pivoting (see matBasic_lu.hpp) [*2][*4]
+template <typename T>
+T det(const i_dense_matrix<T> &matG)
+{
+    T detG{};
+    if (matG.rows() != matG.cols())
+    {
+        std::cout << "Error when using det: matrix is not square.\n";
+        return detG;
+    }
+    detG = LUFactorization<T>(matG).det(); // det(G) = sign(P) * prod(diag(U)), zero for a singular matrix
+    return detG;
+}
+
+template <typename T>
+T det(const std::vector<std::vector<T>> &matG)
+{
+    return det(toDenseMatrix(matG));
+}
+
+// LU decomposition-based matrix inversion, inv(G) = inv(U) * inv(L) * P (see matBasic_lu.hpp) [*3][*4]
+template <typename T>
+i_dense_matrix<T> inv(const i_dense_matrix<T> &matG, const bool usePermute = true)
+{
+    if (matG.rows() != matG.cols())
+    {
+        std::cout << "Error when using inv: matrix is not square.\n";
+        return i_dense_matrix<T>();
+    }
+    const LUFactorization<T> factorLU(matG, usePermute); // usePermute = false: no row exchanges
+    if (factorLU.singular())
+    {
+        std::cout << "Warning when using inv: matrix is singular.\n";
+        return i_dense_matrix<T>();
+    }
+    return factorLU.inverse();
+}
+
+template <typename T>
+std::vector<std::vector<T>> inv(const std::vector<std::vector<T>> &matG, const bool usePermute = true)
+{
+    return toNestedMatrix(inv(toDenseMatrix(matG), usePermute));
+}
+
+// Classic pseudoinversion pinv(G) = inv(G' * G) * G' (WARNING: full-rank matrix only!)
+template <typename T>
+i_dense_matrix<T> pinv(const i_dense_matrix<T> &matG)
+{
+    i_dense_matrix<T> matGt = transpose(matG);
+    i_dense_matrix<T> matGtG_inv = inv(matMul(matGt, matG));
+    return matMul(matGtG_inv, matGt);
+}
+
+template <typename T>
+std::vector<std::vector<T>> pinv(const std::vector<std::vector<T>> &matG)
+{
+    return toNestedMatrix(pinv(toDenseMatrix(matG)));
+}
+
+// Generalized inverse core of pinv2 [*1] on a Gram matrix A = G' * G or G * G' (lower triangle read & overwritten):
+// full rank Cholesky A = L * L', then L * inv(L' * L)^2 * L'; an empty matrix if A is zero
+template <typename T>
+i_dense_matrix<T> pinvFromGram(i_dense_matrix<T> &matA, const typename i_real_type<T>::type tolerance)
+{
+    // Full rank Cholesky decomposition of A, tiled task graph (see matBasic_cholesky.hpp)
+    using real_t = typename i_real_type<T>::type;
+    const std::size_t nSize{matA.rows()};
+    std::size_t i{0}, k{0};
+
+    real_t tol{std::abs(matA(0, 0))};
+    for (i = 0; i < nSize; ++i)
+    {
+        if (std::real(matA(i, i)) > 0)
+        {
+            const real_t temp{std::abs(matA(i, i))};
+            if (temp < tol)
+            {
+                tol = temp;
+            }
+        }
+    }
+    tol *= tolerance;
+
+    const std::size_t rankA{i_kernel::choleskyTiled(nSize, matA.data(), matA.stride(), tol, true)}; // L overwrites the lower triangle of A
+
+    if (rankA == 0)
+    {
+        return {}; // All-zero matrix
+    }
+
+    // Slice L = L(:, accepted columns), the columns of deficient pivots are zero
+    i_dense_matrix<T> matLr(nSize, rankA);
+    std::size_t col{0};
+    for (k = 0; k < nSize; ++k)
+    {
+        if (matA(k, k) == T{})
+        {
+            continue;
+        }
+        for (i = k; i < nSize; ++i)
+        {
+            matLr(i, col) = matA(i, k);
+        }
+        ++col;
+    }
+
+    // Generalized inverse
+    i_dense_matrix<T> matLt = transpose(matLr);
+    i_dense_matrix<T> matM = inv(matMul(matLt, matLr), false); // M = inv(L' * L)
+    return matMul(matMul(matMul(matLr, matM), matM), matLt); // L * M * M * L'
+}
+
+// Moore-Penrose pseudoinversion (same as pinv(G) in MATLAB) [*1]
+template <typename T>
+i_dense_matrix<T> pinv2(const i_dense_matrix<T> &matG, const typename i_real_type<T>::type tolerance = defaultTolerance<T>())
+{
+    bool useTranspose{false};
+    const std::size_t nrows{matG.rows()}, ncols{matG.cols()};
+    std::size_t nSize{ncols};
+
+    i_dense_matrix<T> matA, matGt;
+    matGt = transpose(matG);
+    if (nrows < nSize)
+    {
+        useTranspose = true;
+        nSize = nrows;
+        matA = i_dense_matrix<T>(nSize, nSize);
+        i_kernel::herk(nSize, ncols, matG.data(), matG.stride(), false, matA.data(), matA.stride()); // A = G * G', lower triangle only
+    }
+    else
+    {
+        matA = i_dense_matrix<T>(nSize, nSize);
+        i_kernel::herk(nSize, nrows, matG.data(), matG.stride(), true, matA.data(), matA.stride()); // A = G' * G, lower triangle only
+    }
+
+    const i_dense_matrix<T> matP = pinvFromGram(matA, tolerance);
+    if (matP.empty())
+    {
+        return matGt; // All-zero matrix's transpose
+    }
+    if (useTranspose)
+    {
+        return matMul(matGt, matP); // pinv(G) = G' * (L * M * M * L')
+    }
+    return matMul(matP, matGt); // pinv(G) = (L * M * M * L') * G'
+}
+
+template <typename T>
+std::vector<std::vector<T>> pinv2(const std::vector<std::vector<T>> &matG, const typename i_real_type<T>::type tolerance = defaultTolerance<T>())
+{
+    return toNestedMatrix(pinv2(toDenseMatrix(matG), tolerance));
+}
+
+// Sparse version: the Gram matrix is assembled in O(nnz) (see matBasic_sparse.hpp), pinv(G) = (G * P)' with P Hermitian
+template <typename T>
+i_dense_matrix<T> pinv2(const i_csr_matrix<T> &matG, const typename i_real_type<T>::type tolerance = defaultTolerance<T>())
+{
+    const std::size_t nrows{matG.rows()}, ncols{matG.cols()};
+    if (nrows < ncols)
+    {
+        const i_csr_matrix<T> matGt = transpose(matG);
+        i_dense_matrix<T> matA = gramMatrix(matGt); // A = G * G'
+        const i_dense_matrix<T> matP = pinvFromGram(matA, tolerance);
+        return matP.empty() ? i_dense_matrix<T>(ncols, nrows) : matMul(matGt, matP); // pinv(G) = G' * P
+    }
+    i_dense_matrix<T> matA = gramMatrix(matG); // A = G' * G
+    const i_dense_matrix<T> matP = pinvFromGram(matA, tolerance);
+    return matP.empty() ? i_dense_matrix<T>(ncols, nrows) : transpose(matMul(matG, matP)); // pinv(G) = P * G' = (G * P)'
+}
+
+// Calculate left division x = A \ b:
+//   square & nonsingular: LU forward / back substitution
+//   tall & full column rank: Householder QR least squares, x = inv(R) * Q' * b (A' * A is never formed)
+//   otherwise (rank deficient or wide): Moore-Penrose pinv, NOT same as MATLAB for a singular matrix
+template <typename T>
+i_dense_matrix<T> leftDiv(const i_dense_matrix<T> &matA, const i_dense_matrix<T> &matb, const typename i_real_type<T>::type tolerance = defaultTolerance<T>())
+{
+    i_dense_matrix<T> matx;
+    const std::size_t nrows{matA.rows()}, ncols{matA.cols()};
+    if (nrows != matb.rows())
+    {
+        std::cout << "Error when using leftDiv: row size not match.\n";
+        return matx;
+    }
+    if (nrows == ncols)
+    {
+        const LUFactorization<T> factorLU(matA);
+        if (factorLU.pivotRatio() > tolerance)
+        {
+            return factorLU.solve(matb);
+        }
+    }
+    else if (nrows > ncols)
+    {
+        const QRFactorization<T> factorQR(matA, tolerance);
+        if (factorQR.fullRank())
+        {
+            return factorQR.solve(matb);
+        }
+    }
+    matx = matMul(pinv2(matA, tolerance), matb); // x = A \ b = pinv(A) * b
+    return matx;
+}
+
+template <typename T>
+std::vector<std::vector<T>> leftDiv(const std::vector<std::vector<T>> &matA, const std::vector<std::vector<T>> &matb,
+                                    const typename i_real_type<T>::type tolerance = defaultTolerance<T>())
+{
+    return toNestedMatrix(leftDiv(toDenseMatrix(matA), toDenseMatrix(matb), tolerance));
+}
+
+// Sparse version: normal equations A' * A * x = A' * b assembled in O(nnz) & solved by Cholesky: sparse LDL' with
+// AMD ordering when A' * A is sparse (incomplete baseline graph), dense tiled otherwise.
+// Moore-Penrose pinv if A' * A is not positive definite (rank deficient or wide A)
+template <typename T>
+i_dense_matrix<T> leftDiv(const i_csr_matrix<T> &matA, const i_dense_matrix<T> &matb, const typename i_real_type<T>::type tolerance = defaultTolerance<T>())
+{
+    i_dense_matrix<T> matx;
+    if (matA.rows() != matb.rows())
+    {
+        std::cout << "Error when using leftDiv: row size not match.\n";
+        return matx;
+    }
+    if (matA.rows() >= matA.cols())
+    {
+        const i_csr_matrix<T> matN = sparseGramMatrix(matA);
+        if (4 * matN.nnz() < matN.rows() * matN.cols()) // Less than a quarter full
+        {
+            const SparseCholeskyFactorization<T> factorN(matN, tolerance);
+            if (factorN.positiveDefinite())
+            {
+                return factorN.solve(adjointMul(matA, matb));
+            }
+        }
+        else
+        {
+            const CholeskyFactorization<T> factorN(toDenseMatrix(matN), tolerance);
+            if (factorN.positiveDefinite())
+            {
+                return factorN.solve(adjointMul(matA, matb));
+            }
+        }
+    }
+    matx = matMul(pinv2(matA, tolerance), matb); // x = A \ b = pinv(A) * b
+    return matx;
+}
@@ -0,0 +1,216 @@
+#pragma once
+/*
+Mini Matrix Tools - Contiguous Dense Matrix Storage
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+One aligned heap buffer per matrix, stored row by row. Every row starts on an
+i_dense_alignment byte boundary, so the distance between two rows (stride) may be
+larger than the column count. Padding elements are always zero.
+A matrix can also borrow storage it does not own, e.g. the pages of a memory-mapped file
+(see matBasic_file.hpp): a shared keep-alive handle holds the storage until the last matrix
+using it is gone. Copies of a borrowed matrix own their own buffer.
+
+Main Function List:
+[1] i_dense_matrix:   Owning row-major dense matrix (shared by real & complex headers)
+[2] toDenseMatrix:    std::vector<std::vector<T>> -> i_dense_matrix<T>
+[3] toNestedMatrix:   i_dense_matrix<T> -> std::vector<std::vector<T>>
+[4] i_aligned_vector: std::vector with aligned storage, used for kernel workspaces
+[5] i_dense_matrix(data, rows, cols, keepAlive): Borrow rows x cols elements at data, stride paddedStride(cols)
+*/
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+constexpr std::size_t i_dense_alignment{64}; // Cache line size, also covers AVX-512 register width
+
+// Minimal allocator handing out i_dense_alignment aligned memory
+template <typename T>
+struct i_aligned_allocator
+{
+    using value_type = T;
+
+    i_aligned_allocator() = default;
+    template <typename U>
+    i_aligned_allocator(const i_aligned_allocator<U> &) {}
+
+    T *allocate(const std::size_t count)
+    {
+        return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t{i_dense_alignment}));
+    }
+    void deallocate(T *ptr, const std::size_t)
+    {
+        ::operator delete(ptr, std::align_val_t{i_dense_alignment});
+    }
+
+    template <typename U>
+    bool operator==(const i_aligned_allocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const i_aligned_allocator<U> &) const { return false; }
+};
+
+template <typename T>
+using i_aligned_vector = std::vector<T, i_aligned_allocator<T>>;
+
+// Scalar helpers shared by real & complex kernels (std::conj of a real number would return a complex)
+template <typename T>
+T conjScalar(const T &value) { return value; }
+template <typename T>
+std::complex<T> conjScalar(const std::complex<T> &value) { return std::conj(value); }
+
+// Underlying real type: T for real scalars, R for std::complex<R>
+template <typename T>
+struct i_real_type
+{
+    using type = T;
+};
+template <typename T>
+struct i_real_type<std::complex<T>>
+{
+    using type = T;
+};
+
+// Default relative tolerance of rank & pivot decisions: 1e-9 in double, 1e-4 in float (about the square root of the rounding unit)
+template <typename T>
+constexpr typename i_real_type<T>::type defaultTolerance()
+{
+    return static_cast<typename i_real_type<T>::type>(sizeof(typename i_real_type<T>::type) < sizeof(double) ? 1.0e-4 : 1.0e-9);
+}
+
+template <typename T>
+class i_dense_matrix
+{
+public:
+    i_dense_matrix() = default;
+
+    i_dense_matrix(const std::size_t nrows, const std::size_t ncols, const T initValue = T{})
+        : m_rows{nrows}, m_cols{ncols}, m_stride{paddedStride(ncols)}
+    {
+        allocate();
+        for (std::size_t i{0}; i < m_rows; ++i)
+        {
+            std::fill_n(row(i), m_cols, initValue);
+        }
+    }
+
+    // Borrowed storage: data must be i_dense_alignment aligned, rows * paddedStride(ncols) elements with zero padding
+    i_dense_matrix(T *data, const std::size_t nrows, const std::size_t ncols, std::shared_ptr<void> keepAlive)
+        : m_data{data}, m_rows{nrows}, m_cols{ncols}, m_stride{paddedStride(ncols)}, m_keepAlive{std::move(keepAlive)}
+    {
+    }
+
+    i_dense_matrix(const i_dense_matrix &other)
+        : m_rows{other.m_rows}, m_cols{other.m_cols}, m_stride{other.m_stride}
+    {
+        allocate();
+        std::copy_n(other.m_data, m_rows * m_stride, m_data);
+    }
+
+    i_dense_matrix(i_dense_matrix &&other) noexcept
+    {
+        swap(other);
+    }
+
+    i_dense_matrix &operator=(i_dense_matrix other) noexcept
+    {
+        swap(other); // Copy-and-swap, handles both copy & move assignment
+        return *this;
+    }
+
+    ~i_dense_matrix()
+    {
+        release();
+    }
+
+    void swap(i_dense_matrix &other) noexcept
+    {
+        std::swap(m_data, other.m_data);
+        std::swap(m_rows, other.m_rows);
+        std::swap(m_cols, other.m_cols);
+        std::swap(m_stride, other.m_stride);
+        std::swap(m_keepAlive, other.m_keepAlive);
+    }
+
+    std::size_t rows() const { return m_rows; }
+    std::size_t cols() const { return m_cols; }
+    std::size_t stride() const { return m_stride; } // Distance (in elements) between two rows
+    std::size_t size() const { return m_rows * m_cols; }
+    bool empty() const { return m_rows == 0 || m_cols == 0; }
+    bool borrowed() const { return static_cast<bool>(m_keepAlive); } // Storage belongs to someone else, e.g. a file mapping
+
+    T *data() { return m_data; }
+    const T *data() const { return m_data; }
+    T *row(const std::size_t i) { return m_data + i * m_stride; }
+    const T *row(const std::size_t i) const { return m_data + i * m_stride; }
+    T &operator()(const std::size_t i, const std::size_t j) { return m_data[i * m_stride + j]; }
+    const T &operator()(const std::size_t i, const std::size_t j) const { return m_data[i * m_stride + j]; }
+
+    // Round the row length up so that every row starts on an aligned address
+    static std::size_t paddedStride(const std::size_t ncols)
+    {
+        constexpr std::size_t lane{i_dense_alignment % sizeof(T) == 0 ? i_dense_alignment / sizeof(T) : 1};
+        return (ncols + lane - 1) / lane * lane;
+    }
+
+private:
+    void allocate()
+    {
+        const std::size_t count{m_rows * m_stride};
+        if (count == 0)
+        {
+            m_data = nullptr;
+            return;
+        }
+        m_data = i_aligned_allocator<T>().allocate(count);
+        std::uninitialized_fill_n(m_data, count, T{}); // Zero padding as well
+    }
+
+    void release()
+    {
+        if (m_keepAlive)
+        {
+            m_keepAlive.reset();
+            m_data = nullptr;
+        }
+        else if (m_data)
+        {
+            std::destroy_n(m_data, m_rows * m_stride);
+            i_aligned_allocator<T>().deallocate(m_data, m_rows * m_stride);
+            m_data = nullptr;
+        }
+    }
+
+    T *m_data{nullptr};
+    std::size_t m_rows{0};
+    std::size_t m_cols{0};
+    std::size_t m_stride{0};
+    std::shared_ptr<void> m_keepAlive; // Set for borrowed storage only
+};
+
+// Copy a vector-of-vectors matrix into contiguous storage
+template <typename T>
+i_dense_matrix<T> toDenseMatrix(const std::vector<std::vector<T>> &matG)
+{
+    const std::size_t nrows{matG.size()}, ncols{matG.empty() ? 0 : matG[0].size()};
+    i_dense_matrix<T> resMat(nrows, ncols);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        std::copy_n(matG[i].data(), ncols, resMat.row(i));
+    }
+    return resMat;
+}
+
+// Copy contiguous storage back into a vector-of-vectors matrix
+template <typename T>
+std::vector<std::vector<T>> toNestedMatrix(const i_dense_matrix<T> &matG)
+{
+    std::vector<std::vector<T>> resMat(matG.rows());
+    for (std::size_t i{0}; i < matG.rows(); ++i)
+    {
+        resMat[i].assign(matG.row(i), matG.row(i) + matG.cols());
+    }
+    return resMat;
+}
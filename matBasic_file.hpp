@@ -0,0 +1,437 @@
+#pragma once
+/*
+Mini Matrix Tools - Memory-Mapped Binary Matrix File
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+Versioned binary format whose payload has exactly the layout of i_dense_matrix, so loading is a mapping, not a parse:
+    [0, 64)        header: magic "MMTDENSE", version, dtype, count, rows, cols, stride, alignment, payload offset
+    [offset, end)  count matrices of rows x stride elements, row by row, padding elements zero
+The payload offset & every row start are multiples of the alignment (i_dense_alignment, 64 bytes), the stride is
+i_dense_matrix<T>::paddedStride(cols) and the byte order is the native one of the writer.
+mapMatrixFile / mapMatrixStack mmap the file (private, copy-on-write) and return matrices that borrow the mapped pages:
+no copy, pages are read from disk on first touch and shared through the page cache with every other process mapping
+the same file. Writing to a mapped matrix copies the touched pages only, the file itself never changes.
+Files written with another stride or alignment, and systems without mmap, fall back to reading into owned matrices.
+createMatrixFile maps a new, zero-filled file shared & writable instead: whatever is stored into the matrix ends up
+in the file, written back by the system page by page, e.g. the result of an out-of-core product (see matBasic_ooc.hpp).
+
+Main Function List:
+[1] writeMatrixFile:      One matrix, or a stack of same-sized matrices, to a file
+[2] i_matrix_file_writer: Stream rows out block by block without holding the whole matrix in memory
+[3] mapMatrixFile:        Zero-copy load of the whole payload as one (count * rows) x cols matrix
+[4] mapMatrixStack:       Zero-copy load of count matrices of rows x cols, all sharing one mapping
+[5] readMatrixFile:       Copying load into an owned matrix
+[6] readMatrixFileHeader: Header only, e.g. to check dtype & shape before loading
+[7] createMatrixFile:     New rows x cols file of zeros, returned as a matrix mapped onto the file (writes reach the file)
+*/
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "matBasic_dense.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define I_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define I_FILE_MMAP 0
+#endif
+
+constexpr std::uint32_t i_matrix_file_version{1};
+
+struct i_matrix_file_header
+{
+    char magic[8]{'M', 'M', 'T', 'D', 'E', 'N', 'S', 'E'};
+    std::uint32_t version{i_matrix_file_version}; // A file from a machine with the other byte order fails this check
+    std::uint32_t dtype{0};                       // i_matrix_file_dtype<T>::value
+    std::uint64_t count{0};                       // Number of matrices, 1 for a plain matrix
+    std::uint64_t rows{0};                        // Rows of each matrix
+    std::uint64_t cols{0};
+    std::uint64_t stride{0};    // Elements between two rows
+    std::uint64_t alignment{0}; // Bytes
+    std::uint64_t offset{0};    // Payload position in bytes
+};
+static_assert(sizeof(i_matrix_file_header) == 64, "i_matrix_file_header must stay 64 bytes");
+
+// Element type codes stored in the header
+template <typename T>
+struct i_matrix_file_dtype;
+template <>
+struct i_matrix_file_dtype<float>
+{
+    static constexpr std::uint32_t value{1};
+};
+template <>
+struct i_matrix_file_dtype<double>
+{
+    static constexpr std::uint32_t value{2};
+};
+template <>
+struct i_matrix_file_dtype<std::complex<float>>
+{
+    static constexpr std::uint32_t value{3};
+};
+template <>
+struct i_matrix_file_dtype<std::complex<double>>
+{
+    static constexpr std::uint32_t value{4};
+};
+
+namespace i_matrix_file
+{
+    // Payload starts on the first alignment boundary after the header
+    inline std::uint64_t payloadOffset()
+    {
+        return (sizeof(i_matrix_file_header) + i_dense_alignment - 1) / i_dense_alignment * i_dense_alignment;
+    }
+
+    template <typename T>
+    i_matrix_file_header makeHeader(const std::size_t count, const std::size_t nrows, const std::size_t ncols)
+    {
+        i_matrix_file_header header;
+        header.dtype = i_matrix_file_dtype<T>::value;
+        header.count = count;
+        header.rows = nrows;
+        header.cols = ncols;
+        header.stride = i_dense_matrix<T>::paddedStride(ncols);
+        header.alignment = i_dense_alignment;
+        header.offset = payloadOffset();
+        return header;
+    }
+
+    inline bool readHeader(const std::string &path, i_matrix_file_header &header, std::uint64_t &fileSize, const char *name)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            std::cout << "Error when using " << name << ": cannot open " << path << ".\n";
+            return false;
+        }
+        fileSize = static_cast<std::uint64_t>(file.tellg());
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || !std::equal(header.magic, header.magic + 8, "MMTDENSE"))
+        {
+            std::cout << "Error when using " << name << ": " << path << " is not a matrix file.\n";
+            return false;
+        }
+        if (header.version != i_matrix_file_version)
+        {
+            std::cout << "Error when using " << name << ": unsupported version or byte order in " << path << ".\n";
+            return false;
+        }
+        return true;
+    }
+
+    // dtype, shape & file size agree with each other and with T
+    template <typename T>
+    bool checkHeader(const i_matrix_file_header &header, const std::uint64_t fileSize, const char *name)
+    {
+        if (header.dtype != i_matrix_file_dtype<T>::value)
+        {
+            std::cout << "Error when using " << name << ": element type not match.\n";
+            return false;
+        }
+        // Every product is checked against the file size first, so a damaged shape cannot wrap around
+        std::uint64_t payloadSize{sizeof(T)};
+        bool sizeFits{true};
+        for (const std::uint64_t factor : {header.count, header.rows, header.stride})
+        {
+            sizeFits = sizeFits && (factor == 0 || payloadSize <= fileSize / factor);
+            payloadSize = sizeFits ? payloadSize * factor : 0;
+        }
+        if (!sizeFits || header.stride < header.cols || header.offset < sizeof(i_matrix_file_header) || header.offset > fileSize ||
+            payloadSize > fileSize - header.offset)
+        {
+            std::cout << "Error when using " << name << ": file is truncated or damaged.\n";
+            return false;
+        }
+        return true;
+    }
+
+    // The layout of i_dense_matrix<T> in this build, the mapped pages can be used as they are
+    template <typename T>
+    bool mappable(const i_matrix_file_header &header)
+    {
+        return I_FILE_MMAP && header.stride == i_dense_matrix<T>::paddedStride(header.cols) && header.offset % i_dense_alignment == 0;
+    }
+
+#if I_FILE_MMAP
+    // Owner of a mapped region, shared by every matrix borrowing from it
+    struct mapping
+    {
+        void *address{nullptr};
+        std::size_t length{0};
+
+        mapping(void *addr, const std::size_t len) : address{addr}, length{len} {}
+        mapping(const mapping &) = delete;
+        mapping &operator=(const mapping &) = delete;
+        ~mapping()
+        {
+            ::munmap(address, length);
+        }
+    };
+
+    // Private read-write mapping: reads share the page cache, writes copy the page & never reach the file.
+    // shared = true maps the file itself, writes go to the file
+    inline std::shared_ptr<mapping> mapFile(const std::string &path, const std::size_t length, const char *name, const bool shared = false)
+    {
+        const int fd{::open(path.c_str(), shared ? O_RDWR : O_RDONLY)};
+        void *address{fd < 0 ? MAP_FAILED : ::mmap(nullptr, length, PROT_READ | PROT_WRITE, shared ? MAP_SHARED : MAP_PRIVATE, fd, 0)};
+        if (fd >= 0)
+        {
+            ::close(fd); // The mapping keeps its own reference to the file
+        }
+        if (address == MAP_FAILED)
+        {
+            std::cout << "Error when using " << name << ": cannot map " << path << ".\n";
+            return nullptr;
+        }
+        return std::make_shared<mapping>(address, length);
+    }
+#endif
+
+    // count matrices of rows x cols read one row at a time, any stride in the file
+    template <typename T>
+    std::vector<i_dense_matrix<T>> readMatrices(const std::string &path, const i_matrix_file_header &header, const std::size_t count, const std::size_t nrows, const char *name)
+    {
+        std::ifstream file(path, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(header.offset));
+        std::vector<i_dense_matrix<T>> matrices;
+        const std::streamsize rowBytes{static_cast<std::streamsize>(header.cols * sizeof(T))};
+        const std::streamoff skipBytes{static_cast<std::streamoff>((header.stride - header.cols) * sizeof(T))};
+        for (std::size_t b{0}; b < count; ++b)
+        {
+            i_dense_matrix<T> matG(nrows, header.cols);
+            for (std::size_t i{0}; i < nrows; ++i)
+            {
+                file.read(reinterpret_cast<char *>(matG.row(i)), rowBytes);
+                file.seekg(skipBytes, std::ios::cur);
+            }
+            matrices.push_back(std::move(matG));
+        }
+        if (!file)
+        {
+            std::cout << "Error when using " << name << ": read failed on " << path << ".\n";
+            matrices.clear();
+        }
+        return matrices;
+    }
+
+    // Load as count matrices of rows x cols, zero-copy when the layout allows it
+    template <typename T>
+    std::vector<i_dense_matrix<T>> load(const std::string &path, const bool stacked, const bool allowMap, const char *name)
+    {
+        i_matrix_file_header header;
+        std::uint64_t fileSize{0};
+        if (!readHeader(path, header, fileSize, name) || !checkHeader<T>(header, fileSize, name))
+        {
+            return {};
+        }
+        const std::size_t count{stacked ? header.count : 1}, nrows{stacked ? header.rows : header.count * header.rows};
+        if (!allowMap || !mappable<T>(header) || header.count * header.rows * header.cols == 0)
+        {
+            return readMatrices<T>(path, header, count, nrows, name);
+        }
+        std::vector<i_dense_matrix<T>> matrices;
+#if I_FILE_MMAP
+        const std::shared_ptr<mapping> region{mapFile(path, static_cast<std::size_t>(header.offset + header.count * header.rows * header.stride * sizeof(T)), name)};
+        if (!region)
+        {
+            return matrices;
+        }
+        T *payload{reinterpret_cast<T *>(static_cast<char *>(region->address) + header.offset)};
+        for (std::size_t b{0}; b < count; ++b)
+        {
+            matrices.emplace_back(payload + b * nrows * header.stride, nrows, header.cols, region);
+        }
+#endif
+        return matrices;
+    }
+} // namespace i_matrix_file
+
+// Writes row blocks of cols columns one after another; rowsPerMatrix = 0 makes one matrix of all rows,
+// otherwise a stack of (total rows / rowsPerMatrix) matrices. The header is completed by close() or the destructor.
+template <typename T>
+class i_matrix_file_writer
+{
+public:
+    i_matrix_file_writer(const std::string &path, const std::size_t ncols, const std::size_t rowsPerMatrix = 0)
+        : m_file(path, std::ios::binary | std::ios::trunc), m_cols{ncols}, m_rowsPerMatrix{rowsPerMatrix}
+    {
+        if (!m_file)
+        {
+            std::cout << "Error when using i_matrix_file_writer: cannot open " << path << ".\n";
+            return;
+        }
+        const i_matrix_file_header header{i_matrix_file::makeHeader<T>(0, 0, ncols)};
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        const std::vector<char> gap(header.offset - sizeof(header), 0);
+        m_file.write(gap.data(), static_cast<std::streamsize>(gap.size()));
+    }
+
+    i_matrix_file_writer(const i_matrix_file_writer &) = delete;
+    i_matrix_file_writer &operator=(const i_matrix_file_writer &) = delete;
+
+    ~i_matrix_file_writer()
+    {
+        close();
+    }
+
+    std::size_t rowsWritten() const { return m_rowsWritten; }
+    bool good() const { return static_cast<bool>(m_file); }
+
+    // Append all rows of matBlock, padding included
+    bool write(const i_dense_matrix<T> &matBlock)
+    {
+        if (!m_file.is_open())
+        {
+            std::cout << "Error when using i_matrix_file_writer::write: file is closed.\n";
+            return false;
+        }
+        if (matBlock.cols() != m_cols)
+        {
+            std::cout << "Error when using i_matrix_file_writer::write: column size not match.\n";
+            return false;
+        }
+        m_file.write(reinterpret_cast<const char *>(matBlock.data()), static_cast<std::streamsize>(matBlock.rows() * matBlock.stride() * sizeof(T)));
+        m_rowsWritten += matBlock.rows();
+        return good();
+    }
+
+    // Complete the header; false if a write failed or the rows do not fill whole matrices of a stack
+    bool close()
+    {
+        if (!m_file.is_open())
+        {
+            return false;
+        }
+        bool ok{good()};
+        std::size_t count{m_rowsWritten > 0 ? 1u : 0u}, nrows{m_rowsWritten};
+        if (m_rowsPerMatrix > 0)
+        {
+            ok = ok && m_rowsWritten % m_rowsPerMatrix == 0;
+            count = m_rowsWritten / m_rowsPerMatrix;
+            nrows = m_rowsPerMatrix;
+        }
+        if (!ok)
+        {
+            std::cout << "Error when using i_matrix_file_writer: incomplete file.\n";
+        }
+        const i_matrix_file_header header{i_matrix_file::makeHeader<T>(ok ? count : 0, nrows, m_cols)};
+        m_file.seekp(0);
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        m_file.close();
+        return ok && !m_file.fail();
+    }
+
+private:
+    std::ofstream m_file;
+    std::size_t m_cols{0};
+    std::size_t m_rowsPerMatrix{0};
+    std::size_t m_rowsWritten{0};
+};
+
+template <typename T>
+bool writeMatrixFile(const std::string &path, const i_dense_matrix<T> &matG)
+{
+    i_matrix_file_writer<T> writer(path, matG.cols());
+    return writer.write(matG) && writer.close();
+}
+
+// Same-sized matrices, e.g. one covariance matrix per frequency bin
+template <typename T>
+bool writeMatrixFile(const std::string &path, const std::vector<i_dense_matrix<T>> &matrices)
+{
+    const std::size_t nrows{matrices.empty() ? 0 : matrices[0].rows()}, ncols{matrices.empty() ? 0 : matrices[0].cols()};
+    i_matrix_file_writer<T> writer(path, ncols, std::max<std::size_t>(nrows, 1));
+    for (const i_dense_matrix<T> &matG : matrices)
+    {
+        if (matG.rows() != nrows)
+        {
+            std::cout << "Error when using writeMatrixFile: matrices of a stack must have the same size.\n";
+            return false;
+        }
+        if (!writer.write(matG))
+        {
+            return false;
+        }
+    }
+    return writer.close();
+}
+
+// false (with a message) if path is not a readable matrix file
+inline bool readMatrixFileHeader(const std::string &path, i_matrix_file_header &header)
+{
+    std::uint64_t fileSize{0};
+    return i_matrix_file::readHeader(path, header, fileSize, "readMatrixFileHeader");
+}
+
+// The whole payload as one (count * rows) x cols matrix borrowing the mapped pages, T must match the stored dtype
+template <typename T>
+i_dense_matrix<T> mapMatrixFile(const std::string &path)
+{
+    std::vector<i_dense_matrix<T>> matrices{i_matrix_file::load<T>(path, false, true, "mapMatrixFile")};
+    return matrices.empty() ? i_dense_matrix<T>() : std::move(matrices[0]);
+}
+
+// count matrices of rows x cols, all borrowing from one mapping that lives as long as any of them
+template <typename T>
+std::vector<i_dense_matrix<T>> mapMatrixStack(const std::string &path)
+{
+    return i_matrix_file::load<T>(path, true, true, "mapMatrixStack");
+}
+
+// Owned copy of the whole payload, (count * rows) x cols
+template <typename T>
+i_dense_matrix<T> readMatrixFile(const std::string &path)
+{
+    std::vector<i_dense_matrix<T>> matrices{i_matrix_file::load<T>(path, false, false, "readMatrixFile")};
+    return matrices.empty() ? i_dense_matrix<T>() : std::move(matrices[0]);
+}
+
+// Zero-filled matrix file of nrows x ncols mapped shared: the matrix borrows the file pages, stores reach the file.
+// An existing file at path is replaced. Needs mmap, an empty matrix is returned otherwise
+template <typename T>
+i_dense_matrix<T> createMatrixFile(const std::string &path, const std::size_t nrows, const std::size_t ncols)
+{
+    const i_matrix_file_header header{i_matrix_file::makeHeader<T>(1, nrows, ncols)};
+    const std::size_t length{static_cast<std::size_t>(header.offset + nrows * header.stride * sizeof(T))};
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        if (!file)
+        {
+            std::cout << "Error when using createMatrixFile: cannot write " << path << ".\n";
+            return i_dense_matrix<T>();
+        }
+    }
+#if I_FILE_MMAP
+    if (nrows * ncols == 0)
+    {
+        return i_dense_matrix<T>(nrows, ncols);
+    }
+    if (::truncate(path.c_str(), static_cast<off_t>(length)) != 0) // Holes read as zeros, disk space is used as pages are written
+    {
+        std::cout << "Error when using createMatrixFile: cannot resize " << path << ".\n";
+        return i_dense_matrix<T>();
+    }
+    const std::shared_ptr<i_matrix_file::mapping> region{i_matrix_file::mapFile(path, length, "createMatrixFile", true)};
+    if (!region)
+    {
+        return i_dense_matrix<T>();
+    }
+    return i_dense_matrix<T>(reinterpret_cast<T *>(static_cast<char *>(region->address) + header.offset), nrows, ncols, region);
+#else
+    std::cout << "Error when using createMatrixFile: memory mapping is not available.\n";
+    return i_dense_matrix<T>();
+#endif
+}
@@ -0,0 +1,363 @@
+#pragma once
+/*
+Mini Matrix Tools - Fixed-Size Matrix
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+i_fixed_matrix<T, R, C>: R x C matrix with compile-time dimensions, stored in place (on the stack, no heap
+allocation), row by row. Every loop has constant bounds and is fully unrolled. Dimension errors are compile errors
+(static_assert) instead of the run-time "dimension not match" messages of the dynamic types.
+det & inv use closed forms for 2 x 2, 3 x 3 & 4 x 4 (cofactors; 2 x 2 minors for 4 x 4 [*1]) and partial pivoting
+Gauss-Jordan above that. leftDiv always eliminates with partial pivoting, which is more accurate than inv(A) * B.
+
+Main Function List:
+[1] i_fixed_matrix: Fixed-size matrix, (i, j) access, identity()
+[2] toDenseMatrix / toFixedMatrix: Conversion from / to i_dense_matrix (toFixedMatrix checks the size at run time)
+[3] matMul:         (R x K) * (K x C), mismatched inner sizes do not compile
+[4] transpose:      Conjugate transpose (plain transpose for real matrices)
+[5] det / inv:      Square matrices only; singular inv gives a warning & a zero matrix
+[6] leftDiv:        X = A \ B, square A by partial pivoting elimination, tall A through the normal equations A' * A
+
+Reference:
+[*1] David Eberly, The Laplace Expansion Theorem: Computing the Determinants and Inverses of Matrices, Geometric Tools, 2008
+*/
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <iostream>
+#include "matBasic_dense.hpp"
+
+#if defined(__clang__)
+#define I_FIXED_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define I_FIXED_UNROLL _Pragma("GCC unroll 64")
+#else
+#define I_FIXED_UNROLL
+#endif
+
+template <typename T, std::size_t R, std::size_t C>
+class i_fixed_matrix
+{
+    static_assert(R > 0 && C > 0, "i_fixed_matrix: dimensions must be positive");
+
+public:
+    constexpr i_fixed_matrix() = default;
+
+    constexpr explicit i_fixed_matrix(const T initValue)
+    {
+        for (std::size_t p{0}; p < R * C; ++p)
+        {
+            m_data[p] = initValue;
+        }
+    }
+
+    // i_fixed_matrix<i_float_t, 2, 2> matA({{1.0, 2.0}, {3.0, 4.0}});
+    constexpr i_fixed_matrix(const T (&values)[R][C])
+    {
+        for (std::size_t i{0}; i < R; ++i)
+        {
+            for (std::size_t j{0}; j < C; ++j)
+            {
+                m_data[i * C + j] = values[i][j];
+            }
+        }
+    }
+
+    static constexpr std::size_t rows() { return R; }
+    static constexpr std::size_t cols() { return C; }
+
+    constexpr T &operator()(const std::size_t i, const std::size_t j) { return m_data[i * C + j]; }
+    constexpr const T &operator()(const std::size_t i, const std::size_t j) const { return m_data[i * C + j]; }
+    T *data() { return m_data; }
+    const T *data() const { return m_data; }
+
+    static constexpr i_fixed_matrix identity()
+    {
+        static_assert(R == C, "i_fixed_matrix::identity: matrix is not square");
+        i_fixed_matrix resMat;
+        for (std::size_t i{0}; i < R; ++i)
+        {
+            resMat(i, i) = T{1};
+        }
+        return resMat;
+    }
+
+private:
+    T m_data[R * C]{};
+};
+
+template <typename T, std::size_t R, std::size_t C>
+i_dense_matrix<T> toDenseMatrix(const i_fixed_matrix<T, R, C> &matA)
+{
+    i_dense_matrix<T> resMat(R, C);
+    for (std::size_t i{0}; i < R; ++i)
+    {
+        std::copy_n(matA.data() + i * C, C, resMat.row(i));
+    }
+    return resMat;
+}
+
+// toFixedMatrix<R, C>(matA); a size mismatch gives an error & a zero matrix
+template <std::size_t R, std::size_t C, typename T>
+i_fixed_matrix<T, R, C> toFixedMatrix(const i_dense_matrix<T> &matA)
+{
+    i_fixed_matrix<T, R, C> resMat;
+    if (matA.rows() != R || matA.cols() != C)
+    {
+        std::cout << "Error when using toFixedMatrix: dimension not match.\n";
+        return resMat;
+    }
+    for (std::size_t i{0}; i < R; ++i)
+    {
+        std::copy_n(matA.row(i), C, resMat.data() + i * C);
+    }
+    return resMat;
+}
+
+template <typename T, std::size_t R, std::size_t K1, std::size_t K2, std::size_t C>
+i_fixed_matrix<T, R, C> matMul(const i_fixed_matrix<T, R, K1> &matA, const i_fixed_matrix<T, K2, C> &matB)
+{
+    static_assert(K1 == K2, "matMul: dimension not match (columns of A != rows of B)");
+    i_fixed_matrix<T, R, C> resMat;
+    I_FIXED_UNROLL
+    for (std::size_t i{0}; i < R; ++i)
+    {
+        I_FIXED_UNROLL
+        for (std::size_t k{0}; k < K1; ++k)
+        {
+            const T valA{matA(i, k)};
+            I_FIXED_UNROLL
+            for (std::size_t j{0}; j < C; ++j)
+            {
+                resMat(i, j) += valA * matB(k, j);
+            }
+        }
+    }
+    return resMat;
+}
+
+template <typename T, std::size_t R, std::size_t C>
+i_fixed_matrix<T, C, R> transpose(const i_fixed_matrix<T, R, C> &matG)
+{
+    i_fixed_matrix<T, C, R> matGt;
+    I_FIXED_UNROLL
+    for (std::size_t i{0}; i < R; ++i)
+    {
+        I_FIXED_UNROLL
+        for (std::size_t j{0}; j < C; ++j)
+        {
+            matGt(j, i) = conjScalar(matG(i, j));
+        }
+    }
+    return matGt;
+}
+
+namespace i_kernel
+{
+    // B = A \ B by Gauss-Jordan elimination with partial pivoting on a copy of A; false if A is singular (B is then partly updated).
+    // det gets sign(P) * prod(diag(U)), zero for a singular A
+    template <typename T, std::size_t N, std::size_t K>
+    bool fixedGaussSolve(i_fixed_matrix<T, N, N> matA, i_fixed_matrix<T, N, K> &matB, T &detA)
+    {
+        detA = T{1};
+        I_FIXED_UNROLL
+        for (std::size_t k{0}; k < N; ++k)
+        {
+            std::size_t pivot{k};
+            auto maxv{std::abs(matA(k, k))};
+            for (std::size_t i{k + 1}; i < N; ++i)
+            {
+                const auto value{std::abs(matA(i, k))};
+                if (value > maxv)
+                {
+                    maxv = value;
+                    pivot = i;
+                }
+            }
+            if (maxv == 0)
+            {
+                detA = T{};
+                return false;
+            }
+            if (pivot != k)
+            {
+                std::swap_ranges(matA.data() + k * N, matA.data() + (k + 1) * N, matA.data() + pivot * N);
+                std::swap_ranges(matB.data() + k * K, matB.data() + (k + 1) * K, matB.data() + pivot * K);
+                detA = -detA;
+            }
+            detA *= matA(k, k);
+            const T reciprocal{T{1} / matA(k, k)};
+            I_FIXED_UNROLL
+            for (std::size_t j{k + 1}; j < N; ++j)
+            {
+                matA(k, j) *= reciprocal; // Pivot row scaled to a unit diagonal
+            }
+            I_FIXED_UNROLL
+            for (std::size_t j{0}; j < K; ++j)
+            {
+                matB(k, j) *= reciprocal;
+            }
+            I_FIXED_UNROLL
+            for (std::size_t i{0}; i < N; ++i)
+            {
+                if (i == k)
+                {
+                    continue;
+                }
+                const T factor{matA(i, k)};
+                I_FIXED_UNROLL
+                for (std::size_t j{k + 1}; j < N; ++j)
+                {
+                    matA(i, j) -= factor * matA(k, j);
+                }
+                I_FIXED_UNROLL
+                for (std::size_t j{0}; j < K; ++j)
+                {
+                    matB(i, j) -= factor * matB(k, j);
+                }
+            }
+        }
+        return true;
+    }
+} // namespace i_kernel
+
+template <typename T, std::size_t R, std::size_t C>
+T det(const i_fixed_matrix<T, R, C> &matA)
+{
+    static_assert(R == C, "det: matrix is not square");
+    const i_fixed_matrix<T, R, C> &a{matA};
+    if constexpr (R == 1)
+    {
+        return a(0, 0);
+    }
+    else if constexpr (R == 2)
+    {
+        return a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+    }
+    else if constexpr (R == 3)
+    {
+        return a(0, 0) * (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1)) - a(0, 1) * (a(1, 0) * a(2, 2) - a(1, 2) * a(2, 0)) + a(0, 2) * (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0));
+    }
+    else if constexpr (R == 4)
+    {
+        // Laplace expansion along the first two rows: 2 x 2 minors of rows 0-1 times the complementary ones of rows 2-3 [*1]
+        const T s0{a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1)}, s1{a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2)}, s2{a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3)};
+        const T s3{a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2)}, s4{a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3)}, s5{a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3)};
+        const T c5{a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3)}, c4{a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3)}, c3{a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2)};
+        const T c2{a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3)}, c1{a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2)}, c0{a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1)};
+        return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    }
+    else
+    {
+        i_fixed_matrix<T, R, 1> matNone;
+        T detA{};
+        i_kernel::fixedGaussSolve(matA, matNone, detA);
+        return detA;
+    }
+}
+
+template <typename T, std::size_t R, std::size_t C>
+i_fixed_matrix<T, R, C> inv(const i_fixed_matrix<T, R, C> &matA)
+{
+    static_assert(R == C, "inv: matrix is not square");
+    const i_fixed_matrix<T, R, C> &a{matA};
+    i_fixed_matrix<T, R, C> resMat;
+    const auto singular = []() {
+        std::cout << "Warning when using inv: matrix is singular.\n";
+        return i_fixed_matrix<T, R, C>();
+    };
+    if constexpr (R <= 4)
+    {
+        const T detA{det(matA)};
+        if (detA == T{})
+        {
+            return singular();
+        }
+        const T invDet{T{1} / detA};
+        if constexpr (R == 1)
+        {
+            resMat(0, 0) = invDet;
+        }
+        else if constexpr (R == 2)
+        {
+            resMat = i_fixed_matrix<T, R, C>({{a(1, 1) * invDet, -a(0, 1) * invDet}, {-a(1, 0) * invDet, a(0, 0) * invDet}});
+        }
+        else if constexpr (R == 3)
+        {
+            // Adjugate: transposed cofactors
+            resMat(0, 0) = (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1)) * invDet;
+            resMat(0, 1) = (a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2)) * invDet;
+            resMat(0, 2) = (a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1)) * invDet;
+            resMat(1, 0) = (a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2)) * invDet;
+            resMat(1, 1) = (a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0)) * invDet;
+            resMat(1, 2) = (a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2)) * invDet;
+            resMat(2, 0) = (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0)) * invDet;
+            resMat(2, 1) = (a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1)) * invDet;
+            resMat(2, 2) = (a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0)) * invDet;
+        }
+        else
+        {
+            // Adjugate from the same 2 x 2 minors as det [*1]
+            const T s0{a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1)}, s1{a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2)}, s2{a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3)};
+            const T s3{a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2)}, s4{a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3)}, s5{a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3)};
+            const T c5{a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3)}, c4{a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3)}, c3{a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2)};
+            const T c2{a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3)}, c1{a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2)}, c0{a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1)};
+            resMat(0, 0) = (a(1, 1) * c5 - a(1, 2) * c4 + a(1, 3) * c3) * invDet;
+            resMat(0, 1) = (-a(0, 1) * c5 + a(0, 2) * c4 - a(0, 3) * c3) * invDet;
+            resMat(0, 2) = (a(3, 1) * s5 - a(3, 2) * s4 + a(3, 3) * s3) * invDet;
+            resMat(0, 3) = (-a(2, 1) * s5 + a(2, 2) * s4 - a(2, 3) * s3) * invDet;
+            resMat(1, 0) = (-a(1, 0) * c5 + a(1, 2) * c2 - a(1, 3) * c1) * invDet;
+            resMat(1, 1) = (a(0, 0) * c5 - a(0, 2) * c2 + a(0, 3) * c1) * invDet;
+            resMat(1, 2) = (-a(3, 0) * s5 + a(3, 2) * s2 - a(3, 3) * s1) * invDet;
+            resMat(1, 3) = (a(2, 0) * s5 - a(2, 2) * s2 + a(2, 3) * s1) * invDet;
+            resMat(2, 0) = (a(1, 0) * c4 - a(1, 1) * c2 + a(1, 3) * c0) * invDet;
+            resMat(2, 1) = (-a(0, 0) * c4 + a(0, 1) * c2 - a(0, 3) * c0) * invDet;
+            resMat(2, 2) = (a(3, 0) * s4 - a(3, 1) * s2 + a(3, 3) * s0) * invDet;
+            resMat(2, 3) = (-a(2, 0) * s4 + a(2, 1) * s2 - a(2, 3) * s0) * invDet;
+            resMat(3, 0) = (-a(1, 0) * c3 + a(1, 1) * c1 - a(1, 2) * c0) * invDet;
+            resMat(3, 1) = (a(0, 0) * c3 - a(0, 1) * c1 + a(0, 2) * c0) * invDet;
+            resMat(3, 2) = (-a(3, 0) * s3 + a(3, 1) * s1 - a(3, 2) * s0) * invDet;
+            resMat(3, 3) = (a(2, 0) * s3 - a(2, 1) * s1 + a(2, 2) * s0) * invDet;
+        }
+        return resMat;
+    }
+    else
+    {
+        resMat = i_fixed_matrix<T, R, C>::identity();
+        T detA{};
+        if (!i_kernel::fixedGaussSolve(matA, resMat, detA))
+        {
+            return singular();
+        }
+        return resMat;
+    }
+}
+
+// X = A \ B: square A by partial pivoting elimination, tall A (R > C) by the normal equations A' * A * X = A' * B
+template <typename T, std::size_t R, std::size_t C, std::size_t RB, std::size_t K>
+i_fixed_matrix<T, C, K> leftDiv(const i_fixed_matrix<T, R, C> &matA, const i_fixed_matrix<T, RB, K> &matB)
+{
+    static_assert(R == RB, "leftDiv: row size not match");
+    static_assert(R >= C, "leftDiv: fixed-size version needs rows(A) >= cols(A)");
+    i_fixed_matrix<T, C, K> resMat;
+    T detA{};
+    bool solved{false};
+    if constexpr (R == C)
+    {
+        resMat = matB;
+        solved = i_kernel::fixedGaussSolve(matA, resMat, detA);
+    }
+    else
+    {
+        const i_fixed_matrix<T, C, R> matAt{transpose(matA)};
+        resMat = matMul(matAt, matB);
+        solved = i_kernel::fixedGaussSolve(matMul(matAt, matA), resMat, detA);
+    }
+    if (!solved)
+    {
+        std::cout << "Warning when using leftDiv: matrix is singular.\n";
+        return i_fixed_matrix<T, C, K>();
+    }
+    return resMat;
+}
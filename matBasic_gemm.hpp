@@ -0,0 +1,343 @@
+#pragma once
+/*
+Mini Matrix Tools - Blocked GEMM Engine
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+C += alpha * op(A) * op(B), op(X) = X or X' (conjugate transpose), for real & complex matrices.
+Goto/BLIS style loop nest [*1][*2]:
+    jc (NC columns of B, L3) -> pc (KC depth, packed B panel) -> ic (MC rows of A, L2, packed A block)
+    -> jr (NR columns, L1) -> ir (MR rows) -> MR x NR register micro-kernel
+Large products are split into slices of C on the thread pool (see matBasic_thread.hpp), each thread packing its own blocks.
+
+Main Function List:
+[1] i_kernel::gemm:        Packed, cache-blocked multiply-accumulate around the dispatched micro-kernel
+[2] i_kernel::gemmNaive:   Unpacked i-k-j loop used for small products
+[3] i_kernel::gemv:        Matrix-vector path for products with very few columns (e.g. one right-hand side)
+[4] i_kernel::herk:        Lower triangle of C += alpha * op(A) * op(A)' (SYRK for real, HERK for complex), used for Gram matrices
+
+Reference:
+[*1] Kazushige Goto, Robert van de Geijn, Anatomy of High-Performance Matrix Multiplication, ACM TOMS 34(3), 2008
+[*2] Field G. Van Zee, Robert A. van de Geijn, BLIS: A Framework for Rapidly Instantiating BLAS Functionality, ACM TOMS 41(3), 2015
+*/
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include "matBasic_dense.hpp"
+#include "matBasic_simd.hpp"
+#include "matBasic_thread.hpp"
+
+// Cache block sizes, in elements. KC x NR (B micro-panel) stays in L1, MC x KC (A block) in L2, KC x NC (B panel) in L3.
+// MR & NR (register tile) come from the micro-kernel picked at run time, see matBasic_simd.hpp; MC is a multiple of all of them
+template <typename T>
+struct i_gemm_blocking
+{
+    static constexpr std::size_t KC{256};
+    static constexpr std::size_t MC{96};
+    static constexpr std::size_t NC{2048};
+};
+
+// Half-size elements: the float micro-kernels are twice as wide, so KC x NR keeps its bytes, & twice the rows of A fit in L2
+template <>
+struct i_gemm_blocking<float>
+{
+    static constexpr std::size_t KC{256};
+    static constexpr std::size_t MC{192};
+    static constexpr std::size_t NC{4096};
+};
+
+template <typename T>
+struct i_gemm_blocking<std::complex<T>>
+{
+    static constexpr std::size_t KC{128};
+    static constexpr std::size_t MC{72};
+    static constexpr std::size_t NC{1024};
+};
+
+namespace i_kernel
+{
+    constexpr std::size_t gemmNaiveLimit{32 * 32 * 32}; // m * n * k below this skips packing
+    constexpr std::size_t gemmSkinnyLimit{4};            // n below this runs column by column (matrix-vector products)
+    constexpr std::size_t gemmParallelGrain{48};         // Smallest slice of C (rows or columns) handed to one thread
+
+    // Element (i, j) of op(X), X stored row-major with leading dimension ld
+    template <typename T>
+    T opElement(const T *matX, const std::size_t ld, const bool adjoint, const std::size_t i, const std::size_t j)
+    {
+        return adjoint ? conjScalar(matX[j * ld + i]) : matX[i * ld + j];
+    }
+
+    // C += alpha * op(A) * op(B) without packing, i-k-j order
+    template <typename T>
+    void gemmNaive(const std::size_t m, const std::size_t n, const std::size_t k,
+                   const T *matA, const std::size_t lda, const bool adjA,
+                   const T *matB, const std::size_t ldb, const bool adjB,
+                   T *matC, const std::size_t ldc, const T alpha = T{1})
+    {
+        for (std::size_t i{0}; i < m; ++i)
+        {
+            T *rowC{matC + i * ldc};
+            for (std::size_t p{0}; p < k; ++p)
+            {
+                const T valA{alpha * opElement(matA, lda, adjA, i, p)};
+                if (!adjB)
+                {
+                    const T *rowB{matB + p * ldb};
+                    axpy(n, valA, rowB, rowC);
+                }
+                else
+                {
+                    for (std::size_t j{0}; j < n; ++j)
+                    {
+                        rowC[j] += valA * conjScalar(matB[j * ldb + p]);
+                    }
+                }
+            }
+        }
+    }
+
+    // C(:, j) += alpha * op(A) * op(B)(:, j): dot products with a contiguous copy of the column, or row axpys when op(A) = A'
+    template <typename T>
+    void gemv(const std::size_t m, const std::size_t k, const std::size_t j,
+              const T *matA, const std::size_t lda, const bool adjA,
+              const T *matB, const std::size_t ldb, const bool adjB,
+              T *matC, const std::size_t ldc, const T alpha)
+    {
+        i_aligned_vector<T> vecX(k);
+        for (std::size_t p{0}; p < k; ++p)
+        {
+            vecX[p] = opElement(matB, ldb, adjB, p, j);
+        }
+        if (!adjA)
+        {
+            for (std::size_t i{0}; i < m; ++i)
+            {
+                matC[i * ldc + j] += alpha * dot(k, matA + i * lda, vecX.data());
+            }
+            return;
+        }
+        i_aligned_vector<T> vecY(m); // conj(A' * x) = sum of conj(x(p)) * A(p, :)
+        for (std::size_t p{0}; p < k; ++p)
+        {
+            axpy(m, conjScalar(vecX[p]), matA + p * lda, vecY.data());
+        }
+        for (std::size_t i{0}; i < m; ++i)
+        {
+            matC[i * ldc + j] += alpha * conjScalar(vecY[i]);
+        }
+    }
+
+    // Pack op(A)(ic:ic+mc, pc:pc+kc) into MR-row micro-panels: panel-major, then k, then row. Edges are zero padded
+    template <typename T>
+    void packBlockA(const T *matA, const std::size_t lda, const bool adjA, const std::size_t MR,
+                    const std::size_t ic, const std::size_t pc, const std::size_t mc, const std::size_t kc, T *packA)
+    {
+        for (std::size_t ir{0}; ir < mc; ir += MR)
+        {
+            const std::size_t mr{std::min(MR, mc - ir)};
+            for (std::size_t p{0}; p < kc; ++p)
+            {
+                std::size_t i{0};
+                for (; i < mr; ++i)
+                {
+                    packA[i] = opElement(matA, lda, adjA, ic + ir + i, pc + p);
+                }
+                for (; i < MR; ++i)
+                {
+                    packA[i] = T{};
+                }
+                packA += MR;
+            }
+        }
+    }
+
+    // Pack op(B)(pc:pc+kc, jc:jc+nc) into NR-column micro-panels: panel-major, then k, then column. Edges are zero padded
+    template <typename T>
+    void packPanelB(const T *matB, const std::size_t ldb, const bool adjB, const std::size_t NR,
+                    const std::size_t pc, const std::size_t jc, const std::size_t kc, const std::size_t nc, T *packB)
+    {
+        for (std::size_t jr{0}; jr < nc; jr += NR)
+        {
+            const std::size_t nr{std::min(NR, nc - jr)};
+            for (std::size_t p{0}; p < kc; ++p)
+            {
+                std::size_t j{0};
+                if (!adjB)
+                {
+                    const T *rowB{matB + (pc + p) * ldb + jc + jr};
+                    for (; j < nr; ++j)
+                    {
+                        packB[j] = rowB[j];
+                    }
+                }
+                else
+                {
+                    for (; j < nr; ++j)
+                    {
+                        packB[j] = conjScalar(matB[(jc + jr + j) * ldb + pc + p]);
+                    }
+                }
+                for (; j < NR; ++j)
+                {
+                    packB[j] = T{};
+                }
+                packB += NR;
+            }
+        }
+    }
+
+    // Goto loop nest around the micro-kernel. lowerOnly: only C(i, j) with j <= i + rowOffset is computed (lower triangle of a
+    // larger C whose row rowOffset is row 0 here), tiles above that diagonal are skipped, tiles crossing it go through a scratch tile
+    template <typename T>
+    void gemmBlocked(const std::size_t m, const std::size_t n, const std::size_t k,
+                     const T *matA, const std::size_t lda, const bool adjA,
+                     const T *matB, const std::size_t ldb, const bool adjB,
+                     T *matC, const std::size_t ldc, const T alpha, const bool lowerOnly, const std::size_t rowOffset = 0)
+    {
+        using blocking = i_gemm_blocking<T>;
+        constexpr std::size_t KC{blocking::KC}, MC{blocking::MC}, NC{blocking::NC};
+        const i_gemm_micro<T> micro{gemmMicroKernel<T>()};
+        const std::size_t MR{micro.MR}, NR{micro.NR};
+        // Packing buffers are kept per thread & only grow: a fresh large allocation per call costs page faults & zero fills
+        thread_local i_aligned_vector<T> packA, packB;
+        packA.resize(std::max(packA.size(), (MC + MR - 1) / MR * MR * KC));
+        packB.resize(std::max(packB.size(), KC * ((std::min(NC, n) + NR - 1) / NR * NR)));
+        i_aligned_vector<T> tile(lowerOnly ? MR * NR : 0);
+        for (std::size_t jc{0}; jc < n; jc += NC)
+        {
+            const std::size_t nc{std::min(NC, n - jc)};
+            for (std::size_t pc{0}; pc < k; pc += KC)
+            {
+                const std::size_t kc{std::min(KC, k - pc)};
+                packPanelB(matB, ldb, adjB, NR, pc, jc, kc, nc, packB.data());
+                for (std::size_t ic{0}; ic < m; ic += MC)
+                {
+                    const std::size_t mc{std::min(MC, m - ic)};
+                    if (lowerOnly && rowOffset + ic + mc <= jc)
+                    {
+                        continue; // Whole block above the diagonal
+                    }
+                    packBlockA(matA, lda, adjA, MR, ic, pc, mc, kc, packA.data());
+                    for (std::size_t jr{0}; jr < nc; jr += NR)
+                    {
+                        const std::size_t nr{std::min(NR, nc - jr)};
+                        for (std::size_t ir{0}; ir < mc; ir += MR)
+                        {
+                            const std::size_t mr{std::min(MR, mc - ir)};
+                            const std::size_t row0{rowOffset + ic + ir}, col0{jc + jr};
+                            T *tileC{matC + (ic + ir) * ldc + col0};
+                            if (!lowerOnly || col0 + nr <= row0 + 1)
+                            {
+                                micro.kernel(kc, packA.data() + ir * kc, packB.data() + jr * kc, tileC, ldc, mr, nr, alpha);
+                            }
+                            else if (col0 < row0 + mr)
+                            {
+                                std::fill(tile.begin(), tile.end(), T{});
+                                micro.kernel(kc, packA.data() + ir * kc, packB.data() + jr * kc, tile.data(), NR, mr, nr, alpha);
+                                for (std::size_t i{0}; i < mr; ++i)
+                                {
+                                    for (std::size_t j{0}; j < nr && col0 + j <= row0 + i; ++j)
+                                    {
+                                        tileC[i * ldc + j] += tile[i * NR + j];
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // C (m x n, leading dimension ldc) += alpha * op(A) * op(B), op(A) is m x k, op(B) is k x n
+    template <typename T>
+    void gemm(const std::size_t m, const std::size_t n, const std::size_t k,
+              const T *matA, const std::size_t lda, const bool adjA,
+              const T *matB, const std::size_t ldb, const bool adjB,
+              T *matC, const std::size_t ldc, const T alpha = T{1})
+    {
+        if (m == 0 || n == 0 || k == 0)
+        {
+            return;
+        }
+        if (n < gemmSkinnyLimit)
+        {
+            for (std::size_t j{0}; j < n; ++j)
+            {
+                gemv(m, k, j, matA, lda, adjA, matB, ldb, adjB, matC, ldc, alpha);
+            }
+            return;
+        }
+        if (m * n * k < gemmNaiveLimit)
+        {
+            gemmNaive(m, n, k, matA, lda, adjA, matB, ldb, adjB, matC, ldc, alpha);
+            return;
+        }
+        if (threadCount() == 1 || m * n * k < i_parallel_min_work)
+        {
+            gemmBlocked(m, n, k, matA, lda, adjA, matB, ldb, adjB, matC, ldc, alpha, false);
+            return;
+        }
+        // Independent slices of C, each thread packs its own blocks: split the longer side
+        if (m >= n)
+        {
+            parallelFor(0, m, gemmParallelGrain, [&](const std::size_t b, const std::size_t e) {
+                gemmBlocked(e - b, n, k, adjA ? matA + b : matA + b * lda, lda, adjA, matB, ldb, adjB, matC + b * ldc, ldc, alpha, false);
+            });
+        }
+        else
+        {
+            parallelFor(0, n, gemmParallelGrain, [&](const std::size_t b, const std::size_t e) {
+                gemmBlocked(m, e - b, k, matA, lda, adjA, adjB ? matB + b * ldb : matB + b, ldb, adjB, matC + b, ldc, alpha, false);
+            });
+        }
+    }
+
+    // Lower triangle of C (n x n) += alpha * op(A) * op(A)', op(A) is n x k: A (adjA = false, C = A * A') or A' (adjA = true, C = A' * A).
+    // Same packed loop nest as gemm, micro-tiles above the diagonal are never computed; the strict upper triangle of C is not touched
+    template <typename T>
+    void herk(const std::size_t n, const std::size_t k, const T *matA, const std::size_t lda, const bool adjA,
+              T *matC, const std::size_t ldc, const T alpha = T{1})
+    {
+        if (n == 0 || k == 0)
+        {
+            return;
+        }
+        if (n < gemmSkinnyLimit || n * n * k < gemmNaiveLimit)
+        {
+            i_dense_matrix<T> matD(n, n);
+            gemm(n, n, k, matA, lda, adjA, matA, lda, !adjA, matD.data(), matD.stride(), alpha);
+            for (std::size_t i{0}; i < n; ++i)
+            {
+                for (std::size_t j{0}; j <= i; ++j)
+                {
+                    matC[i * ldc + j] += matD(i, j);
+                }
+            }
+            return;
+        }
+        const std::size_t nthreads{threadCount()};
+        if (nthreads == 1 || n * n * k / 2 < i_parallel_min_work)
+        {
+            gemmBlocked(n, n, k, matA, lda, adjA, matA, lda, !adjA, matC, ldc, alpha, true);
+            return;
+        }
+        // Row slices of equal triangle area: slice t ends at row n * sqrt((t + 1) / nslices)
+        const std::size_t nslices{std::min(nthreads * 2, std::max<std::size_t>(1, n / gemmParallelGrain))};
+        const auto sliceEnd = [n, nslices](const std::size_t t) {
+            const std::size_t rowEnd{static_cast<std::size_t>(static_cast<double>(n) * std::sqrt(static_cast<double>(t) / static_cast<double>(nslices)))};
+            return t == nslices ? n : std::min(n, (rowEnd + gemmParallelGrain - 1) / gemmParallelGrain * gemmParallelGrain);
+        };
+        parallelFor(0, nslices, 1, [&](const std::size_t tb, const std::size_t te) {
+            for (std::size_t t{tb}; t < te; ++t)
+            {
+                const std::size_t b{sliceEnd(t)}, e{sliceEnd(t + 1)};
+                if (e > b)
+                {
+                    gemmBlocked(e - b, e, k, adjA ? matA + b : matA + b * lda, lda, adjA, matA, lda, !adjA, matC + b * ldc, ldc, alpha, true, b);
+                }
+            }
+        });
+    }
+} // namespace i_kernel
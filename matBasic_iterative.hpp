@@ -0,0 +1,408 @@
+#pragma once
+/*
+Mini Matrix Tools - Matrix-Free Iterative Least Squares
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+x = argmin ||A * x - b|| using only y = A * x and y = A' * x, never a factorization. A is any i_linear_operator:
+a dense or CSR matrix (i_dense_operator, i_sparse_operator) or a user supplied pair of functions (i_function_operator).
+All solvers warm-start: x comes in as the initial guess (zero if empty) and the correction to it is solved for,
+so a guess that is already close converges in a handful of iterations.
+Iterations stop once ||A' * r|| <= tolerance * ||A' * b|| (r = b - A * x) or after maxIterations
+(0: 2 * cols(A)). The tolerance defaults to defaultTolerance<T>(), so float solves stop at a reachable level.
+Every right-hand side column is solved on its own.
+
+Main Function List:
+[1] cgls: Conjugate gradient on the normal equations A' * A * x = A' * b, A' * A is never formed [*1]
+[2] lsqr: Golub-Kahan bidiagonalization, CG-equivalent in exact arithmetic but more stable [*2]
+[3] lsmr: Same bidiagonalization, ||A' * r|| decreases monotonically, safer to stop early [*3]
+
+Reference:
+[*1] Ake Bjorck, Numerical Methods for Least Squares Problems, SIAM 1996, section 7.4 (CGLS)
+[*2] Christopher C. Paige, Michael A. Saunders, LSQR: An Algorithm for Sparse Linear Equations and Sparse Least Squares, ACM TOMS 8(1), 1982
+[*3] David Chin-Lung Fong, Michael A. Saunders, LSMR: An Iterative Algorithm for Sparse Least-Squares Problems, SIAM J. Sci. Comput. 33(5), 2011
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_gemm.hpp"
+#include "matBasic_sparse.hpp"
+
+// y = A * x & y = A' * x (conjugate transpose), x & y contiguous vectors; y is overwritten
+template <typename T>
+class i_linear_operator
+{
+public:
+    virtual ~i_linear_operator() = default;
+    virtual std::size_t rows() const = 0;
+    virtual std::size_t cols() const = 0;
+    virtual void apply(const T *x, T *y) const = 0;
+    virtual void applyAdjoint(const T *x, T *y) const = 0;
+};
+
+// Views a dense matrix, which must outlive the operator
+template <typename T>
+class i_dense_operator : public i_linear_operator<T>
+{
+public:
+    explicit i_dense_operator(const i_dense_matrix<T> &matA) : m_matA{&matA} {}
+
+    std::size_t rows() const override { return m_matA->rows(); }
+    std::size_t cols() const override { return m_matA->cols(); }
+
+    void apply(const T *x, T *y) const override
+    {
+        std::fill_n(y, rows(), T{});
+        i_kernel::gemm(rows(), 1, cols(), m_matA->data(), m_matA->stride(), false, x, 1, false, y, 1);
+    }
+
+    void applyAdjoint(const T *x, T *y) const override
+    {
+        std::fill_n(y, cols(), T{});
+        i_kernel::gemm(cols(), 1, rows(), m_matA->data(), m_matA->stride(), true, x, 1, false, y, 1);
+    }
+
+private:
+    const i_dense_matrix<T> *m_matA;
+};
+
+// Views a CSR matrix, which must outlive the operator; both products cost O(nnz)
+template <typename T>
+class i_sparse_operator : public i_linear_operator<T>
+{
+public:
+    explicit i_sparse_operator(const i_csr_matrix<T> &matA) : m_matA{&matA} {}
+
+    std::size_t rows() const override { return m_matA->rows(); }
+    std::size_t cols() const override { return m_matA->cols(); }
+
+    void apply(const T *x, T *y) const override
+    {
+        const std::vector<std::size_t> &rowPtr{m_matA->rowPtr()}, &colIndex{m_matA->colIndex()};
+        const std::vector<T> &values{m_matA->values()};
+        for (std::size_t i{0}; i < rows(); ++i)
+        {
+            T sum{};
+            for (std::size_t p{rowPtr[i]}; p < rowPtr[i + 1]; ++p)
+            {
+                sum += values[p] * x[colIndex[p]];
+            }
+            y[i] = sum;
+        }
+    }
+
+    void applyAdjoint(const T *x, T *y) const override
+    {
+        const std::vector<std::size_t> &rowPtr{m_matA->rowPtr()}, &colIndex{m_matA->colIndex()};
+        const std::vector<T> &values{m_matA->values()};
+        std::fill_n(y, cols(), T{});
+        for (std::size_t i{0}; i < rows(); ++i)
+        {
+            for (std::size_t p{rowPtr[i]}; p < rowPtr[i + 1]; ++p)
+            {
+                y[colIndex[p]] += conjScalar(values[p]) * x[i];
+            }
+        }
+    }
+
+private:
+    const i_csr_matrix<T> *m_matA;
+};
+
+// Structured operators (FFTs, Kronecker products, ...) given as two functions
+template <typename T>
+class i_function_operator : public i_linear_operator<T>
+{
+public:
+    using product_t = std::function<void(const T *, T *)>;
+
+    i_function_operator(const std::size_t nrows, const std::size_t ncols, product_t apply, product_t applyAdjoint)
+        : m_rows{nrows}, m_cols{ncols}, m_apply{std::move(apply)}, m_applyAdjoint{std::move(applyAdjoint)}
+    {
+    }
+
+    std::size_t rows() const override { return m_rows; }
+    std::size_t cols() const override { return m_cols; }
+    void apply(const T *x, T *y) const override { m_apply(x, y); }
+    void applyAdjoint(const T *x, T *y) const override { m_applyAdjoint(x, y); }
+
+private:
+    std::size_t m_rows;
+    std::size_t m_cols;
+    product_t m_apply;
+    product_t m_applyAdjoint;
+};
+
+struct i_iterative_info
+{
+    std::size_t iterations{0};  // Largest iteration count over the right-hand sides
+    double normalResidual{0.0}; // Largest final ||A' * r|| / ||A' * b||
+    bool converged{false};      // Every right-hand side met the tolerance
+};
+
+namespace i_iterative
+{
+    template <typename T>
+    using vector_t = std::vector<T>;
+
+    template <typename T>
+    typename i_real_type<T>::type norm2(const vector_t<T> &x)
+    {
+        return std::sqrt(std::real(i_kernel::dotc(x.size(), x.data(), x.data())));
+    }
+
+    template <typename T>
+    void scale(vector_t<T> &x, const T value)
+    {
+        for (T &element : x)
+        {
+            element *= value;
+        }
+    }
+
+    // One least squares solve for a single right-hand side: x (initial guess in, solution out)
+    template <typename T>
+    struct problem
+    {
+        using real_t = typename i_real_type<T>::type;
+
+        const i_linear_operator<T> &opA;
+        vector_t<T> r;     // b - A * x0
+        real_t normalRhs;  // ||A' * b||, the scale of the stopping test
+        real_t tolerance;
+        std::size_t maxIterations;
+
+        bool done(const real_t normalResidual) const { return normalResidual <= tolerance * normalRhs; }
+    };
+
+    // r = b - A * x0 and ||A' * b||, shared set-up of the three solvers
+    template <typename T>
+    problem<T> setUp(const i_linear_operator<T> &opA, const vector_t<T> &b, const vector_t<T> &x,
+                     const typename i_real_type<T>::type tolerance, const std::size_t maxIterations)
+    {
+        problem<T> prob{opA, vector_t<T>(opA.rows()), 0, tolerance, maxIterations == 0 ? 2 * opA.cols() : maxIterations};
+        vector_t<T> work(opA.cols());
+        opA.applyAdjoint(b.data(), work.data());
+        prob.normalRhs = norm2(work);
+        opA.apply(x.data(), prob.r.data());
+        for (std::size_t i{0}; i < b.size(); ++i)
+        {
+            prob.r[i] = b[i] - prob.r[i];
+        }
+        return prob;
+    }
+
+    template <typename T>
+    double cgls(const problem<T> &prob, vector_t<T> &x, std::size_t &iterations)
+    {
+        using real_t = typename i_real_type<T>::type;
+        const i_linear_operator<T> &opA{prob.opA};
+        vector_t<T> r{prob.r}, s(opA.cols()), q(opA.rows());
+        opA.applyAdjoint(r.data(), s.data());
+        vector_t<T> p{s};
+        real_t gamma{norm2(s) * norm2(s)};
+        for (iterations = 0; iterations < prob.maxIterations && !prob.done(std::sqrt(gamma)); ++iterations)
+        {
+            opA.apply(p.data(), q.data());
+            const real_t qNorm{norm2(q)};
+            if (qNorm == 0)
+            {
+                break;
+            }
+            const T alpha{gamma / (qNorm * qNorm)};
+            i_kernel::axpy(x.size(), alpha, p.data(), x.data());
+            i_kernel::axpy(r.size(), -alpha, q.data(), r.data());
+            opA.applyAdjoint(r.data(), s.data());
+            const real_t gammaNew{norm2(s) * norm2(s)};
+            scale(p, T{gammaNew / gamma});
+            i_kernel::axpy(p.size(), T{1}, s.data(), p.data()); // p = s + (gammaNew / gamma) * p
+            gamma = gammaNew;
+        }
+        return std::sqrt(gamma);
+    }
+
+    // Golub-Kahan step: beta * u = A * v - alpha * u, alpha * v = A' * u - beta * v; alpha & beta stay real for complex data
+    template <typename T>
+    void bidiagonalize(const i_linear_operator<T> &opA, vector_t<T> &u, vector_t<T> &v, vector_t<T> &workU, vector_t<T> &workV,
+                       typename i_real_type<T>::type &alpha, typename i_real_type<T>::type &beta)
+    {
+        opA.apply(v.data(), workU.data());
+        for (std::size_t i{0}; i < u.size(); ++i)
+        {
+            u[i] = workU[i] - alpha * u[i];
+        }
+        beta = norm2(u);
+        if (beta == 0)
+        {
+            return;
+        }
+        scale(u, T{1 / beta});
+        opA.applyAdjoint(u.data(), workV.data());
+        for (std::size_t i{0}; i < v.size(); ++i)
+        {
+            v[i] = workV[i] - beta * v[i];
+        }
+        alpha = norm2(v);
+        if (alpha > 0)
+        {
+            scale(v, T{1 / alpha});
+        }
+    }
+
+    // u = r / ||r||, v = A' * u / ||A' * u||, the first bidiagonalization step
+    template <typename T>
+    void startBidiagonalization(const problem<T> &prob, vector_t<T> &u, vector_t<T> &v,
+                                typename i_real_type<T>::type &alpha, typename i_real_type<T>::type &beta)
+    {
+        u = prob.r;
+        v.assign(prob.opA.cols(), T{});
+        alpha = 0;
+        beta = norm2(u);
+        if (beta > 0)
+        {
+            scale(u, T{1 / beta});
+            prob.opA.applyAdjoint(u.data(), v.data());
+            alpha = norm2(v);
+        }
+        if (alpha > 0)
+        {
+            scale(v, T{1 / alpha});
+        }
+    }
+
+    template <typename T>
+    double lsqr(const problem<T> &prob, vector_t<T> &x, std::size_t &iterations)
+    {
+        using real_t = typename i_real_type<T>::type;
+        vector_t<T> u, v, workU(prob.opA.rows()), workV(prob.opA.cols());
+        real_t alpha{0}, beta{0};
+        startBidiagonalization(prob, u, v, alpha, beta);
+        vector_t<T> w{v};
+        real_t phibar{beta}, rhobar{alpha}, normalResidual{alpha * beta};
+        for (iterations = 0; iterations < prob.maxIterations && !prob.done(normalResidual); ++iterations)
+        {
+            bidiagonalize(prob.opA, u, v, workU, workV, alpha, beta);
+            const real_t rho{std::hypot(rhobar, beta)}, c{rhobar / rho}, s{beta / rho};
+            const real_t theta{s * alpha}, phi{c * phibar};
+            rhobar = -c * alpha;
+            phibar = s * phibar;
+            i_kernel::axpy(x.size(), T{phi / rho}, w.data(), x.data());
+            for (std::size_t i{0}; i < w.size(); ++i)
+            {
+                w[i] = v[i] - (theta / rho) * w[i];
+            }
+            normalResidual = phibar * alpha * std::abs(c); // ||A' * r||
+        }
+        return normalResidual;
+    }
+
+    template <typename T>
+    double lsmr(const problem<T> &prob, vector_t<T> &x, std::size_t &iterations)
+    {
+        using real_t = typename i_real_type<T>::type;
+        vector_t<T> u, v, workU(prob.opA.rows()), workV(prob.opA.cols());
+        real_t alpha{0}, beta{0};
+        startBidiagonalization(prob, u, v, alpha, beta);
+        vector_t<T> h{v}, hbar(v.size());
+        real_t zetabar{alpha * beta}, alphabar{alpha}, rho{1}, rhobar{1}, cbar{1}, sbar{0};
+        for (iterations = 0; iterations < prob.maxIterations && !prob.done(std::abs(zetabar)); ++iterations)
+        {
+            bidiagonalize(prob.opA, u, v, workU, workV, alpha, beta);
+            // Rotation turning the lower bidiagonal B into upper R
+            const real_t rhoOld{rho};
+            rho = std::hypot(alphabar, beta);
+            const real_t c{alphabar / rho}, s{beta / rho}, thetaNew{s * alpha};
+            alphabar = c * alpha;
+            // Rotation turning R' into upper Rbar
+            const real_t rhobarOld{rhobar}, thetabar{sbar * rho};
+            rhobar = std::hypot(cbar * rho, thetaNew);
+            cbar = cbar * rho / rhobar;
+            sbar = thetaNew / rhobar;
+            const real_t zeta{cbar * zetabar};
+            zetabar = -sbar * zetabar;
+
+            for (std::size_t i{0}; i < h.size(); ++i)
+            {
+                hbar[i] = h[i] - (thetabar * rho / (rhoOld * rhobarOld)) * hbar[i];
+            }
+            i_kernel::axpy(x.size(), T{zeta / (rho * rhobar)}, hbar.data(), x.data());
+            for (std::size_t i{0}; i < h.size(); ++i)
+            {
+                h[i] = v[i] - (thetaNew / rho) * h[i];
+            }
+        }
+        return std::abs(zetabar); // ||A' * r||
+    }
+
+    // Column by column driver: x is the warm start on entry (zero if empty) and the solution on return
+    template <typename T, typename Solver>
+    i_iterative_info solveColumns(const char *name, const i_linear_operator<T> &opA, const i_dense_matrix<T> &matb, i_dense_matrix<T> &matx,
+                                  const typename i_real_type<T>::type tolerance, const std::size_t maxIterations, Solver solver)
+    {
+        i_iterative_info info;
+        const std::size_t nrows{opA.rows()}, ncols{opA.cols()}, nrhs{matb.cols()};
+        if (matb.rows() != nrows)
+        {
+            std::cout << "Error when using " << name << ": row size not match.\n";
+            return info;
+        }
+        if (matx.rows() != ncols || matx.cols() != nrhs)
+        {
+            if (!matx.empty())
+            {
+                std::cout << "Warning when using " << name << ": initial guess size not match, starting from zero.\n";
+            }
+            matx = i_dense_matrix<T>(ncols, nrhs);
+        }
+        info.converged = true;
+        vector_t<T> b(nrows), x(ncols);
+        for (std::size_t j{0}; j < nrhs; ++j)
+        {
+            for (std::size_t i{0}; i < nrows; ++i)
+            {
+                b[i] = matb(i, j);
+            }
+            for (std::size_t i{0}; i < ncols; ++i)
+            {
+                x[i] = matx(i, j);
+            }
+            const problem<T> prob{setUp(opA, b, x, tolerance, maxIterations)};
+            std::size_t iterations{0};
+            const double normalResidual{solver(prob, x, iterations)};
+            const double relative{prob.normalRhs > 0 ? normalResidual / prob.normalRhs : normalResidual};
+            info.iterations = std::max(info.iterations, iterations);
+            info.normalResidual = std::max(info.normalResidual, relative);
+            info.converged = info.converged && prob.done(static_cast<typename i_real_type<T>::type>(normalResidual));
+            for (std::size_t i{0}; i < ncols; ++i)
+            {
+                matx(i, j) = x[i];
+            }
+        }
+        return info;
+    }
+} // namespace i_iterative
+
+template <typename T>
+i_iterative_info cgls(const i_linear_operator<T> &opA, const i_dense_matrix<T> &matb, i_dense_matrix<T> &matx,
+                      const typename i_real_type<T>::type tolerance = defaultTolerance<T>(), const std::size_t maxIterations = 0)
+{
+    return i_iterative::solveColumns("cgls", opA, matb, matx, tolerance, maxIterations, i_iterative::cgls<T>);
+}
+
+template <typename T>
+i_iterative_info lsqr(const i_linear_operator<T> &opA, const i_dense_matrix<T> &matb, i_dense_matrix<T> &matx,
+                      const typename i_real_type<T>::type tolerance = defaultTolerance<T>(), const std::size_t maxIterations = 0)
+{
+    return i_iterative::solveColumns("lsqr", opA, matb, matx, tolerance, maxIterations, i_iterative::lsqr<T>);
+}
+
+template <typename T>
+i_iterative_info lsmr(const i_linear_operator<T> &opA, const i_dense_matrix<T> &matb, i_dense_matrix<T> &matx,
+                      const typename i_real_type<T>::type tolerance = defaultTolerance<T>(), const std::size_t maxIterations = 0)
+{
+    return i_iterative::solveColumns("lsmr", opA, matb, matx, tolerance, maxIterations, i_iterative::lsmr<T>);
+}
@@ -0,0 +1,384 @@
+#pragma once
+/*
+Mini Matrix Tools - Blocked LU Factorization
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+P * G = L * U with partial pivoting, right-looking on i_lu_tile tiles [*1][*3]. Per tile column k, as tasks of a
+dependency graph (see matBasic_thread.hpp):
+    panel(k):       recursive factorization of tile column k [*2] (pivot search over all rows below)
+    U(k, j):        row exchanges of panel k on tile column j, then U(k, j) = inv(L(k, k)) * A(k, j)
+    update(i, j):   A(i, j) -= L(i, k) * U(k, j)   (GEMM engine, see matBasic_gemm.hpp)
+    left(k, j):     row exchanges of panel k on the finished L tiles left of it
+Panel k + 1 starts as soon as tile column k + 1 is updated, while the other updates of step k still run.
+L (unit diagonal, not stored) & U share one packed matrix. The factorization object is kept so that
+several solves, the inverse and the determinant reuse the same factors.
+
+Main Function List:
+[1] LUFactorization::solve:    X = G \ B for any number of right-hand sides (blocked triangular solves)
+[2] LUFactorization::inverse:  inv(G) = solve(I)
+[3] LUFactorization::det:      det(G) = sign(P) * prod(diag(U))
+[4] LUFactorization::logdet:   log|det(G)|, with detSign() giving det(G) / |det(G)|
+[5] LUFactorization::pivotRatio: min|U(i, i)| / max|U(i, i)|, used to detect (nearly) singular matrices
+[6] LUFactorization::reconstruct: G = P' * L * U, the factored matrix back from the factors
+
+Reference:
+[*1] Gene H. Golub, Charles F. Van Loan, Matrix Computations (4th ed.), section 3.2.11 & 3.4.8, Block LU with partial pivoting
+[*2] Sivan Toledo, Locality of Reference in LU Decomposition with Partial Pivoting, SIAM J. Matrix Anal. Appl. 18(4), 1997
+[*3] Alfredo Buttari, Julien Langou, Jakub Kurzak, Jack Dongarra, A Class of Parallel Tiled Linear Algebra Algorithms for Multicore Architectures, Parallel Computing 35(1), 2009
+*/
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_gemm.hpp"
+
+constexpr std::size_t i_lu_block{64}; // Block height of the triangular solves
+constexpr std::size_t i_lu_tile{128}; // Tile size of the task-graph factorization, also the panel width
+constexpr std::size_t i_lu_leaf{16};  // Panel columns below this are factored column by column
+
+template <typename T>
+class LUFactorization
+{
+public:
+    using real_t = typename i_real_type<T>::type;
+
+    LUFactorization() = default;
+
+    // usePivoting = false skips row exchanges (only safe for e.g. symmetric positive definite matrices)
+    explicit LUFactorization(const i_dense_matrix<T> &matG, const bool usePivoting = true)
+    {
+        if (matG.rows() != matG.cols())
+        {
+            std::cout << "Error when using LUFactorization: matrix is not square.\n";
+            return;
+        }
+        m_lu = matG;
+        factor(usePivoting);
+    }
+
+    bool empty() const { return m_lu.empty(); }
+    bool singular() const { return m_singular; }
+    std::size_t size() const { return m_lu.rows(); }
+    const i_dense_matrix<T> &packedLU() const { return m_lu; }
+    const std::vector<std::size_t> &permutation() const { return m_permute; } // Row i of P * G is row permutation()[i] of G
+
+    // X = G \ B: X = inv(U) * inv(L) * P * B
+    i_dense_matrix<T> solve(const i_dense_matrix<T> &matB) const
+    {
+        const std::size_t nSize{size()}, nrhs{matB.cols()};
+        i_dense_matrix<T> matX;
+        if (matB.rows() != nSize)
+        {
+            std::cout << "Error when using LUFactorization::solve: row size not match.\n";
+            return matX;
+        }
+        if (m_singular)
+        {
+            std::cout << "Warning when using LUFactorization::solve: matrix is singular.\n";
+            return matX;
+        }
+        matX = i_dense_matrix<T>(nSize, nrhs);
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            std::copy_n(matB.row(m_permute[i]), nrhs, matX.row(i));
+        }
+        solveLower(matX);
+        solveUpper(matX);
+        return matX;
+    }
+
+    i_dense_matrix<T> inverse() const
+    {
+        i_dense_matrix<T> matI(size(), size());
+        for (std::size_t i{0}; i < size(); ++i)
+        {
+            matI(i, i) = T{1};
+        }
+        return solve(matI);
+    }
+
+    T det() const
+    {
+        T detG{m_changeSign ? T{-1} : T{1}};
+        if (m_singular)
+        {
+            return T{};
+        }
+        for (std::size_t i{0}; i < size(); ++i)
+        {
+            detG *= m_lu(i, i);
+        }
+        return detG;
+    }
+
+    // log|det(G)|, does not overflow where det() would; -inf for a singular matrix
+    real_t logdet() const
+    {
+        if (m_singular)
+        {
+            return -std::numeric_limits<real_t>::infinity();
+        }
+        real_t logAbs{0};
+        for (std::size_t i{0}; i < size(); ++i)
+        {
+            logAbs += std::log(std::abs(m_lu(i, i)));
+        }
+        return logAbs;
+    }
+
+    // det(G) / |det(G)|: +1 / -1 for a real matrix, a unit-modulus phase for a complex one; 0 if singular
+    T detSign() const
+    {
+        if (m_singular)
+        {
+            return T{};
+        }
+        T sign{m_changeSign ? T{-1} : T{1}};
+        for (std::size_t i{0}; i < size(); ++i)
+        {
+            sign *= m_lu(i, i) / std::abs(m_lu(i, i));
+        }
+        return sign;
+    }
+
+    // min|U(i, i)| / max|U(i, i)|, a cheap singularity indicator (0 if singular); leftDiv falls back to pinv below its tolerance
+    real_t pivotRatio() const
+    {
+        if (m_singular || empty())
+        {
+            return 0;
+        }
+        real_t minPivot{std::abs(m_lu(0, 0))}, maxPivot{minPivot};
+        for (std::size_t i{1}; i < size(); ++i)
+        {
+            const real_t currentv{std::abs(m_lu(i, i))};
+            minPivot = std::min(minPivot, currentv);
+            maxPivot = std::max(maxPivot, currentv);
+        }
+        return minPivot / maxPivot;
+    }
+
+    // G = P' * L * U, one GEMM, for callers that only kept the factorization
+    i_dense_matrix<T> reconstruct() const
+    {
+        const std::size_t nSize{size()};
+        i_dense_matrix<T> matL(nSize, nSize), matU(nSize, nSize), matPG(nSize, nSize), matG(nSize, nSize);
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            std::copy_n(m_lu.row(i), i, matL.row(i));
+            matL(i, i) = T{1};
+            std::copy_n(m_lu.row(i) + i, nSize - i, matU.row(i) + i);
+        }
+        i_kernel::gemm(nSize, nSize, nSize, matL.data(), matL.stride(), false, matU.data(), matU.stride(), false, matPG.data(), matPG.stride());
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            std::copy_n(matPG.row(i), nSize, matG.row(m_permute[i]));
+        }
+        return matG;
+    }
+
+private:
+    static real_t pivotMagnitude(const T &value)
+    {
+        const std::complex<real_t> asComplex{value};
+        return std::abs(asComplex.real()) + std::abs(asComplex.imag()); // |re| + |im|, as in LAPACK for complex pivots
+    }
+
+    // Row r of columns cb:ce is exchanged with row pivots[r], for r = rb ... re - 1 in turn
+    void swapRows(const std::vector<std::size_t> &pivots, const std::size_t rb, const std::size_t re, const std::size_t cb, const std::size_t ce)
+    {
+        for (std::size_t r{rb}; r < re; ++r)
+        {
+            if (pivots[r] != r)
+            {
+                std::swap_ranges(m_lu.row(pivots[r]) + cb, m_lu.row(pivots[r]) + ce, m_lu.row(r) + cb);
+            }
+        }
+    }
+
+    // A(rb:re, cb:ce) = inv(L(rb:re, rb:re)) * A(rb:re, cb:ce), L unit lower triangular (row axpys)
+    void solveUnitLowerBlock(const std::size_t rb, const std::size_t re, const std::size_t cb, const std::size_t ce)
+    {
+        for (std::size_t r{rb + 1}; r < re; ++r)
+        {
+            for (std::size_t q{rb}; q < r; ++q)
+            {
+                i_kernel::axpy(ce - cb, -m_lu(r, q), m_lu.row(q) + cb, m_lu.row(r) + cb);
+            }
+        }
+    }
+
+    // Recursive panel factorization of columns c0:c1, rows c0:n [*2]: the left half, then the right half after
+    // a GEMM update, so most of the panel work is level 3 as well. Row exchanges stay inside the panel
+    void factorPanel(const std::size_t c0, const std::size_t c1, const bool usePivoting, std::vector<std::size_t> &pivots)
+    {
+        const std::size_t nSize{m_lu.rows()}, ld{m_lu.stride()};
+        if (c1 - c0 <= i_lu_leaf)
+        {
+            for (std::size_t k{c0}; k < c1; ++k)
+            {
+                std::size_t pivot{k};
+                real_t maxv{pivotMagnitude(m_lu(k, k))};
+                if (usePivoting)
+                {
+                    for (std::size_t i{k + 1}; i < nSize; ++i)
+                    {
+                        const real_t currentv{pivotMagnitude(m_lu(i, k))};
+                        if (currentv > maxv)
+                        {
+                            maxv = currentv;
+                            pivot = i;
+                        }
+                    }
+                }
+                pivots[k] = pivot;
+                if (maxv == 0)
+                {
+                    m_singular = true; // Nothing to eliminate in this column, carry on like LAPACK
+                    continue;
+                }
+                if (pivot != k)
+                {
+                    std::swap_ranges(m_lu.row(pivot) + c0, m_lu.row(pivot) + c1, m_lu.row(k) + c0);
+                }
+                const T pivotInv{T{1} / m_lu(k, k)};
+                for (std::size_t i{k + 1}; i < nSize; ++i)
+                {
+                    m_lu(i, k) *= pivotInv;
+                    i_kernel::axpy(c1 - k - 1, -m_lu(i, k), m_lu.row(k) + k + 1, m_lu.row(i) + k + 1);
+                }
+            }
+            return;
+        }
+        const std::size_t mid{c0 + (c1 - c0) / 2};
+        factorPanel(c0, mid, usePivoting, pivots);
+        swapRows(pivots, c0, mid, mid, c1);
+        solveUnitLowerBlock(c0, mid, mid, c1);
+        i_kernel::gemm(nSize - mid, c1 - mid, mid - c0, m_lu.row(mid) + c0, ld, false, m_lu.row(c0) + mid, ld, false,
+                       m_lu.row(mid) + mid, ld, T{-1});
+        factorPanel(mid, c1, usePivoting, pivots);
+        swapRows(pivots, mid, c1, c0, mid);
+    }
+
+    void factor(const bool usePivoting)
+    {
+        const std::size_t nSize{m_lu.rows()}, ld{m_lu.stride()};
+        const std::size_t nb{i_lu_tile}, nt{(nSize + nb - 1) / nb};
+        std::vector<std::size_t> pivots(nSize);
+        const auto tileBegin = [nb](const std::size_t i) { return i * nb; };
+        const auto tileEnd = [nb, nSize](const std::size_t i) { return std::min((i + 1) * nb, nSize); };
+        const auto columnTiles = [nt](const std::size_t k, const std::size_t j) { // Tiles k:nt of tile column j
+            std::vector<std::size_t> tiles;
+            for (std::size_t i{k}; i < nt; ++i)
+            {
+                tiles.push_back(i * nt + j);
+            }
+            return tiles;
+        };
+
+        // ******************** Task graph: panel -> row exchanges & U12 -> A22 updates, per tile column ********************
+        i_task_graph graph(nt * nt);
+        for (std::size_t k{0}; k < nt; ++k)
+        {
+            const std::size_t kb{tileBegin(k)}, ke{tileEnd(k)};
+            graph.addTask([this, kb, ke, usePivoting, &pivots]() { factorPanel(kb, ke, usePivoting, pivots); }, {}, columnTiles(k, k), 2);
+            for (std::size_t j{k + 1}; j < nt; ++j)
+            {
+                const std::size_t jb{tileBegin(j)}, je{tileEnd(j)};
+                graph.addTask([this, kb, ke, jb, je, &pivots]() {
+                    swapRows(pivots, kb, ke, jb, je);
+                    solveUnitLowerBlock(kb, ke, jb, je); // U(k, j) = inv(L(k, k)) * A(k, j)
+                },
+                              {k * nt + k}, columnTiles(k, j), j == k + 1 ? 1 : 0);
+            }
+            for (std::size_t i{k + 1}; i < nt; ++i)
+            {
+                for (std::size_t j{k + 1}; j < nt; ++j)
+                {
+                    const std::size_t ib{tileBegin(i)}, ie{tileEnd(i)}, jb{tileBegin(j)}, je{tileEnd(j)};
+                    graph.addTask([this, ib, ie, jb, je, kb, ke, ld]() { // A(i, j) -= L(i, k) * U(k, j)
+                        i_kernel::gemm(ie - ib, je - jb, ke - kb, m_lu.row(ib) + kb, ld, false, m_lu.row(kb) + jb, ld, false,
+                                       m_lu.row(ib) + jb, ld, T{-1});
+                    },
+                                  {i * nt + k, k * nt + j}, {i * nt + j}, j == k + 1 ? 1 : 0); // Column k + 1 feeds the next panel
+                }
+            }
+            for (std::size_t j{0}; j < k; ++j)
+            {
+                const std::size_t jb{tileBegin(j)}, je{tileEnd(j)};
+                graph.addTask([this, kb, ke, jb, je, &pivots]() { swapRows(pivots, kb, ke, jb, je); }, {k * nt + k}, columnTiles(k, j), -1); // Left factors
+            }
+        }
+        graph.run();
+
+        m_permute.resize(nSize);
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            m_permute[i] = i;
+        }
+        for (std::size_t r{0}; r < nSize; ++r)
+        {
+            if (pivots[r] != r)
+            {
+                std::swap(m_permute[pivots[r]], m_permute[r]);
+                m_changeSign = !m_changeSign;
+            }
+        }
+    }
+
+    // X = inv(L) * X, L unit lower triangular. Rows above the current block are folded in with one GEMM
+    void solveLower(i_dense_matrix<T> &matX) const
+    {
+        const std::size_t nSize{size()}, nrhs{matX.cols()};
+        for (std::size_t jb{0}; jb < nSize; jb += i_lu_block)
+        {
+            const std::size_t je{std::min(jb + i_lu_block, nSize)};
+            i_kernel::gemm(je - jb, nrhs, jb, m_lu.row(jb), m_lu.stride(), false, matX.data(), matX.stride(), false,
+                           matX.row(jb), matX.stride(), T{-1});
+            for (std::size_t i{jb + 1}; i < je; ++i)
+            {
+                for (std::size_t q{jb}; q < i; ++q)
+                {
+                    i_kernel::axpy(nrhs, -m_lu(i, q), matX.row(q), matX.row(i));
+                }
+            }
+        }
+    }
+
+    // X = inv(U) * X, bottom block first
+    void solveUpper(i_dense_matrix<T> &matX) const
+    {
+        const std::size_t nSize{size()}, nrhs{matX.cols()};
+        const std::size_t nBlocks{(nSize + i_lu_block - 1) / i_lu_block};
+        for (std::size_t b{nBlocks}; b > 0; --b)
+        {
+            const std::size_t jb{(b - 1) * i_lu_block}, je{std::min(jb + i_lu_block, nSize)};
+            i_kernel::gemm(je - jb, nrhs, nSize - je, m_lu.row(jb) + je, m_lu.stride(), false, matX.row(je), matX.stride(), false,
+                           matX.row(jb), matX.stride(), T{-1});
+            for (std::size_t i{je}; i > jb; --i)
+            {
+                const std::size_t ii{i - 1};
+                for (std::size_t q{ii + 1}; q < je; ++q)
+                {
+                    i_kernel::axpy(nrhs, -m_lu(ii, q), matX.row(q), matX.row(ii));
+                }
+                const T diagInv{T{1} / m_lu(ii, ii)};
+                T *rowX{matX.row(ii)};
+                for (std::size_t j{0}; j < nrhs; ++j)
+                {
+                    rowX[j] *= diagInv;
+                }
+            }
+        }
+    }
+
+    i_dense_matrix<T> m_lu;
+    std::vector<std::size_t> m_permute;
+    bool m_changeSign{false};
+    bool m_singular{false};
+};
@@ -0,0 +1,450 @@
+#pragma once
+/*
+Mini Matrix Tools - NumPy .npy Files
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+Matrices to & from NumPy without a text step [*1]:
+    .npy: "\x93NUMPY", version, a Python dict header {'descr', 'fortran_order', 'shape'} padded to 64 bytes, raw data
+Element types float64 '<f8', float32 '<f4', complex128 '<c16' & complex64 '<c8', any byte order, C or Fortran order,
+shapes (m, n), (m,) (read as m x 1) & (). A stored type different from T is converted (complex to real is refused).
+mapNpy maps the file (see matBasic_file.hpp) and returns a matrix that borrows the mapped pages when the data
+already has the i_dense_matrix layout: same type & byte order, C order, data offset & row length multiples of 64
+bytes (e.g. 8 * k float64 columns). Anything else is read row by row into an owned matrix.
+The writer streams every row straight from the matrix buffer. .npz archives build on this file, see matBasic_npz.hpp.
+
+Main Function List:
+[1] writeNpy: Matrix -> .npy (C order, native byte order)
+[2] mapNpy:   .npy -> matrix, zero-copy when the layout allows it
+[3] readNpy:  .npy -> owned matrix
+
+Reference:
+[*1] NumPy, A Simple File Format for NumPy Arrays (NEP 1), https://numpy.org/neps/nep-0001-npy-format.html
+*/
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_file.hpp"
+
+namespace i_npy
+{
+    // Stored element type, from the 'descr' string
+    struct element_type
+    {
+        bool isComplex{false};
+        std::size_t realBytes{0}; // 4 or 8: float or double parts
+        bool swapBytes{false};    // Stored in the other byte order
+    };
+
+    // Layout of one array inside a file
+    struct array_info
+    {
+        element_type type;
+        bool fortranOrder{false};
+        std::size_t rows{0};
+        std::size_t cols{0};
+        std::uint64_t dataOffset{0}; // In the file, for .npz entries as well
+    };
+
+    inline bool littleEndian()
+    {
+        const std::uint16_t probe{1};
+        return *reinterpret_cast<const unsigned char *>(&probe) == 1;
+    }
+
+    template <typename T>
+    std::string descr()
+    {
+        using real_t = typename i_real_type<T>::type;
+        const bool isComplex{!std::is_same<T, real_t>::value};
+        return std::string(littleEndian() ? "<" : ">") + (isComplex ? "c" : "f") + std::to_string(sizeof(T));
+    }
+
+    template <typename T>
+    bool nativeType(const element_type &type)
+    {
+        using real_t = typename i_real_type<T>::type;
+        return !type.swapBytes && type.isComplex == !std::is_same<T, real_t>::value && type.realBytes == sizeof(real_t);
+    }
+
+    // "\x93NUMPY" 1.0 (2.0 for a header above 64 KB), dict padded with spaces & '\n' to a multiple of 64 bytes
+    template <typename T>
+    std::string makeHeader(const std::size_t nrows, const std::size_t ncols)
+    {
+        std::string dict{"{'descr': '" + descr<T>() + "', 'fortran_order': False, 'shape': (" + std::to_string(nrows) + ", " + std::to_string(ncols) + "), }"};
+        const bool version2{dict.size() + 1 + 10 > 0xffff};
+        const std::size_t preamble{version2 ? 12u : 10u};
+        dict.append((64 - (preamble + dict.size() + 1) % 64) % 64, ' ');
+        dict.push_back('\n');
+        std::string header{"\x93NUMPY"};
+        header.push_back(version2 ? '\x02' : '\x01');
+        header.push_back('\x00');
+        for (std::size_t b{0}; b < preamble - 8; ++b)
+        {
+            header.push_back(static_cast<char>(dict.size() >> (8 * b) & 0xff)); // Little endian header length
+        }
+        return header + dict;
+    }
+
+    // Value of key in the header dict, up to the next ',' at the top level ("(3, 4)" stays whole)
+    inline std::string dictValue(const std::string &dict, const char *key)
+    {
+        const std::size_t at{dict.find(std::string("'") + key + "'")};
+        if (at == std::string::npos)
+        {
+            return std::string();
+        }
+        std::size_t pos{dict.find(':', at)};
+        if (pos == std::string::npos)
+        {
+            return std::string();
+        }
+        ++pos;
+        while (pos < dict.size() && dict[pos] == ' ')
+        {
+            ++pos;
+        }
+        const std::size_t end{dict[pos] == '(' ? dict.find(')', pos) + 1 : dict.find_first_of(",}", pos)};
+        return end == std::string::npos ? std::string() : dict.substr(pos, end - pos);
+    }
+
+    inline std::uint64_t fileSize(std::ifstream &file)
+    {
+        file.seekg(0, std::ios::end);
+        return static_cast<std::uint64_t>(file.tellg());
+    }
+
+    // Header at offset of the open file; false (with a message) if it is not a supported array
+    inline bool readHeader(std::ifstream &file, const std::uint64_t offset, array_info &info, const char *name)
+    {
+        const std::uint64_t size{fileSize(file)};
+        unsigned char preamble[12]{};
+        file.seekg(static_cast<std::streamoff>(offset));
+        if (!file.read(reinterpret_cast<char *>(preamble), 10) || std::memcmp(preamble, "\x93NUMPY", 6) != 0)
+        {
+            std::cout << "Error when using " << name << ": not a .npy array.\n";
+            return false;
+        }
+        const bool version1{preamble[6] == 1};
+        if (!version1 && !file.read(reinterpret_cast<char *>(preamble) + 10, 2))
+        {
+            std::cout << "Error when using " << name << ": not a .npy array.\n";
+            return false;
+        }
+        const std::size_t preambleSize{version1 ? 10u : 12u};
+        std::size_t dictSize{0};
+        for (std::size_t b{preambleSize}; b > 8; --b)
+        {
+            dictSize = dictSize << 8 | preamble[b - 1];
+        }
+        if (offset + preambleSize > size || dictSize > size - offset - preambleSize)
+        {
+            std::cout << "Error when using " << name << ": truncated .npy header.\n";
+            return false;
+        }
+        std::string dict(dictSize, '\0');
+        if (!file.read(&dict[0], static_cast<std::streamsize>(dictSize)))
+        {
+            std::cout << "Error when using " << name << ": truncated .npy header.\n";
+            return false;
+        }
+        info.dataOffset = offset + preambleSize + dictSize;
+
+        // 'descr': '<f8' / '|f8' / '>c16', ...
+        const std::string typeText{dictValue(dict, "descr")};
+        const char order{typeText.size() >= 4 ? typeText[1] : '?'}, kind{typeText.size() >= 4 ? typeText[2] : '?'};
+        const std::size_t bytes{typeText.size() >= 4 ? static_cast<std::size_t>(std::atoi(typeText.c_str() + 3)) : 0};
+        info.type.isComplex = kind == 'c';
+        info.type.realBytes = info.type.isComplex ? bytes / 2 : bytes;
+        info.type.swapBytes = (order == '<' && !littleEndian()) || (order == '>' && littleEndian());
+        if ((kind != 'f' && kind != 'c') || (info.type.realBytes != 4 && info.type.realBytes != 8) || (order != '<' && order != '>' && order != '|' && order != '='))
+        {
+            std::cout << "Error when using " << name << ": unsupported element type " << typeText << ".\n";
+            return false;
+        }
+        info.fortranOrder = dictValue(dict, "fortran_order") == "True";
+
+        // 'shape': (), (m,) or (m, n)
+        const std::string shapeText{dictValue(dict, "shape")};
+        std::vector<std::size_t> shape;
+        for (std::size_t pos{1}; pos < shapeText.size();)
+        {
+            const std::size_t digit{shapeText.find_first_of("0123456789", pos)};
+            if (digit == std::string::npos)
+            {
+                break;
+            }
+            std::size_t dim{0};
+            const char *last{shapeText.data() + shapeText.size()};
+            const std::from_chars_result parsed{std::from_chars(shapeText.data() + digit, last, dim)};
+            if (parsed.ec != std::errc{})
+            {
+                std::cout << "Error when using " << name << ": array dimension out of range.\n";
+                return false;
+            }
+            shape.push_back(dim);
+            pos = static_cast<std::size_t>(parsed.ptr - shapeText.data());
+        }
+        if (shapeText.empty() || shape.size() > 2)
+        {
+            std::cout << "Error when using " << name << ": only 0, 1 & 2 dimensional arrays are supported.\n";
+            return false;
+        }
+        info.rows = shape.empty() ? 1 : shape[0];
+        info.cols = shape.size() == 2 ? shape[1] : 1;
+        return true;
+    }
+
+    template <typename R>
+    R decodeReal(const unsigned char *bytes, const element_type &type)
+    {
+        unsigned char value[8]{};
+        for (std::size_t b{0}; b < type.realBytes; ++b)
+        {
+            value[b] = bytes[type.swapBytes ? type.realBytes - 1 - b : b];
+        }
+        if (type.realBytes == 4)
+        {
+            float result;
+            std::memcpy(&result, value, 4);
+            return static_cast<R>(result);
+        }
+        double result;
+        std::memcpy(&result, value, 8);
+        return static_cast<R>(result);
+    }
+
+    template <typename T>
+    T decode(const unsigned char *bytes, const element_type &type)
+    {
+        using real_t = typename i_real_type<T>::type;
+        if constexpr (std::is_same<T, real_t>::value)
+        {
+            return decodeReal<real_t>(bytes, type);
+        }
+        else
+        {
+            return T{decodeReal<real_t>(bytes, type), type.isComplex ? decodeReal<real_t>(bytes + type.realBytes, type) : real_t{0}};
+        }
+    }
+
+    // Owned copy, one C-order row or Fortran-order column read at a time, converted to T
+    template <typename T>
+    i_dense_matrix<T> readArray(std::ifstream &file, const array_info &info, const char *name)
+    {
+        const std::size_t elemBytes{info.type.realBytes * (info.type.isComplex ? 2 : 1)};
+        const std::size_t nLines{info.fortranOrder ? info.cols : info.rows}, lineLength{info.fortranOrder ? info.rows : info.cols};
+        i_dense_matrix<T> matG(info.rows, info.cols);
+        std::vector<unsigned char> line(lineLength * elemBytes);
+        file.seekg(static_cast<std::streamoff>(info.dataOffset));
+        if (nativeType<T>(info.type) && !info.fortranOrder)
+        {
+            for (std::size_t i{0}; i < info.rows; ++i)
+            {
+                file.read(reinterpret_cast<char *>(matG.row(i)), static_cast<std::streamsize>(info.cols * sizeof(T))); // Straight into the row
+            }
+            if (!file)
+            {
+                std::cout << "Error when using " << name << ": truncated array data.\n";
+                return i_dense_matrix<T>();
+            }
+            return matG;
+        }
+        for (std::size_t q{0}; q < nLines; ++q)
+        {
+            if (!file.read(reinterpret_cast<char *>(line.data()), static_cast<std::streamsize>(line.size())))
+            {
+                std::cout << "Error when using " << name << ": truncated array data.\n";
+                return i_dense_matrix<T>();
+            }
+            for (std::size_t p{0}; p < lineLength; ++p)
+            {
+                const T value{decode<T>(line.data() + p * elemBytes, info.type)};
+                if (info.fortranOrder)
+                {
+                    matG(p, q) = value;
+                }
+                else
+                {
+                    matG(q, p) = value;
+                }
+            }
+        }
+        return matG;
+    }
+
+    template <typename T>
+    bool checkType(const array_info &info, const char *name)
+    {
+        if (info.type.isComplex && std::is_same<T, typename i_real_type<T>::type>::value)
+        {
+            std::cout << "Error when using " << name << ": complex array cannot be read as a real matrix.\n";
+            return false;
+        }
+        return true;
+    }
+
+    // The stored array already is an i_dense_matrix<T>: no padding, aligned rows, same type
+    template <typename T>
+    bool mappable(const array_info &info)
+    {
+        return I_FILE_MMAP && nativeType<T>(info.type) && (!info.fortranOrder || info.cols == 1) && info.rows * info.cols > 0 &&
+               i_dense_matrix<T>::paddedStride(info.cols) == info.cols && info.dataOffset % i_dense_alignment == 0;
+    }
+
+    // Arrays in one file: borrowed from a single mapping where possible, read otherwise
+    template <typename T>
+    std::map<std::string, i_dense_matrix<T>> loadArrays(const std::string &path, std::ifstream &file, const std::map<std::string, array_info> &arrays,
+                                                        const bool allowMap, const char *name)
+    {
+        std::map<std::string, i_dense_matrix<T>> matrices;
+        const std::uint64_t size{fileSize(file)};
+#if I_FILE_MMAP
+        std::shared_ptr<i_matrix_file::mapping> region;
+#endif
+        for (const auto &entry : arrays)
+        {
+            const array_info &info{entry.second};
+            if (!checkType<T>(info, name))
+            {
+                return {};
+            }
+            // The shape comes from the file: every product is bounded by the file size before it is taken
+            std::uint64_t dataBytes{static_cast<std::uint64_t>(info.type.realBytes) * (info.type.isComplex ? 2u : 1u)};
+            bool sizeFits{info.dataOffset <= size};
+            for (const std::uint64_t factor : {static_cast<std::uint64_t>(info.rows), static_cast<std::uint64_t>(info.cols)})
+            {
+                sizeFits = sizeFits && (factor == 0 || dataBytes <= size / factor);
+                dataBytes = sizeFits ? dataBytes * factor : 0;
+            }
+            if (!sizeFits || dataBytes > size - info.dataOffset)
+            {
+                std::cout << "Error when using " << name << ": truncated array data.\n";
+                return {};
+            }
+#if I_FILE_MMAP
+            if (allowMap && mappable<T>(info))
+            {
+                region = region ? region : i_matrix_file::mapFile(path, static_cast<std::size_t>(size), name);
+                if (region)
+                {
+                    T *data{reinterpret_cast<T *>(static_cast<char *>(region->address) + info.dataOffset)};
+                    matrices.emplace(entry.first, i_dense_matrix<T>(data, info.rows, info.cols, region));
+                    continue;
+                }
+            }
+#endif
+            i_dense_matrix<T> matG{readArray<T>(file, info, name)};
+            if (info.rows * info.cols > 0 && matG.empty())
+            {
+                return {};
+            }
+            matrices.emplace(entry.first, std::move(matG));
+        }
+        return matrices;
+    }
+
+    template <typename T>
+    i_dense_matrix<T> loadNpy(const std::string &path, const bool allowMap, const char *name)
+    {
+        std::ifstream file(path, std::ios::binary);
+        array_info info;
+        if (!file)
+        {
+            std::cout << "Error when using " << name << ": cannot open " << path << ".\n";
+            return i_dense_matrix<T>();
+        }
+        if (!readHeader(file, 0, info, name))
+        {
+            return i_dense_matrix<T>();
+        }
+        std::map<std::string, i_dense_matrix<T>> matrices{loadArrays<T>(path, file, {{std::string(), info}}, allowMap, name)};
+        return matrices.empty() ? i_dense_matrix<T>() : std::move(matrices.begin()->second);
+    }
+
+    // CRC-32 of the zip format, writeNpz runs it over the bytes writeArray streams out
+    inline std::uint32_t crc32(std::uint32_t crc, const unsigned char *data, const std::size_t len)
+    {
+        static const std::array<std::uint32_t, 256> table{[]() {
+            std::array<std::uint32_t, 256> values{};
+            for (std::uint32_t n{0}; n < 256; ++n)
+            {
+                std::uint32_t c{n};
+                for (int k{0}; k < 8; ++k)
+                {
+                    c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                }
+                values[n] = c;
+            }
+            return values;
+        }()};
+        crc = ~crc;
+        for (std::size_t i{0}; i < len; ++i)
+        {
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    // .npy header & rows of matG to file; crc (if given) covers everything written
+    template <typename T>
+    bool writeArray(std::ofstream &file, const i_dense_matrix<T> &matG, std::uint32_t *crc)
+    {
+        const std::string header{makeHeader<T>(matG.rows(), matG.cols())};
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+        if (crc)
+        {
+            *crc = crc32(*crc, reinterpret_cast<const unsigned char *>(header.data()), header.size());
+        }
+        const std::size_t rowBytes{matG.cols() * sizeof(T)};
+        for (std::size_t i{0}; i < matG.rows(); ++i)
+        {
+            file.write(reinterpret_cast<const char *>(matG.row(i)), static_cast<std::streamsize>(rowBytes));
+            if (crc)
+            {
+                *crc = crc32(*crc, reinterpret_cast<const unsigned char *>(matG.row(i)), rowBytes);
+            }
+        }
+        return static_cast<bool>(file);
+    }
+} // namespace i_npy
+
+// Shape (rows, cols), C order, native byte order
+template <typename T>
+bool writeNpy(const std::string &path, const i_dense_matrix<T> &matG)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file || !i_npy::writeArray(file, matG, nullptr))
+    {
+        std::cout << "Error when using writeNpy: cannot write " << path << ".\n";
+        return false;
+    }
+    return true;
+}
+
+// Borrows the mapped data when it has the dense layout (see above), reads & converts it otherwise
+template <typename T>
+i_dense_matrix<T> mapNpy(const std::string &path)
+{
+    return i_npy::loadNpy<T>(path, true, "mapNpy");
+}
+
+template <typename T>
+i_dense_matrix<T> readNpy(const std::string &path)
+{
+    return i_npy::loadNpy<T>(path, false, "readNpy");
+}
@@ -0,0 +1,245 @@
+#pragma once
+/*
+Mini Matrix Tools - NumPy .npz Archives
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+.npz is an uncompressed zip archive of .npy files, one per array name (np.savez, not np.savez_compressed) [*1].
+Only stored entries are read; the central directory gives the offset of every entry, and the arrays inside
+are loaded like .npy files (see matBasic_npy.hpp), all borrowed ones sharing one mapping of the archive.
+writeNpz pads each local zip header (extra field) so that the data of every array starts on a 64-byte boundary,
+which makes its archives mappable as well.
+
+Main Function List:
+[1] writeNpz: Named matrices -> .npz (C order, native byte order)
+[2] mapNpz:   .npz -> matrices, zero-copy when the layout allows it
+[3] readNpz:  .npz -> owned matrices
+
+Reference:
+[*1] PKWARE, .ZIP File Format Specification (APPNOTE.TXT) 6.3.9, sections 4.3.7, 4.3.12 & 4.3.16
+*/
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_npy.hpp"
+
+namespace i_npy
+{
+    // ******************** zip (stored entries only) ********************
+    inline void putLE(std::string &out, const std::uint64_t value, const std::size_t bytes)
+    {
+        for (std::size_t b{0}; b < bytes; ++b)
+        {
+            out.push_back(static_cast<char>(value >> (8 * b) & 0xff));
+        }
+    }
+
+    inline std::uint64_t getLE(const unsigned char *bytes, const std::size_t count)
+    {
+        std::uint64_t value{0};
+        for (std::size_t b{count}; b > 0; --b)
+        {
+            value = value << 8 | bytes[b - 1];
+        }
+        return value;
+    }
+
+    // Local header (signature, version 2.0, no flags, stored, 1980-01-01) or the middle of a central directory record
+    inline void putEntryFields(std::string &out, const std::uint32_t crc, const std::uint64_t size, const std::size_t nameLength, const std::size_t extraLength)
+    {
+        putLE(out, 20, 2);     // Version needed to extract
+        putLE(out, 0, 2);      // Flags
+        putLE(out, 0, 2);      // Stored
+        putLE(out, 0, 2);      // Time
+        putLE(out, 0x21, 2);   // Date
+        putLE(out, crc, 4);
+        putLE(out, size, 4);   // Compressed size
+        putLE(out, size, 4);   // Uncompressed size
+        putLE(out, nameLength, 2);
+        putLE(out, extraLength, 2);
+    }
+
+    // name.npy -> data offset of every stored entry, from the central directory
+    inline bool readZipDirectory(std::ifstream &file, std::map<std::string, array_info> &arrays, const char *name)
+    {
+        const std::uint64_t size{fileSize(file)};
+        const std::size_t tailSize{static_cast<std::size_t>(std::min<std::uint64_t>(size, 22 + 0xffff))};
+        std::vector<unsigned char> tail(tailSize);
+        file.seekg(static_cast<std::streamoff>(size - tailSize));
+        file.read(reinterpret_cast<char *>(tail.data()), static_cast<std::streamsize>(tailSize));
+        std::size_t eocd{tailSize < 22 ? 0 : tailSize - 21}; // One past the candidate position
+        while (eocd > 0 && getLE(tail.data() + eocd - 1, 4) != 0x06054b50)
+        {
+            --eocd;
+        }
+        if (!file || eocd == 0)
+        {
+            std::cout << "Error when using " << name << ": not a zip archive.\n";
+            return false;
+        }
+        const unsigned char *end{tail.data() + eocd - 1};
+        const std::size_t entries{static_cast<std::size_t>(getLE(end + 10, 2))};
+        std::uint64_t dirSize{getLE(end + 12, 4)}, dirOffset{getLE(end + 16, 4)};
+        if (dirOffset == 0xffffffffu || dirSize == 0xffffffffu)
+        {
+            std::cout << "Error when using " << name << ": zip64 archives are not supported.\n";
+            return false;
+        }
+        if (dirOffset > size || dirSize > size - dirOffset)
+        {
+            std::cout << "Error when using " << name << ": damaged zip directory.\n";
+            return false;
+        }
+        std::vector<unsigned char> dir(static_cast<std::size_t>(dirSize));
+        file.seekg(static_cast<std::streamoff>(dirOffset));
+        file.read(reinterpret_cast<char *>(dir.data()), static_cast<std::streamsize>(dirSize));
+        std::size_t pos{0};
+        for (std::size_t e{0}; e < entries && file; ++e)
+        {
+            if (pos + 46 > dir.size() || getLE(dir.data() + pos, 4) != 0x02014b50)
+            {
+                std::cout << "Error when using " << name << ": damaged zip directory.\n";
+                return false;
+            }
+            const unsigned char *rec{dir.data() + pos};
+            const std::size_t nameLength{static_cast<std::size_t>(getLE(rec + 28, 2))};
+            const std::size_t recordSize{46 + nameLength + static_cast<std::size_t>(getLE(rec + 30, 2) + getLE(rec + 32, 2))};
+            const std::uint64_t localOffset{getLE(rec + 42, 4)};
+            if (recordSize > dir.size() - pos || localOffset > size || size - localOffset < 30)
+            {
+                std::cout << "Error when using " << name << ": damaged zip directory.\n";
+                return false;
+            }
+            std::string entryName(reinterpret_cast<const char *>(rec) + 46, nameLength);
+            if (getLE(rec + 10, 2) != 0)
+            {
+                std::cout << "Error when using " << name << ": " << entryName << " is compressed (use np.savez, not np.savez_compressed).\n";
+                return false;
+            }
+            unsigned char local[30];
+            file.seekg(static_cast<std::streamoff>(localOffset));
+            file.read(reinterpret_cast<char *>(local), 30);
+            array_info info;
+            if (!file || !readHeader(file, localOffset + 30 + getLE(local + 26, 2) + getLE(local + 28, 2), info, name))
+            {
+                return false;
+            }
+            if (entryName.size() > 4 && entryName.compare(entryName.size() - 4, 4, ".npy") == 0)
+            {
+                entryName.resize(entryName.size() - 4);
+            }
+            arrays.emplace(entryName, info);
+            pos += recordSize;
+        }
+        return static_cast<bool>(file);
+    }
+
+    template <typename T>
+    std::map<std::string, i_dense_matrix<T>> loadNpz(const std::string &path, const bool allowMap, const char *name)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::map<std::string, array_info> arrays;
+        if (!file)
+        {
+            std::cout << "Error when using " << name << ": cannot open " << path << ".\n";
+            return {};
+        }
+        if (!readZipDirectory(file, arrays, name))
+        {
+            return {};
+        }
+        return loadArrays<T>(path, file, arrays, allowMap, name);
+    }
+} // namespace i_npy
+
+// np.savez layout: one stored name.npy per matrix, data 64-byte aligned; entries up to 4 GB (no zip64)
+template <typename T>
+bool writeNpz(const std::string &path, const std::map<std::string, i_dense_matrix<T>> &matrices)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    std::string directory;
+    if (!file)
+    {
+        std::cout << "Error when using writeNpz: cannot open " << path << ".\n";
+        return false;
+    }
+    for (const auto &entry : matrices)
+    {
+        const std::string entryName{entry.first + ".npy"};
+        const i_dense_matrix<T> &matG{entry.second};
+        const std::uint64_t offset{static_cast<std::uint64_t>(file.tellp())};
+        const std::uint64_t size{i_npy::makeHeader<T>(matG.rows(), matG.cols()).size() + matG.rows() * matG.cols() * sizeof(T)};
+        if (offset > 0xffffffffu || size > 0xffffffffu)
+        {
+            std::cout << "Error when using writeNpz: archives above 4 GB (zip64) are not supported.\n";
+            return false;
+        }
+
+        // Extra field 0xd935 (as zipalign), pads the .npy start to a multiple of 64; an extra field has at least 4 bytes
+        std::size_t padding{(64 - (offset + 30 + entryName.size()) % 64) % 64};
+        padding += padding > 0 && padding < 4 ? 64 : 0;
+        std::string local;
+        i_npy::putLE(local, 0x04034b50, 4);
+        i_npy::putEntryFields(local, 0, size, entryName.size(), padding);
+        local += entryName;
+        if (padding > 0)
+        {
+            i_npy::putLE(local, 0xd935, 2);
+            i_npy::putLE(local, padding - 4, 2);
+            local.append(padding - 4, '\0');
+        }
+        file.write(local.data(), static_cast<std::streamsize>(local.size()));
+        std::uint32_t crc{0};
+        i_npy::writeArray(file, matG, &crc);
+        const std::streampos next{file.tellp()};
+        file.seekp(static_cast<std::streamoff>(offset + 14));
+        std::string crcField;
+        i_npy::putLE(crcField, crc, 4);
+        file.write(crcField.data(), 4);
+        file.seekp(next);
+
+        i_npy::putLE(directory, 0x02014b50, 4);
+        i_npy::putLE(directory, 20, 2); // Version made by
+        i_npy::putEntryFields(directory, crc, size, entryName.size(), 0);
+        i_npy::putLE(directory, 0, 2); // Comment length
+        i_npy::putLE(directory, 0, 2); // Disk number
+        i_npy::putLE(directory, 0, 2); // Internal attributes
+        i_npy::putLE(directory, 0, 4); // External attributes
+        i_npy::putLE(directory, offset, 4);
+        directory += entryName;
+    }
+    const std::uint64_t dirOffset{static_cast<std::uint64_t>(file.tellp())};
+    i_npy::putLE(directory, 0x06054b50, 4);
+    i_npy::putLE(directory, 0, 4); // Disk numbers
+    i_npy::putLE(directory, matrices.size(), 2);
+    i_npy::putLE(directory, matrices.size(), 2);
+    i_npy::putLE(directory, directory.size() - 12, 4); // Directory size, without the 12 bytes just added
+    i_npy::putLE(directory, dirOffset, 4);
+    i_npy::putLE(directory, 0, 2); // Comment length
+    file.write(directory.data(), static_cast<std::streamsize>(directory.size()));
+    if (!file || dirOffset > 0xffffffffu)
+    {
+        std::cout << "Error when using writeNpz: cannot write " << path << ".\n";
+        return false;
+    }
+    return true;
+}
+
+// Array name (without ".npy") -> matrix, all borrowed ones share one mapping
+template <typename T>
+std::map<std::string, i_dense_matrix<T>> mapNpz(const std::string &path)
+{
+    return i_npy::loadNpz<T>(path, true, "mapNpz");
+}
+
+template <typename T>
+std::map<std::string, i_dense_matrix<T>> readNpz(const std::string &path)
+{
+    return i_npy::loadNpz<T>(path, false, "readNpz");
+}
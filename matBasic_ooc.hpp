@@ -0,0 +1,206 @@
+#pragma once
+/*
+Mini Matrix Tools - Out-of-Core Tiled Matrix Multiplication
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+C = A * B for operands larger than memory, usually memory-mapped matrix files (see matBasic_file.hpp):
+    C is cut into t x t tiles, the shared dimension into slices of t: C(I, J) += A(I, K) * B(K, J)
+    the tiles A(I, K) & B(K, J) are copied out of the mapping into one of two buffer pairs
+    while the GEMM engine (see matBasic_gemm.hpp, all threads) works on one pair, a loader thread loads
+    the next pair, so page faults & disk reads overlap the computation (double buffering)
+    C(I, J) is accumulated in place; for a file created by createMatrixFile the system writes it back
+The tile size t comes from a memory budget: two buffer pairs & one tile of C, 5 * t^2 elements.
+t is a multiple of i_ooc_tile_align and never below it, so a budget under 5 * 256^2 elements (2.5 MB in double)
+cannot be met: it is rejected with an error instead of being silently exceeded.
+A is read n / t times and B m / t times, so a larger budget means less disk traffic.
+
+Main Function List:
+[1] matMulTiled: C = A * B, tile by tile with prefetch, for any (usually mapped) matrices
+[2] matMulFile:  C = A * B from two matrix files into a new one, e.g. 100000 x 100000 products on a 64 GB node
+*/
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_file.hpp"
+#include "matBasic_gemm.hpp"
+
+constexpr std::size_t i_ooc_memory_bytes{std::size_t{1} << 30}; // Default tile budget, 1 GB
+constexpr std::size_t i_ooc_tile_align{256};                     // Tiles are a multiple of the GEMM depth block (KC)
+
+namespace i_ooc
+{
+    // Smallest budget: 5 tiles of i_ooc_tile_align x i_ooc_tile_align
+    template <typename T>
+    constexpr std::size_t minMemoryBytes()
+    {
+        return 5 * i_ooc_tile_align * i_ooc_tile_align * sizeof(T);
+    }
+
+    // Largest t with 5 * t^2 elements in the budget, rounded down to i_ooc_tile_align; memoryBytes >= minMemoryBytes<T>()
+    template <typename T>
+    std::size_t tileSize(const std::size_t memoryBytes)
+    {
+        const std::size_t side{static_cast<std::size_t>(std::sqrt(static_cast<double>(memoryBytes) / (5.0 * sizeof(T))))};
+        return std::max(i_ooc_tile_align, side / i_ooc_tile_align * i_ooc_tile_align);
+    }
+
+    template <typename T>
+    bool budgetCheck(const std::size_t memoryBytes, const char *name)
+    {
+        if (memoryBytes < minMemoryBytes<T>())
+        {
+            std::cout << "Error when using " << name << ": memory budget below the minimum of " << minMemoryBytes<T>() << " bytes.\n";
+            return false;
+        }
+        return true;
+    }
+
+    template <typename T>
+    struct tile_pair
+    {
+        i_dense_matrix<T> matA; // A(I, K), the top left corner is used for edge tiles
+        i_dense_matrix<T> matB; // B(K, J)
+    };
+
+    // One step C(i0:i1, j0:j1) += A(i0:i1, p0:p1) * B(p0:p1, j0:j1)
+    struct tile_step
+    {
+        std::size_t i0, i1, j0, j1, p0, p1;
+    };
+
+    template <typename T>
+    void loadTiles(const i_dense_matrix<T> &matA, const i_dense_matrix<T> &matB, const tile_step &step, tile_pair<T> &tiles)
+    {
+        for (std::size_t i{step.i0}; i < step.i1; ++i)
+        {
+            std::copy(matA.row(i) + step.p0, matA.row(i) + step.p1, tiles.matA.row(i - step.i0));
+        }
+        for (std::size_t p{step.p0}; p < step.p1; ++p)
+        {
+            std::copy(matB.row(p) + step.j0, matB.row(p) + step.j1, tiles.matB.row(p - step.p0));
+        }
+    }
+} // namespace i_ooc
+
+// C = A * B with matC already rows(A) x cols(B), e.g. from createMatrixFile; memoryBytes bounds the tile buffers
+template <typename T>
+bool matMulTiled(const i_dense_matrix<T> &matA, const i_dense_matrix<T> &matB, i_dense_matrix<T> &matC, const std::size_t memoryBytes = i_ooc_memory_bytes)
+{
+    const std::size_t nrows{matA.rows()}, ncols{matB.cols()}, depth{matA.cols()};
+    if (matB.rows() != depth || matC.rows() != nrows || matC.cols() != ncols)
+    {
+        std::cout << "Error when using matMulTiled: dimension not match.\n";
+        return false;
+    }
+    if (!i_ooc::budgetCheck<T>(memoryBytes, "matMulTiled"))
+    {
+        return false;
+    }
+    if (depth == 0)
+    {
+        for (std::size_t i{0}; i < nrows; ++i)
+        {
+            std::fill_n(matC.row(i), ncols, T{});
+        }
+        return true;
+    }
+
+    // I, J outer & K inner: one tile of C stays hot while the slices of the shared dimension stream past
+    const std::size_t tile{i_ooc::tileSize<T>(memoryBytes)};
+    std::vector<i_ooc::tile_step> steps;
+    for (std::size_t i0{0}; i0 < nrows; i0 += tile)
+    {
+        for (std::size_t j0{0}; j0 < ncols; j0 += tile)
+        {
+            for (std::size_t p0{0}; p0 < depth; p0 += tile)
+            {
+                steps.push_back({i0, std::min(i0 + tile, nrows), j0, std::min(j0 + tile, ncols), p0, std::min(p0 + tile, depth)});
+            }
+        }
+    }
+    if (steps.empty())
+    {
+        return true; // No rows or no columns in C
+    }
+    const std::size_t tileM{std::min(tile, nrows)}, tileN{std::min(tile, ncols)}, tileK{std::min(tile, depth)};
+    std::array<i_ooc::tile_pair<T>, 2> buffers{{{i_dense_matrix<T>(tileM, tileK), i_dense_matrix<T>(tileK, tileN)},
+                                                {i_dense_matrix<T>(tileM, tileK), i_dense_matrix<T>(tileK, tileN)}}};
+
+    // One loader thread for the whole product: it fills buffer (k % 2) with step k once step k - 2 is done,
+    // the calling thread runs step s once it is loaded; loaded & computed count steps, guarded by lock
+    std::mutex lock;
+    std::condition_variable changed;
+    std::size_t loaded{1}, computed{0};
+    i_ooc::loadTiles(matA, matB, steps[0], buffers[0]);
+    std::thread loader([&]() {
+        for (std::size_t k{1}; k < steps.size(); ++k)
+        {
+            {
+                std::unique_lock<std::mutex> guard{lock};
+                changed.wait(guard, [&]() { return computed + 1 >= k; });
+            }
+            i_ooc::loadTiles(matA, matB, steps[k], buffers[k % 2]);
+            {
+                std::lock_guard<std::mutex> guard{lock};
+                loaded = k + 1;
+            }
+            changed.notify_all();
+        }
+    });
+    for (std::size_t s{0}; s < steps.size(); ++s)
+    {
+        {
+            std::unique_lock<std::mutex> guard{lock};
+            changed.wait(guard, [&]() { return loaded > s; });
+        }
+        const i_ooc::tile_step &step{steps[s]};
+        const i_ooc::tile_pair<T> &tiles{buffers[s % 2]};
+        if (step.p0 == 0)
+        {
+            for (std::size_t i{step.i0}; i < step.i1; ++i)
+            {
+                std::fill(matC.row(i) + step.j0, matC.row(i) + step.j1, T{}); // First touch of this tile of C
+            }
+        }
+        i_kernel::gemm(step.i1 - step.i0, step.j1 - step.j0, step.p1 - step.p0, tiles.matA.data(), tiles.matA.stride(), false,
+                       tiles.matB.data(), tiles.matB.stride(), false, matC.row(step.i0) + step.j0, matC.stride());
+        {
+            std::lock_guard<std::mutex> guard{lock};
+            computed = s + 1;
+        }
+        changed.notify_all();
+    }
+    loader.join();
+    return true;
+}
+
+// pathC = pathA * pathB, all three matrix files of the same element type; false (with a message) on failure
+template <typename T>
+bool matMulFile(const std::string &pathA, const std::string &pathB, const std::string &pathC, const std::size_t memoryBytes = i_ooc_memory_bytes)
+{
+    const i_dense_matrix<T> matA{mapMatrixFile<T>(pathA)}, matB{mapMatrixFile<T>(pathB)};
+    if (matA.empty() || matB.empty())
+    {
+        return false;
+    }
+    if (matA.cols() != matB.rows())
+    {
+        std::cout << "Error when using matMulFile: dimension not match.\n";
+        return false;
+    }
+    if (!i_ooc::budgetCheck<T>(memoryBytes, "matMulFile"))
+    {
+        return false;
+    }
+    i_dense_matrix<T> matC{createMatrixFile<T>(pathC, matA.rows(), matB.cols())};
+    return !matC.empty() && matMulTiled(matA, matB, matC, memoryBytes);
+}
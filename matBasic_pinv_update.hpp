@@ -0,0 +1,232 @@
+#pragma once
+/*
+Mini Matrix Tools - Incremental Pseudo-Inverse
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+Keeps A (m x n) and P = pinv(A) while columns of A come and go, e.g. an antenna going offline or coming back.
+Every change is a rank-1 correction of P, O(m * n) instead of an O(m * n^2) pinv2 from scratch [*1][*2].
+Insert column a (Greville), with d = P * a & c = a - A * d:
+    c != 0 (a is a new direction, rank + 1):    b' = c' / (c' * c)
+    c == 0 (a is in the range of A):            b' = d' * P / (1 + d' * d)
+    P = [P - d * b'; b'], row b' moved to the position of the new column
+Remove column a = A(:, k), with b' = P(k, :), Q = P without row k & beta = b' * a:
+    beta == 1 (a was a new direction, rank - 1): pinv(B) = Q - (Q * b) * b' / (b' * b)
+    beta != 1:                                  pinv(B) = Q + (Q * a) * b' / (1 - beta)
+Both cases hold for full rank & rank deficient A, the result is the Moore-Penrose inverse (same as pinv2).
+
+Main Function List:
+[1] IncrementalPseudoInverse:                Build from A by Greville's column recursion, or from A & a known pinv(A)
+[2] IncrementalPseudoInverse::pinv / matrix: Current pinv(A) & A as dense matrices
+[3] IncrementalPseudoInverse::insertColumn:  A = [A(:, 0:k), a, A(:, k:n)], appendColumn for k = n
+[4] IncrementalPseudoInverse::removeColumn:  Drop A(:, k)
+[5] IncrementalPseudoInverse::solve:         X = pinv(A) * B
+
+Reference:
+[*1] T. N. E. Greville, Some Applications of the Pseudoinverse of a Matrix, SIAM Review 2(1), 1960
+[*2] Adi Ben-Israel, Thomas N. E. Greville, Generalized Inverses: Theory and Applications (2nd ed.), Springer 2003, section 7.5
+*/
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_gemm.hpp"
+
+template <typename T>
+class IncrementalPseudoInverse
+{
+public:
+    using real_t = typename i_real_type<T>::type;
+
+    IncrementalPseudoInverse() = default;
+
+    // Greville's recursion over the columns of A, O(m * n^2)
+    explicit IncrementalPseudoInverse(const i_dense_matrix<T> &matA, const real_t tolerance = defaultTolerance<T>())
+        : m_rows{matA.rows()}, m_tolerance{tolerance}
+    {
+        for (std::size_t j{0}; j < matA.cols(); ++j)
+        {
+            insert(j, column(matA, j));
+        }
+    }
+
+    // From a pseudo-inverse computed elsewhere, e.g. matP = pinv2(matA); rank(A) = trace(P * A)
+    IncrementalPseudoInverse(const i_dense_matrix<T> &matA, const i_dense_matrix<T> &matP, const real_t tolerance = defaultTolerance<T>())
+        : m_rows{matA.rows()}, m_tolerance{tolerance}
+    {
+        if (matP.rows() != matA.cols() || matP.cols() != matA.rows())
+        {
+            std::cout << "Error when using IncrementalPseudoInverse: dimension not match.\n";
+            m_rows = 0;
+            return;
+        }
+        real_t trace{0};
+        for (std::size_t j{0}; j < matA.cols(); ++j)
+        {
+            m_colsA.push_back(column(matA, j));
+            m_rowsP.emplace_back(matP.row(j), matP.row(j) + m_rows);
+            trace += std::real(i_kernel::dot(m_rows, m_rowsP[j].data(), m_colsA[j].data()));
+        }
+        m_rank = static_cast<std::size_t>(std::max<real_t>(0, std::round(trace)));
+    }
+
+    std::size_t rows() const { return m_rows; }
+    std::size_t cols() const { return m_colsA.size(); }
+    std::size_t rank() const { return m_rank; }
+
+    i_dense_matrix<T> matrix() const
+    {
+        i_dense_matrix<T> matA(rows(), cols());
+        for (std::size_t j{0}; j < cols(); ++j)
+        {
+            for (std::size_t i{0}; i < rows(); ++i)
+            {
+                matA(i, j) = m_colsA[j][i];
+            }
+        }
+        return matA;
+    }
+
+    // pinv(A), cols() x rows()
+    i_dense_matrix<T> pinv() const
+    {
+        i_dense_matrix<T> matP(cols(), rows());
+        for (std::size_t i{0}; i < cols(); ++i)
+        {
+            std::copy_n(m_rowsP[i].data(), rows(), matP.row(i));
+        }
+        return matP;
+    }
+
+    // matCol is rows() x 1, inserted before column index
+    void insertColumn(const std::size_t index, const i_dense_matrix<T> &matCol)
+    {
+        if (matCol.rows() != rows() || matCol.cols() != 1)
+        {
+            std::cout << "Error when using IncrementalPseudoInverse::insertColumn: dimension not match.\n";
+            return;
+        }
+        if (index > cols())
+        {
+            std::cout << "Error when using IncrementalPseudoInverse::insertColumn: index out of range.\n";
+            return;
+        }
+        insert(index, column(matCol, 0));
+    }
+
+    void appendColumn(const i_dense_matrix<T> &matCol)
+    {
+        insertColumn(cols(), matCol);
+    }
+
+    void removeColumn(const std::size_t index)
+    {
+        const std::size_t nrows{rows()}, ncols{cols()};
+        if (index >= ncols)
+        {
+            std::cout << "Error when using IncrementalPseudoInverse::removeColumn: index out of range.\n";
+            return;
+        }
+        const i_aligned_vector<T> rowB{std::move(m_rowsP[index])}, colA{std::move(m_colsA[index])}; // b' & a
+        m_rowsP.erase(m_rowsP.begin() + static_cast<std::ptrdiff_t>(index));
+        m_colsA.erase(m_colsA.begin() + static_cast<std::ptrdiff_t>(index));
+        const T beta{i_kernel::dot(nrows, rowB.data(), colA.data())};
+
+        // pinv(B) = Q + coef(i) * b' row by row
+        if (std::abs(T{1} - beta) <= m_tolerance)
+        {
+            const real_t norm2B{std::real(i_kernel::dotc(nrows, rowB.data(), rowB.data()))};
+            for (i_aligned_vector<T> &rowP : m_rowsP)
+            {
+                const T coef{-i_kernel::dotc(nrows, rowB.data(), rowP.data()) / norm2B}; // -(Q * b)(i) / (b' * b)
+                i_kernel::axpy(nrows, coef, rowB.data(), rowP.data());
+            }
+            --m_rank;
+        }
+        else
+        {
+            const T scale{T{1} / (T{1} - beta)};
+            for (i_aligned_vector<T> &rowP : m_rowsP)
+            {
+                const T coef{i_kernel::dot(nrows, rowP.data(), colA.data()) * scale}; // (Q * a)(i) / (1 - beta)
+                i_kernel::axpy(nrows, coef, rowB.data(), rowP.data());
+            }
+        }
+    }
+
+    // X = pinv(A) * B
+    i_dense_matrix<T> solve(const i_dense_matrix<T> &matB) const
+    {
+        i_dense_matrix<T> matX;
+        if (matB.rows() != rows())
+        {
+            std::cout << "Error when using IncrementalPseudoInverse::solve: row size not match.\n";
+            return matX;
+        }
+        matX = i_dense_matrix<T>(cols(), matB.cols());
+        for (std::size_t i{0}; i < cols(); ++i)
+        {
+            i_kernel::gemm(1, matB.cols(), rows(), m_rowsP[i].data(), rows(), false, matB.data(), matB.stride(), false, matX.row(i), matX.stride());
+        }
+        return matX;
+    }
+
+private:
+    static i_aligned_vector<T> column(const i_dense_matrix<T> &matA, const std::size_t j)
+    {
+        i_aligned_vector<T> colA(matA.rows());
+        for (std::size_t i{0}; i < matA.rows(); ++i)
+        {
+            colA[i] = matA(i, j);
+        }
+        return colA;
+    }
+
+    // Greville step
+    void insert(const std::size_t index, i_aligned_vector<T> colA)
+    {
+        const std::size_t nrows{rows()}, ncols{cols()};
+        std::vector<T> vecD(ncols);
+        i_aligned_vector<T> vecC(colA), rowB(nrows);
+        for (std::size_t i{0}; i < ncols; ++i)
+        {
+            vecD[i] = i_kernel::dot(nrows, m_rowsP[i].data(), colA.data()); // d = P * a
+            i_kernel::axpy(nrows, -vecD[i], m_colsA[i].data(), vecC.data()); // c = a - A * d
+        }
+        const real_t norm2C{std::real(i_kernel::dotc(nrows, vecC.data(), vecC.data()))};
+        const real_t norm2A{std::real(i_kernel::dotc(nrows, colA.data(), colA.data()))};
+        if (norm2C > m_tolerance * m_tolerance * norm2A)
+        {
+            for (std::size_t j{0}; j < nrows; ++j)
+            {
+                rowB[j] = conjScalar(vecC[j]) / norm2C;
+            }
+            ++m_rank;
+        }
+        else
+        {
+            const T scale{T{1} / (T{1} + i_kernel::dotc(ncols, vecD.data(), vecD.data()))};
+            for (std::size_t i{0}; i < ncols; ++i)
+            {
+                i_kernel::axpy(nrows, conjScalar(vecD[i]) * scale, m_rowsP[i].data(), rowB.data());
+            }
+        }
+
+        for (std::size_t i{0}; i < ncols; ++i)
+        {
+            i_kernel::axpy(nrows, -vecD[i], rowB.data(), m_rowsP[i].data()); // P = P - d * b'
+        }
+        m_rowsP.insert(m_rowsP.begin() + static_cast<std::ptrdiff_t>(index), std::move(rowB));
+        m_colsA.insert(m_colsA.begin() + static_cast<std::ptrdiff_t>(index), std::move(colA));
+    }
+
+    // Column j of A & row j of P belong together, both move as one buffer when columns come & go
+    std::vector<i_aligned_vector<T>> m_colsA;
+    std::vector<i_aligned_vector<T>> m_rowsP;
+    std::size_t m_rows{0};
+    real_t m_tolerance{defaultTolerance<T>()};
+    std::size_t m_rank{0};
+};
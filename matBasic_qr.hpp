@@ -0,0 +1,260 @@
+#pragma once
+/*
+Mini Matrix Tools - Blocked Householder QR Factorization
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+A = Q * R for a tall matrix (rows >= cols), Q = H(1) * H(2) * ... * H(n), H(i) = I - tau(i) * v(i) * v(i)'.
+Blocked like LAPACK geqrf [*1][*2]:
+    for each panel of i_qr_block columns:
+        factor the panel with Householder reflectors (row axpys)
+        build the compact WY form of the panel, H(jb) * ... * H(je) = I - V * T * V'
+        A2 = (I - V * T' * V') * A2 with three GEMMs (see matBasic_gemm.hpp)
+Q is never formed: the reflectors stay below the diagonal of the packed matrix, R on and above it.
+Least squares never forms A' * A, so the condition number is not squared.
+
+Main Function List:
+[1] QRFactorization::solve:        X = A \ B in the least squares sense, any number of right-hand sides
+[2] QRFactorization::applyAdjointQ: Q' * B, block by block in compact WY form
+[3] QRFactorization::fullRank:     false if some |R(i, i)| <= tolerance * max|R(i, i)|
+
+Reference:
+[*1] Robert Schreiber, Charles Van Loan, A Storage-Efficient WY Representation for Products of Householder Transformations, SIAM J. Sci. Stat. Comput. 10(1), 1989
+[*2] LAPACK, zlarfg / zlarft / zgeqrf, https://www.netlib.org/lapack/
+*/
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_gemm.hpp"
+
+constexpr std::size_t i_qr_block{32}; // Panel width of the compact WY blocks
+
+template <typename T>
+class QRFactorization
+{
+public:
+    using real_t = typename i_real_type<T>::type;
+
+    QRFactorization() = default;
+
+    explicit QRFactorization(const i_dense_matrix<T> &matA, const real_t tolerance = defaultTolerance<T>())
+    {
+        if (matA.rows() < matA.cols())
+        {
+            std::cout << "Error when using QRFactorization: matrix has more columns than rows.\n";
+            return;
+        }
+        m_qr = matA;
+        factor(tolerance);
+    }
+
+    bool empty() const { return m_qr.empty(); }
+    bool fullRank() const { return m_fullRank; }
+    std::size_t rows() const { return m_qr.rows(); }
+    std::size_t cols() const { return m_qr.cols(); }
+    const i_dense_matrix<T> &packedQR() const { return m_qr; }
+
+    // Q' * B without forming Q
+    i_dense_matrix<T> applyAdjointQ(const i_dense_matrix<T> &matB) const
+    {
+        i_dense_matrix<T> matC;
+        if (matB.rows() != rows())
+        {
+            std::cout << "Error when using QRFactorization::applyAdjointQ: row size not match.\n";
+            return matC;
+        }
+        matC = matB;
+        for (std::size_t b{0}; b < m_blockT.size(); ++b)
+        {
+            const std::size_t jb{b * i_qr_block}, je{std::min(jb + i_qr_block, cols())};
+            applyBlockAdjoint(jb, je, m_blockT[b], matC.row(jb), matC.stride(), matC.cols());
+        }
+        return matC;
+    }
+
+    // X = argmin ||A * X - B||: R * X = (Q' * B)(0:n, :)
+    i_dense_matrix<T> solve(const i_dense_matrix<T> &matB) const
+    {
+        const std::size_t ncols{cols()}, nrhs{matB.cols()};
+        i_dense_matrix<T> matX;
+        if (matB.rows() != rows())
+        {
+            std::cout << "Error when using QRFactorization::solve: row size not match.\n";
+            return matX;
+        }
+        if (!m_fullRank)
+        {
+            std::cout << "Warning when using QRFactorization::solve: matrix is rank deficient.\n";
+            return matX;
+        }
+        const i_dense_matrix<T> matQtB{applyAdjointQ(matB)};
+        matX = i_dense_matrix<T>(ncols, nrhs);
+        for (std::size_t i{ncols}; i > 0; --i)
+        {
+            const std::size_t ii{i - 1};
+            T *rowX{matX.row(ii)};
+            std::copy_n(matQtB.row(ii), nrhs, rowX);
+            for (std::size_t q{ii + 1}; q < ncols; ++q)
+            {
+                i_kernel::axpy(nrhs, -m_qr(ii, q), matX.row(q), rowX);
+            }
+            const T diagInv{T{1} / m_qr(ii, ii)};
+            for (std::size_t j{0}; j < nrhs; ++j)
+            {
+                rowX[j] *= diagInv;
+            }
+        }
+        return matX;
+    }
+
+private:
+    // C = (I - V * T * V')' * C = C - V * (T' * (V' * C)), C holds rows jb:m with leading dimension ldc.
+    // V = [V1; V2] is read in place: V1 = unit lower triangle of A(jb:je, jb:je), V2 = A(je:m, jb:je)
+    void applyBlockAdjoint(const std::size_t jb, const std::size_t je, const i_dense_matrix<T> &matT,
+                           T *matC, const std::size_t ldc, const std::size_t ncols) const
+    {
+        const std::size_t nrows{rows()}, nb{je - jb}, ld{m_qr.stride()};
+        i_dense_matrix<T> matW(nb, ncols), matTW(nb, ncols);
+        for (std::size_t p{0}; p < nb; ++p)
+        {
+            std::copy_n(matC + p * ldc, ncols, matW.row(p));
+        }
+        for (std::size_t r{1}; r < nb; ++r)
+        {
+            for (std::size_t p{0}; p < r; ++p)
+            {
+                i_kernel::axpy(ncols, conjScalar(m_qr(jb + r, jb + p)), matC + r * ldc, matW.row(p)); // W = V1' * C1
+            }
+        }
+        i_kernel::gemm(nb, ncols, nrows - je, m_qr.row(je) + jb, ld, true, matC + nb * ldc, ldc, false, matW.data(), matW.stride()); // W += V2' * C2
+        i_kernel::gemm(nb, ncols, nb, matT.data(), matT.stride(), true, matW.data(), matW.stride(), false, matTW.data(), matTW.stride());
+        i_kernel::gemm(nrows - je, ncols, nb, m_qr.row(je) + jb, ld, false, matTW.data(), matTW.stride(), false, matC + nb * ldc, ldc, T{-1}); // C2 -= V2 * TW
+        for (std::size_t r{0}; r < nb; ++r)
+        {
+            T *rowC{matC + r * ldc};
+            i_kernel::axpy(ncols, T{-1}, matTW.row(r), rowC); // C1 -= V1 * TW
+            for (std::size_t p{0}; p < r; ++p)
+            {
+                i_kernel::axpy(ncols, -m_qr(jb + r, jb + p), matTW.row(p), rowC);
+            }
+        }
+    }
+
+    void factor(const real_t tolerance)
+    {
+        const std::size_t nrows{rows()}, ncols{cols()};
+        m_tau.assign(ncols, T{});
+        m_blockT.clear();
+
+        for (std::size_t jb{0}; jb < ncols; jb += i_qr_block)
+        {
+            const std::size_t je{std::min(jb + i_qr_block, ncols)}, nb{je - jb};
+
+            // ******************** Step 1: Householder reflectors of the panel, columns jb:je ********************
+            // Work on a transposed copy so that every column is contiguous: long SIMD dot products & axpys
+            const std::size_t len{nrows - jb};
+            i_dense_matrix<T> panelT(nb, len);
+            for (std::size_t i{0}; i < len; ++i)
+            {
+                const T *rowA{m_qr.row(jb + i) + jb};
+                for (std::size_t c{0}; c < nb; ++c)
+                {
+                    panelT(c, i) = rowA[c];
+                }
+            }
+            for (std::size_t c{0}; c < nb; ++c)
+            {
+                // H' * [alpha; x] = [beta; 0], beta real
+                T *colC{panelT.row(c) + c};
+                const std::size_t nx{len - c - 1};
+                const T alpha{colC[0]};
+                const real_t xnorm2{std::real(i_kernel::dotc(nx, colC + 1, colC + 1))};
+                T &tau{m_tau[jb + c]};
+                if (xnorm2 == 0 && std::imag(alpha) == 0)
+                {
+                    tau = T{}; // H = I
+                    continue;
+                }
+                const real_t beta{-std::copysign(std::sqrt(std::norm(alpha) + xnorm2), std::real(alpha))};
+                tau = (T{beta} - alpha) / T{beta};
+                const T scale{T{1} / (alpha - T{beta})};
+                for (std::size_t i{1}; i <= nx; ++i)
+                {
+                    colC[i] *= scale;
+                }
+                colC[0] = T{beta};
+
+                // A(:, q) = H' * A(:, q) = A(:, q) - conj(tau) * v * (v' * A(:, q)), v(0) = 1
+                for (std::size_t q{c + 1}; q < nb; ++q)
+                {
+                    T *colQ{panelT.row(q) + c};
+                    const T w{conjScalar(tau) * (colQ[0] + i_kernel::dotc(nx, colC + 1, colQ + 1))};
+                    colQ[0] -= w;
+                    i_kernel::axpy(nx, -w, colC + 1, colQ + 1);
+                }
+            }
+            for (std::size_t i{0}; i < len; ++i)
+            {
+                T *rowA{m_qr.row(jb + i) + jb};
+                for (std::size_t c{0}; c < nb; ++c)
+                {
+                    rowA[c] = panelT(c, i);
+                }
+            }
+
+            // ******************** Step 2: compact WY, T(0:i, i) = -tau(i) * T(0:i, 0:i) * V(:, 0:i)' * v(i) ********************
+            i_dense_matrix<T> matS(nb, nb), matT(nb, nb);
+            for (std::size_t q{1}; q < nb; ++q)
+            {
+                for (std::size_t p{0}; p < q; ++p)
+                {
+                    matS(p, q) = conjScalar(panelT(p, q)) + i_kernel::dotc(len - q - 1, panelT.row(p) + q + 1, panelT.row(q) + q + 1); // v(p)' * v(q)
+                }
+            }
+            for (std::size_t i{0}; i < nb; ++i)
+            {
+                const T tau{m_tau[jb + i]};
+                for (std::size_t p{0}; p < i; ++p)
+                {
+                    T sum{};
+                    for (std::size_t q{p}; q < i; ++q)
+                    {
+                        sum += matT(p, q) * matS(q, i);
+                    }
+                    matT(p, i) = -tau * sum;
+                }
+                matT(i, i) = tau;
+            }
+
+            // ******************** Step 3: A(jb:m, je:n) = (I - V * T' * V') * A(jb:m, je:n) ********************
+            if (je < ncols)
+            {
+                applyBlockAdjoint(jb, je, matT, m_qr.row(jb) + je, m_qr.stride(), ncols - je);
+            }
+            m_blockT.push_back(std::move(matT));
+        }
+
+        real_t maxDiag{0};
+        for (std::size_t i{0}; i < ncols; ++i)
+        {
+            maxDiag = std::max(maxDiag, static_cast<real_t>(std::abs(m_qr(i, i))));
+        }
+        m_fullRank = maxDiag > 0;
+        for (std::size_t i{0}; i < ncols; ++i)
+        {
+            if (!(std::abs(m_qr(i, i)) > tolerance * maxDiag))
+            {
+                m_fullRank = false;
+            }
+        }
+    }
+
+    i_dense_matrix<T> m_qr;
+    std::vector<T> m_tau;
+    std::vector<i_dense_matrix<T>> m_blockT;
+    bool m_fullRank{false};
+};
@@ -0,0 +1,382 @@
+#pragma once
+/*
+Mini Matrix Tools - Runtime-Dispatched SIMD Kernels
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+The instruction set is detected once with cpuid/xgetbv, so one binary picks AVX-512, AVX2+FMA or the
+portable scalar code on each machine. The portable kernels & the dispatch are here; the double &
+std::complex<double> kernels are in matBasic_simd_avx2.hpp & matBasic_simd_avx512.hpp (included before the
+dispatch), the float & std::complex<float> ones in matBasic_simd_float.hpp (included at the end); other scalar
+types always use the portable templates. Non-x86 targets and MSVC build the scalar code only.
+
+Main Function List:
+[1] simdLevel:              Instruction set in use (detected at first use)
+[2] setSimdLevel:           Force a lower instruction set (e.g. for testing), clamped to what the CPU supports
+[3] i_kernel::dot:          sum(x[i] * y[i])
+[4] i_kernel::dotc:         sum(conj(x[i]) * y[i])
+[5] i_kernel::axpy:         y[i] += a * x[i]
+[6] i_kernel::gemmMicroKernel: MR x NR GEMM register micro-kernel for the current instruction set
+
+Reference:
+[*1] Intel 64 and IA-32 Architectures Software Developer's Manual, Vol. 2A, CPUID & XGETBV
+*/
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include "matBasic_dense.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define I_SIMD_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#define I_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define I_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#define I_UNROLL _Pragma("GCC unroll 16") // Fully unrolled tile loops keep the accumulators in registers
+#else
+#define I_SIMD_X86 0
+#endif
+
+enum class i_simd_level : int
+{
+    scalar = 0,
+    avx2 = 1, // AVX2 + FMA3
+    avx512 = 2 // AVX-512F
+};
+
+// Query cpuid for AVX2/FMA/AVX-512F and xgetbv for the OS saving the wide registers [*1]
+inline i_simd_level detectSimdLevel()
+{
+#if I_SIMD_X86
+    unsigned int eax{0}, ebx{0}, ecx{0}, edx{0};
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return i_simd_level::scalar;
+    }
+    const bool hasFma{(ecx & (1u << 12)) != 0}, hasOsxsave{(ecx & (1u << 27)) != 0}, hasAvx{(ecx & (1u << 28)) != 0};
+    if (!hasFma || !hasOsxsave || !hasAvx)
+    {
+        return i_simd_level::scalar;
+    }
+    unsigned int xcr0{0}, xcr0High{0};
+    __asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+    if ((xcr0 & 0x6u) != 0x6u) // XMM & YMM state
+    {
+        return i_simd_level::scalar;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    {
+        return i_simd_level::scalar;
+    }
+    const bool hasAvx2{(ebx & (1u << 5)) != 0}, hasAvx512f{(ebx & (1u << 16)) != 0};
+    if (hasAvx512f && (xcr0 & 0xe6u) == 0xe6u) // Opmask & ZMM state as well
+    {
+        return i_simd_level::avx512;
+    }
+    if (hasAvx2)
+    {
+        return i_simd_level::avx2;
+    }
+#endif
+    return i_simd_level::scalar;
+}
+
+inline std::atomic<int> &simdLevelStorage()
+{
+    static std::atomic<int> level{static_cast<int>(detectSimdLevel())};
+    return level;
+}
+
+inline i_simd_level simdLevel()
+{
+    return static_cast<i_simd_level>(simdLevelStorage().load(std::memory_order_relaxed));
+}
+
+inline void setSimdLevel(const i_simd_level level)
+{
+    simdLevelStorage().store(std::min(static_cast<int>(level), static_cast<int>(detectSimdLevel())));
+}
+
+inline const char *simdLevelName(const i_simd_level level)
+{
+    return level == i_simd_level::avx512 ? "AVX-512" : (level == i_simd_level::avx2 ? "AVX2+FMA" : "scalar");
+}
+
+template <typename T>
+struct i_gemm_micro
+{
+    std::size_t MR; // Rows of the register tile
+    std::size_t NR; // Columns of the register tile
+    void (*kernel)(std::size_t kc, const T *packA, const T *packB, T *matC, std::size_t ldc, std::size_t mr, std::size_t nr, T alpha);
+};
+
+namespace i_kernel
+{
+    // ******************** Portable scalar kernels (any scalar type) ********************
+    template <typename T>
+    T dot(const std::size_t n, const T *x, const T *y)
+    {
+        T sum{};
+        for (std::size_t i{0}; i < n; ++i)
+        {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+
+    template <typename T>
+    T dotc(const std::size_t n, const T *x, const T *y)
+    {
+        T sum{};
+        for (std::size_t i{0}; i < n; ++i)
+        {
+            sum += conjScalar(x[i]) * y[i];
+        }
+        return sum;
+    }
+
+    template <typename T>
+    void axpy(const std::size_t n, const T a, const T *x, T *y)
+    {
+        for (std::size_t i{0}; i < n; ++i)
+        {
+            y[i] += a * x[i];
+        }
+    }
+
+    // C(0:mr, 0:nr) += alpha * tile, tile is MR x NR row-major
+    template <typename T>
+    void addTile(const T *tile, const std::size_t NR, T *matC, const std::size_t ldc, const std::size_t mr, const std::size_t nr, const T alpha)
+    {
+        for (std::size_t i{0}; i < mr; ++i)
+        {
+            T *rowC{matC + i * ldc};
+            for (std::size_t j{0}; j < nr; ++j)
+            {
+                rowC[j] += alpha * tile[i * NR + j];
+            }
+        }
+    }
+
+    // Complex tile with plain multiply-adds (std::complex operator* checks for inf/nan on every call)
+    template <typename R>
+    void addTile(const std::complex<R> *tile, const std::size_t NR, std::complex<R> *matC, const std::size_t ldc, const std::size_t mr, const std::size_t nr, const std::complex<R> alpha)
+    {
+        for (std::size_t i{0}; i < mr; ++i)
+        {
+            std::complex<R> *rowC{matC + i * ldc};
+            for (std::size_t j{0}; j < nr; ++j)
+            {
+                const std::complex<R> value{tile[i * NR + j]};
+                rowC[j] += std::complex<R>{alpha.real() * value.real() - alpha.imag() * value.imag(),
+                                           alpha.real() * value.imag() + alpha.imag() * value.real()};
+            }
+        }
+    }
+
+    // MR x NR register tile: accumulate kc rank-1 updates of MR-row A and NR-column B micro-panels
+    template <typename T, std::size_t MR, std::size_t NR>
+    void microKernelScalar(const std::size_t kc, const T *packA, const T *packB, T *matC, const std::size_t ldc,
+                           const std::size_t mr, const std::size_t nr, const T alpha)
+    {
+        T acc[MR * NR]{};
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const T valA{packA[i]};
+                for (std::size_t j{0}; j < NR; ++j)
+                {
+                    acc[i * NR + j] += valA * packB[j];
+                }
+            }
+            packA += MR;
+            packB += NR;
+        }
+        addTile(acc, NR, matC, ldc, mr, nr, alpha);
+    }
+
+    // Complex tile keeps real & imaginary accumulators apart
+    template <typename R, std::size_t MR, std::size_t NR>
+    void microKernelScalarComplex(const std::size_t kc, const std::complex<R> *packA, const std::complex<R> *packB, std::complex<R> *matC, const std::size_t ldc,
+                                  const std::size_t mr, const std::size_t nr, const std::complex<R> alpha)
+    {
+        const R *valsA{reinterpret_cast<const R *>(packA)}, *valsB{reinterpret_cast<const R *>(packB)};
+        R accRe[MR][NR]{}, accIm[MR][NR]{};
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const R aRe{valsA[2 * i]}, aIm{valsA[2 * i + 1]};
+                for (std::size_t j{0}; j < NR; ++j)
+                {
+                    accRe[i][j] += aRe * valsB[2 * j] - aIm * valsB[2 * j + 1];
+                    accIm[i][j] += aRe * valsB[2 * j + 1] + aIm * valsB[2 * j];
+                }
+            }
+            valsA += 2 * MR;
+            valsB += 2 * NR;
+        }
+        std::complex<R> tile[MR * NR];
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            for (std::size_t j{0}; j < NR; ++j)
+            {
+                tile[i * NR + j] = std::complex<R>{accRe[i][j], accIm[i][j]};
+            }
+        }
+        addTile(tile, NR, matC, ldc, mr, nr, alpha);
+    }
+
+    template <typename T>
+    struct i_scalar_micro
+    {
+        static i_gemm_micro<T> get() { return {4, 8, &microKernelScalar<T, 4, 8>}; }
+    };
+
+    template <typename R>
+    struct i_scalar_micro<std::complex<R>>
+    {
+        static i_gemm_micro<std::complex<R>> get() { return {4, 4, &microKernelScalarComplex<R, 4, 4>}; }
+    };
+
+} // namespace i_kernel
+
+#include "matBasic_simd_avx2.hpp"   // AVX2 + FMA kernels (double & std::complex<double>)
+#include "matBasic_simd_avx512.hpp" // AVX-512F kernels (double & std::complex<double>)
+
+namespace i_kernel
+{
+    // ******************** Dispatch (double & std::complex<double>) ********************
+    inline double dot(const std::size_t n, const double *x, const double *y)
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return dotAvx512(n, x, y);
+        case i_simd_level::avx2:
+            return dotAvx2(n, x, y);
+        default:
+            break;
+        }
+#endif
+        return dot<double>(n, x, y);
+    }
+
+    inline double dotc(const std::size_t n, const double *x, const double *y)
+    {
+        return dot(n, x, y);
+    }
+
+    inline void axpy(const std::size_t n, const double a, const double *x, double *y)
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return axpyAvx512(n, a, x, y);
+        case i_simd_level::avx2:
+            return axpyAvx2(n, a, x, y);
+        default:
+            break;
+        }
+#endif
+        axpy<double>(n, a, x, y);
+    }
+
+    inline std::complex<double> dotComplex(const std::size_t n, const std::complex<double> *x, const std::complex<double> *y, const bool conjX)
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return dotComplexAvx512(n, x, y, conjX);
+        case i_simd_level::avx2:
+            return dotComplexAvx2(n, x, y, conjX);
+        default:
+            break;
+        }
+#endif
+        double sumRe{0.0}, sumIm{0.0};
+        for (std::size_t i{0}; i < n; ++i)
+        {
+            const double xIm{conjX ? -x[i].imag() : x[i].imag()};
+            sumRe += x[i].real() * y[i].real() - xIm * y[i].imag();
+            sumIm += x[i].real() * y[i].imag() + xIm * y[i].real();
+        }
+        return {sumRe, sumIm};
+    }
+
+    inline std::complex<double> dot(const std::size_t n, const std::complex<double> *x, const std::complex<double> *y)
+    {
+        return dotComplex(n, x, y, false);
+    }
+
+    inline std::complex<double> dotc(const std::size_t n, const std::complex<double> *x, const std::complex<double> *y)
+    {
+        return dotComplex(n, x, y, true);
+    }
+
+    inline void axpy(const std::size_t n, const std::complex<double> a, const std::complex<double> *x, std::complex<double> *y)
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return axpyComplexAvx512(n, a, x, y);
+        case i_simd_level::avx2:
+            return axpyComplexAvx2(n, a, x, y);
+        default:
+            break;
+        }
+#endif
+        for (std::size_t i{0}; i < n; ++i)
+        {
+            y[i] += std::complex<double>{a.real() * x[i].real() - a.imag() * x[i].imag(), a.real() * x[i].imag() + a.imag() * x[i].real()};
+        }
+    }
+
+    template <typename T>
+    i_gemm_micro<T> gemmMicroKernel()
+    {
+        return i_scalar_micro<T>::get();
+    }
+
+    template <>
+    inline i_gemm_micro<double> gemmMicroKernel<double>()
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return {8, 16, &microKernelAvx512};
+        case i_simd_level::avx2:
+            return {6, 8, &microKernelAvx2};
+        default:
+            break;
+        }
+#endif
+        return i_scalar_micro<double>::get();
+    }
+
+    template <>
+    inline i_gemm_micro<std::complex<double>> gemmMicroKernel<std::complex<double>>()
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return {4, 8, &microKernelComplexAvx512};
+        case i_simd_level::avx2:
+            return {3, 4, &microKernelComplexAvx2};
+        default:
+            break;
+        }
+#endif
+        return i_scalar_micro<std::complex<double>>::get();
+    }
+} // namespace i_kernel
+
+#include "matBasic_simd_float.hpp" // float & std::complex<float> kernels, same dispatch
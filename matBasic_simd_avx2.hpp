@@ -0,0 +1,181 @@
+#pragma once
+/*
+Mini Matrix Tools - AVX2 + FMA Kernels (double & std::complex<double>)
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+Part of matBasic_simd.hpp, which includes this file between the portable kernels & the dispatch: the target
+macros, addTile & cpuid detection come from there, so include matBasic_simd.hpp rather than this file.
+Every function is compiled with the AVX2/FMA target attribute and only called after simdLevel() confirmed it.
+
+Main Function List:
+[1] dotAvx2 / dotComplexAvx2:            Dot products, two accumulators in flight
+[2] axpyAvx2 / axpyComplexAvx2:          y += a * x
+[3] microKernelAvx2 / microKernelComplexAvx2: 6 x 8 real & 3 x 4 complex GEMM register tiles
+
+Reference:
+[*1] Intel Intrinsics Guide, https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html
+*/
+#include <complex>
+#include <cstddef>
+
+namespace i_kernel
+{
+#if I_SIMD_X86
+    // ******************** AVX2 + FMA kernels (double) [*1] ********************
+    I_TARGET_AVX2 inline double horizontalSum(const __m256d value)
+    {
+        const __m128d pair{_mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1))};
+        return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    }
+
+    I_TARGET_AVX2 inline double dotAvx2(const std::size_t n, const double *x, const double *y)
+    {
+        __m256d acc0{_mm256_setzero_pd()}, acc1{_mm256_setzero_pd()};
+        std::size_t i{0};
+        for (; i + 8 <= n; i += 8)
+        {
+            acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+            acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), acc1);
+        }
+        double sum{horizontalSum(_mm256_add_pd(acc0, acc1))};
+        for (; i < n; ++i)
+        {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+
+    I_TARGET_AVX2 inline void axpyAvx2(const std::size_t n, const double a, const double *x, double *y)
+    {
+        const __m256d valA{_mm256_set1_pd(a)};
+        std::size_t i{0};
+        for (; i + 4 <= n; i += 4)
+        {
+            _mm256_storeu_pd(y + i, _mm256_fmadd_pd(valA, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        for (; i < n; ++i)
+        {
+            y[i] += a * x[i];
+        }
+    }
+
+    // Interleaved complex: p += x * y, q += x * swap(y), real/imag parts are recombined once at the end
+    I_TARGET_AVX2 inline std::complex<double> dotComplexAvx2(const std::size_t n, const std::complex<double> *x, const std::complex<double> *y, const bool conjX)
+    {
+        const double *valsX{reinterpret_cast<const double *>(x)}, *valsY{reinterpret_cast<const double *>(y)};
+        __m256d accP{_mm256_setzero_pd()}, accQ{_mm256_setzero_pd()};
+        std::size_t i{0};
+        for (; i + 2 <= n; i += 2)
+        {
+            const __m256d vx{_mm256_loadu_pd(valsX + 2 * i)}, vy{_mm256_loadu_pd(valsY + 2 * i)};
+            accP = _mm256_fmadd_pd(vx, vy, accP);
+            accQ = _mm256_fmadd_pd(vx, _mm256_permute_pd(vy, 0x5), accQ);
+        }
+        alignas(32) double lanesP[4], lanesQ[4];
+        _mm256_store_pd(lanesP, accP);
+        _mm256_store_pd(lanesQ, accQ);
+        const double pEven{lanesP[0] + lanesP[2]}, pOdd{lanesP[1] + lanesP[3]}, qEven{lanesQ[0] + lanesQ[2]}, qOdd{lanesQ[1] + lanesQ[3]};
+        double sumRe{conjX ? pEven + pOdd : pEven - pOdd}, sumIm{conjX ? qEven - qOdd : qEven + qOdd};
+        for (; i < n; ++i)
+        {
+            const double xIm{conjX ? -x[i].imag() : x[i].imag()};
+            sumRe += x[i].real() * y[i].real() - xIm * y[i].imag();
+            sumIm += x[i].real() * y[i].imag() + xIm * y[i].real();
+        }
+        return {sumRe, sumIm};
+    }
+
+    // y += a * x as fmaddsub(a.re, x, a.im * swap(x))
+    I_TARGET_AVX2 inline void axpyComplexAvx2(const std::size_t n, const std::complex<double> a, const std::complex<double> *x, std::complex<double> *y)
+    {
+        const double *valsX{reinterpret_cast<const double *>(x)};
+        double *valsY{reinterpret_cast<double *>(y)};
+        const __m256d aRe{_mm256_set1_pd(a.real())}, aIm{_mm256_set1_pd(a.imag())};
+        std::size_t i{0};
+        for (; i + 2 <= n; i += 2)
+        {
+            const __m256d vx{_mm256_loadu_pd(valsX + 2 * i)};
+            const __m256d prod{_mm256_fmaddsub_pd(aRe, vx, _mm256_mul_pd(aIm, _mm256_permute_pd(vx, 0x5)))};
+            _mm256_storeu_pd(valsY + 2 * i, _mm256_add_pd(_mm256_loadu_pd(valsY + 2 * i), prod));
+        }
+        for (; i < n; ++i)
+        {
+            y[i] += std::complex<double>{a.real() * x[i].real() - a.imag() * x[i].imag(), a.real() * x[i].imag() + a.imag() * x[i].real()};
+        }
+    }
+
+    // 6 x 8 real tile in 12 ymm accumulators
+    I_TARGET_AVX2 inline void microKernelAvx2(const std::size_t kc, const double *packA, const double *packB, double *matC, const std::size_t ldc,
+                                               const std::size_t mr, const std::size_t nr, const double alpha)
+    {
+        constexpr std::size_t MR{6}, NR{8};
+        __m256d acc[MR][2];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            acc[i][0] = _mm256_setzero_pd();
+            acc[i][1] = _mm256_setzero_pd();
+        }
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            const __m256d b0{_mm256_loadu_pd(packB)}, b1{_mm256_loadu_pd(packB + 4)};
+            I_UNROLL
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const __m256d a{_mm256_broadcast_sd(packA + i)};
+                acc[i][0] = _mm256_fmadd_pd(a, b0, acc[i][0]);
+                acc[i][1] = _mm256_fmadd_pd(a, b1, acc[i][1]);
+            }
+            packA += MR;
+            packB += NR;
+        }
+        alignas(32) double tile[MR * NR];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            _mm256_store_pd(tile + i * NR, acc[i][0]);
+            _mm256_store_pd(tile + i * NR + 4, acc[i][1]);
+        }
+        addTile(tile, NR, matC, ldc, mr, nr, alpha);
+    }
+
+    // 3 x 4 complex tile: acc += a.re * b and a.im * b, combined with addsub(accRe, swap(accIm)) at the end
+    I_TARGET_AVX2 inline void microKernelComplexAvx2(const std::size_t kc, const std::complex<double> *packA, const std::complex<double> *packB, std::complex<double> *matC, const std::size_t ldc,
+                                                      const std::size_t mr, const std::size_t nr, const std::complex<double> alpha)
+    {
+        constexpr std::size_t MR{3}, NR{4};
+        const double *valsA{reinterpret_cast<const double *>(packA)}, *valsB{reinterpret_cast<const double *>(packB)};
+        __m256d accRe[MR][2], accIm[MR][2];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            accRe[i][0] = accRe[i][1] = accIm[i][0] = accIm[i][1] = _mm256_setzero_pd();
+        }
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            const __m256d b0{_mm256_loadu_pd(valsB)}, b1{_mm256_loadu_pd(valsB + 4)};
+            I_UNROLL
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const __m256d aRe{_mm256_broadcast_sd(valsA + 2 * i)}, aIm{_mm256_broadcast_sd(valsA + 2 * i + 1)};
+                accRe[i][0] = _mm256_fmadd_pd(aRe, b0, accRe[i][0]);
+                accRe[i][1] = _mm256_fmadd_pd(aRe, b1, accRe[i][1]);
+                accIm[i][0] = _mm256_fmadd_pd(aIm, b0, accIm[i][0]);
+                accIm[i][1] = _mm256_fmadd_pd(aIm, b1, accIm[i][1]);
+            }
+            valsA += 2 * MR;
+            valsB += 2 * NR;
+        }
+        alignas(32) std::complex<double> tile[MR * NR];
+        double *valsTile{reinterpret_cast<double *>(tile)};
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            _mm256_store_pd(valsTile + 2 * i * NR, _mm256_addsub_pd(accRe[i][0], _mm256_permute_pd(accIm[i][0], 0x5)));
+            _mm256_store_pd(valsTile + 2 * i * NR + 4, _mm256_addsub_pd(accRe[i][1], _mm256_permute_pd(accIm[i][1], 0x5)));
+        }
+        addTile(tile, NR, matC, ldc, mr, nr, alpha);
+    }
+#endif
+} // namespace i_kernel
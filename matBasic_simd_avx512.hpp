@@ -0,0 +1,197 @@
+#pragma once
+/*
+Mini Matrix Tools - AVX-512F Kernels (double & std::complex<double>)
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+Part of matBasic_simd.hpp, which includes this file between the portable kernels & the dispatch: the target
+macros, addTile & cpuid detection come from there, so include matBasic_simd.hpp rather than this file.
+Same schemes as the AVX2 kernels with twice the lanes; the remainders use masked loads & stores.
+
+Main Function List:
+[1] dotAvx512 / dotComplexAvx512:            Dot products
+[2] axpyAvx512 / axpyComplexAvx512:          y += a * x
+[3] microKernelAvx512 / microKernelComplexAvx512: 8 x 16 real & 4 x 8 complex GEMM register tiles
+
+Reference:
+[*1] Intel Intrinsics Guide, https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html
+*/
+#include <complex>
+#include <cstddef>
+
+namespace i_kernel
+{
+#if I_SIMD_X86
+    // ******************** AVX-512F kernels (double) [*1] ********************
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push // GCC 12 flags the _mm512_undefined_pd() idiom inside its own intrinsic headers
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+    I_TARGET_AVX512 inline double dotAvx512(const std::size_t n, const double *x, const double *y)
+    {
+        __m512d acc0{_mm512_setzero_pd()}, acc1{_mm512_setzero_pd()};
+        std::size_t i{0};
+        for (; i + 16 <= n; i += 16)
+        {
+            acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+            acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), acc1);
+        }
+        if (i < n) // Masked tail
+        {
+            const std::size_t rest{std::min<std::size_t>(n - i, 8)};
+            const __mmask8 mask{static_cast<__mmask8>((1u << rest) - 1u)};
+            acc0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), acc0);
+            i += rest;
+        }
+        double sum{_mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1))};
+        for (; i < n; ++i)
+        {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+
+    I_TARGET_AVX512 inline void axpyAvx512(const std::size_t n, const double a, const double *x, double *y)
+    {
+        const __m512d valA{_mm512_set1_pd(a)};
+        std::size_t i{0};
+        for (; i + 8 <= n; i += 8)
+        {
+            _mm512_storeu_pd(y + i, _mm512_fmadd_pd(valA, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+        }
+        if (i < n)
+        {
+            const __mmask8 mask{static_cast<__mmask8>((1u << (n - i)) - 1u)};
+            _mm512_mask_storeu_pd(y + i, mask, _mm512_fmadd_pd(valA, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i)));
+        }
+    }
+
+    I_TARGET_AVX512 inline std::complex<double> dotComplexAvx512(const std::size_t n, const std::complex<double> *x, const std::complex<double> *y, const bool conjX)
+    {
+        const double *valsX{reinterpret_cast<const double *>(x)}, *valsY{reinterpret_cast<const double *>(y)};
+        __m512d accP{_mm512_setzero_pd()}, accQ{_mm512_setzero_pd()};
+        std::size_t i{0};
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m512d vx{_mm512_loadu_pd(valsX + 2 * i)}, vy{_mm512_loadu_pd(valsY + 2 * i)};
+            accP = _mm512_fmadd_pd(vx, vy, accP);
+            accQ = _mm512_fmadd_pd(vx, _mm512_permute_pd(vy, 0x55), accQ);
+        }
+        alignas(64) double lanesP[8], lanesQ[8];
+        _mm512_store_pd(lanesP, accP);
+        _mm512_store_pd(lanesQ, accQ);
+        double pEven{0.0}, pOdd{0.0}, qEven{0.0}, qOdd{0.0};
+        for (std::size_t lane{0}; lane < 8; lane += 2)
+        {
+            pEven += lanesP[lane];
+            pOdd += lanesP[lane + 1];
+            qEven += lanesQ[lane];
+            qOdd += lanesQ[lane + 1];
+        }
+        double sumRe{conjX ? pEven + pOdd : pEven - pOdd}, sumIm{conjX ? qEven - qOdd : qEven + qOdd};
+        for (; i < n; ++i)
+        {
+            const double xIm{conjX ? -x[i].imag() : x[i].imag()};
+            sumRe += x[i].real() * y[i].real() - xIm * y[i].imag();
+            sumIm += x[i].real() * y[i].imag() + xIm * y[i].real();
+        }
+        return {sumRe, sumIm};
+    }
+
+    I_TARGET_AVX512 inline void axpyComplexAvx512(const std::size_t n, const std::complex<double> a, const std::complex<double> *x, std::complex<double> *y)
+    {
+        const double *valsX{reinterpret_cast<const double *>(x)};
+        double *valsY{reinterpret_cast<double *>(y)};
+        const __m512d aRe{_mm512_set1_pd(a.real())}, aIm{_mm512_set1_pd(a.imag())};
+        std::size_t i{0};
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m512d vx{_mm512_loadu_pd(valsX + 2 * i)};
+            const __m512d prod{_mm512_fmaddsub_pd(aRe, vx, _mm512_mul_pd(aIm, _mm512_permute_pd(vx, 0x55)))};
+            _mm512_storeu_pd(valsY + 2 * i, _mm512_add_pd(_mm512_loadu_pd(valsY + 2 * i), prod));
+        }
+        for (; i < n; ++i)
+        {
+            y[i] += std::complex<double>{a.real() * x[i].real() - a.imag() * x[i].imag(), a.real() * x[i].imag() + a.imag() * x[i].real()};
+        }
+    }
+
+    // 8 x 16 real tile in 16 zmm accumulators
+    I_TARGET_AVX512 inline void microKernelAvx512(const std::size_t kc, const double *packA, const double *packB, double *matC, const std::size_t ldc,
+                                                   const std::size_t mr, const std::size_t nr, const double alpha)
+    {
+        constexpr std::size_t MR{8}, NR{16};
+        __m512d acc[MR][2];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            acc[i][0] = _mm512_setzero_pd();
+            acc[i][1] = _mm512_setzero_pd();
+        }
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            const __m512d b0{_mm512_loadu_pd(packB)}, b1{_mm512_loadu_pd(packB + 8)};
+            I_UNROLL
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const __m512d a{_mm512_set1_pd(packA[i])};
+                acc[i][0] = _mm512_fmadd_pd(a, b0, acc[i][0]);
+                acc[i][1] = _mm512_fmadd_pd(a, b1, acc[i][1]);
+            }
+            packA += MR;
+            packB += NR;
+        }
+        alignas(64) double tile[MR * NR];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            _mm512_store_pd(tile + i * NR, acc[i][0]);
+            _mm512_store_pd(tile + i * NR + 8, acc[i][1]);
+        }
+        addTile(tile, NR, matC, ldc, mr, nr, alpha);
+    }
+
+    // 4 x 8 complex tile, same scheme as the AVX2 kernel; fmaddsub(1, accRe, swap(accIm)) replaces addsub
+    I_TARGET_AVX512 inline void microKernelComplexAvx512(const std::size_t kc, const std::complex<double> *packA, const std::complex<double> *packB, std::complex<double> *matC, const std::size_t ldc,
+                                                          const std::size_t mr, const std::size_t nr, const std::complex<double> alpha)
+    {
+        constexpr std::size_t MR{4}, NR{8};
+        const double *valsA{reinterpret_cast<const double *>(packA)}, *valsB{reinterpret_cast<const double *>(packB)};
+        __m512d accRe[MR][2], accIm[MR][2];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            accRe[i][0] = accRe[i][1] = accIm[i][0] = accIm[i][1] = _mm512_setzero_pd();
+        }
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            const __m512d b0{_mm512_loadu_pd(valsB)}, b1{_mm512_loadu_pd(valsB + 8)};
+            I_UNROLL
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const __m512d aRe{_mm512_set1_pd(valsA[2 * i])}, aIm{_mm512_set1_pd(valsA[2 * i + 1])};
+                accRe[i][0] = _mm512_fmadd_pd(aRe, b0, accRe[i][0]);
+                accRe[i][1] = _mm512_fmadd_pd(aRe, b1, accRe[i][1]);
+                accIm[i][0] = _mm512_fmadd_pd(aIm, b0, accIm[i][0]);
+                accIm[i][1] = _mm512_fmadd_pd(aIm, b1, accIm[i][1]);
+            }
+            valsA += 2 * MR;
+            valsB += 2 * NR;
+        }
+        const __m512d ones{_mm512_set1_pd(1.0)};
+        alignas(64) std::complex<double> tile[MR * NR];
+        double *valsTile{reinterpret_cast<double *>(tile)};
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            _mm512_store_pd(valsTile + 2 * i * NR, _mm512_fmaddsub_pd(ones, accRe[i][0], _mm512_permute_pd(accIm[i][0], 0x55)));
+            _mm512_store_pd(valsTile + 2 * i * NR + 8, _mm512_fmaddsub_pd(ones, accRe[i][1], _mm512_permute_pd(accIm[i][1], 0x55)));
+        }
+        addTile(tile, NR, matC, ldc, mr, nr, alpha);
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+} // namespace i_kernel
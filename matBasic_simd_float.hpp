@@ -0,0 +1,487 @@
+#pragma once
+/*
+Mini Matrix Tools - Runtime-Dispatched SIMD Kernels (float & std::complex<float>)
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+The single precision counterparts of the double kernels in matBasic_simd.hpp, same schemes & same dispatch:
+a register holds twice as many floats, so the GEMM tiles are twice as wide (AVX2 6 x 16 real / 3 x 8 complex,
+AVX-512 8 x 32 real / 4 x 16 complex) and a float matrix moves half the bytes of a double one.
+The sums are accumulated in float as well; the order differs from the scalar code, so results may differ in the last bits.
+
+Main Function List:
+[1] i_kernel::dot / dotc / axpy:    float & std::complex<float> overloads of the matBasic_simd.hpp kernels
+[2] i_kernel::gemmMicroKernel:      Register micro-kernels for float & std::complex<float>
+
+Reference:
+[*1] Intel Intrinsics Guide, https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html
+*/
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include "matBasic_simd.hpp"
+
+namespace i_kernel
+{
+#if I_SIMD_X86
+    // ******************** AVX2 + FMA kernels (float & std::complex<float>) [*1] ********************
+    I_TARGET_AVX2 inline float horizontalSum(const __m256 value)
+    {
+        __m128 quad{_mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1))};
+        quad = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+        return _mm_cvtss_f32(_mm_add_ss(quad, _mm_movehdup_ps(quad)));
+    }
+
+    I_TARGET_AVX2 inline float dotAvx2(const std::size_t n, const float *x, const float *y)
+    {
+        __m256 acc0{_mm256_setzero_ps()}, acc1{_mm256_setzero_ps()};
+        std::size_t i{0};
+        for (; i + 16 <= n; i += 16)
+        {
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), acc1);
+        }
+        float sum{horizontalSum(_mm256_add_ps(acc0, acc1))};
+        for (; i < n; ++i)
+        {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+
+    I_TARGET_AVX2 inline void axpyAvx2(const std::size_t n, const float a, const float *x, float *y)
+    {
+        const __m256 valA{_mm256_set1_ps(a)};
+        std::size_t i{0};
+        for (; i + 8 <= n; i += 8)
+        {
+            _mm256_storeu_ps(y + i, _mm256_fmadd_ps(valA, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+        }
+        for (; i < n; ++i)
+        {
+            y[i] += a * x[i];
+        }
+    }
+
+    // 6 x 16 real tile in 12 ymm accumulators, the double kernel with 8 lanes per register
+    I_TARGET_AVX2 inline void microKernelAvx2(const std::size_t kc, const float *packA, const float *packB, float *matC, const std::size_t ldc,
+                                               const std::size_t mr, const std::size_t nr, const float alpha)
+    {
+        constexpr std::size_t MR{6}, NR{16};
+        __m256 acc[MR][2];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            acc[i][0] = _mm256_setzero_ps();
+            acc[i][1] = _mm256_setzero_ps();
+        }
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            const __m256 b0{_mm256_loadu_ps(packB)}, b1{_mm256_loadu_ps(packB + 8)};
+            I_UNROLL
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const __m256 a{_mm256_broadcast_ss(packA + i)};
+                acc[i][0] = _mm256_fmadd_ps(a, b0, acc[i][0]);
+                acc[i][1] = _mm256_fmadd_ps(a, b1, acc[i][1]);
+            }
+            packA += MR;
+            packB += NR;
+        }
+        alignas(32) float tile[MR * NR];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            _mm256_store_ps(tile + i * NR, acc[i][0]);
+            _mm256_store_ps(tile + i * NR + 8, acc[i][1]);
+        }
+        addTile(tile, NR, matC, ldc, mr, nr, alpha);
+    }
+
+    // Same schemes as the double complex kernels, 4 complex<float> per ymm; permute 0xb1 swaps real & imaginary parts
+    I_TARGET_AVX2 inline std::complex<float> dotComplexAvx2(const std::size_t n, const std::complex<float> *x, const std::complex<float> *y, const bool conjX)
+    {
+        const float *valsX{reinterpret_cast<const float *>(x)}, *valsY{reinterpret_cast<const float *>(y)};
+        __m256 accP{_mm256_setzero_ps()}, accQ{_mm256_setzero_ps()};
+        std::size_t i{0};
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m256 vx{_mm256_loadu_ps(valsX + 2 * i)}, vy{_mm256_loadu_ps(valsY + 2 * i)};
+            accP = _mm256_fmadd_ps(vx, vy, accP);
+            accQ = _mm256_fmadd_ps(vx, _mm256_permute_ps(vy, 0xb1), accQ);
+        }
+        alignas(32) float lanesP[8], lanesQ[8];
+        _mm256_store_ps(lanesP, accP);
+        _mm256_store_ps(lanesQ, accQ);
+        float pEven{0.0f}, pOdd{0.0f}, qEven{0.0f}, qOdd{0.0f};
+        for (std::size_t lane{0}; lane < 8; lane += 2)
+        {
+            pEven += lanesP[lane];
+            pOdd += lanesP[lane + 1];
+            qEven += lanesQ[lane];
+            qOdd += lanesQ[lane + 1];
+        }
+        float sumRe{conjX ? pEven + pOdd : pEven - pOdd}, sumIm{conjX ? qEven - qOdd : qEven + qOdd};
+        for (; i < n; ++i)
+        {
+            const float xIm{conjX ? -x[i].imag() : x[i].imag()};
+            sumRe += x[i].real() * y[i].real() - xIm * y[i].imag();
+            sumIm += x[i].real() * y[i].imag() + xIm * y[i].real();
+        }
+        return {sumRe, sumIm};
+    }
+
+    I_TARGET_AVX2 inline void axpyComplexAvx2(const std::size_t n, const std::complex<float> a, const std::complex<float> *x, std::complex<float> *y)
+    {
+        const float *valsX{reinterpret_cast<const float *>(x)};
+        float *valsY{reinterpret_cast<float *>(y)};
+        const __m256 aRe{_mm256_set1_ps(a.real())}, aIm{_mm256_set1_ps(a.imag())};
+        std::size_t i{0};
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m256 vx{_mm256_loadu_ps(valsX + 2 * i)};
+            const __m256 prod{_mm256_fmaddsub_ps(aRe, vx, _mm256_mul_ps(aIm, _mm256_permute_ps(vx, 0xb1)))};
+            _mm256_storeu_ps(valsY + 2 * i, _mm256_add_ps(_mm256_loadu_ps(valsY + 2 * i), prod));
+        }
+        for (; i < n; ++i)
+        {
+            y[i] += std::complex<float>{a.real() * x[i].real() - a.imag() * x[i].imag(), a.real() * x[i].imag() + a.imag() * x[i].real()};
+        }
+    }
+
+    // 3 x 8 complex tile
+    I_TARGET_AVX2 inline void microKernelComplexAvx2(const std::size_t kc, const std::complex<float> *packA, const std::complex<float> *packB, std::complex<float> *matC, const std::size_t ldc,
+                                                      const std::size_t mr, const std::size_t nr, const std::complex<float> alpha)
+    {
+        constexpr std::size_t MR{3}, NR{8};
+        const float *valsA{reinterpret_cast<const float *>(packA)}, *valsB{reinterpret_cast<const float *>(packB)};
+        __m256 accRe[MR][2], accIm[MR][2];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            accRe[i][0] = accRe[i][1] = accIm[i][0] = accIm[i][1] = _mm256_setzero_ps();
+        }
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            const __m256 b0{_mm256_loadu_ps(valsB)}, b1{_mm256_loadu_ps(valsB + 8)};
+            I_UNROLL
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const __m256 aRe{_mm256_broadcast_ss(valsA + 2 * i)}, aIm{_mm256_broadcast_ss(valsA + 2 * i + 1)};
+                accRe[i][0] = _mm256_fmadd_ps(aRe, b0, accRe[i][0]);
+                accRe[i][1] = _mm256_fmadd_ps(aRe, b1, accRe[i][1]);
+                accIm[i][0] = _mm256_fmadd_ps(aIm, b0, accIm[i][0]);
+                accIm[i][1] = _mm256_fmadd_ps(aIm, b1, accIm[i][1]);
+            }
+            valsA += 2 * MR;
+            valsB += 2 * NR;
+        }
+        alignas(32) std::complex<float> tile[MR * NR];
+        float *valsTile{reinterpret_cast<float *>(tile)};
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            _mm256_store_ps(valsTile + 2 * i * NR, _mm256_addsub_ps(accRe[i][0], _mm256_permute_ps(accIm[i][0], 0xb1)));
+            _mm256_store_ps(valsTile + 2 * i * NR + 8, _mm256_addsub_ps(accRe[i][1], _mm256_permute_ps(accIm[i][1], 0xb1)));
+        }
+        addTile(tile, NR, matC, ldc, mr, nr, alpha);
+    }
+
+    // ******************** AVX-512F kernels (float & std::complex<float>) [*1] ********************
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push // GCC 12 flags the _mm512_undefined_ps() idiom inside its own intrinsic headers
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+    I_TARGET_AVX512 inline float dotAvx512(const std::size_t n, const float *x, const float *y)
+    {
+        __m512 acc0{_mm512_setzero_ps()}, acc1{_mm512_setzero_ps()};
+        std::size_t i{0};
+        for (; i + 32 <= n; i += 32)
+        {
+            acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), acc0);
+            acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), acc1);
+        }
+        if (i < n) // Masked tail
+        {
+            const std::size_t rest{std::min<std::size_t>(n - i, 16)};
+            const __mmask16 mask{static_cast<__mmask16>((1u << rest) - 1u)};
+            acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), acc0);
+            i += rest;
+        }
+        float sum{_mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1))};
+        for (; i < n; ++i)
+        {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+
+    I_TARGET_AVX512 inline void axpyAvx512(const std::size_t n, const float a, const float *x, float *y)
+    {
+        const __m512 valA{_mm512_set1_ps(a)};
+        std::size_t i{0};
+        for (; i + 16 <= n; i += 16)
+        {
+            _mm512_storeu_ps(y + i, _mm512_fmadd_ps(valA, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+        }
+        if (i < n)
+        {
+            const __mmask16 mask{static_cast<__mmask16>((1u << (n - i)) - 1u)};
+            _mm512_mask_storeu_ps(y + i, mask, _mm512_fmadd_ps(valA, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i)));
+        }
+    }
+
+    // 8 x 32 real tile in 16 zmm accumulators
+    I_TARGET_AVX512 inline void microKernelAvx512(const std::size_t kc, const float *packA, const float *packB, float *matC, const std::size_t ldc,
+                                                   const std::size_t mr, const std::size_t nr, const float alpha)
+    {
+        constexpr std::size_t MR{8}, NR{32};
+        __m512 acc[MR][2];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            acc[i][0] = _mm512_setzero_ps();
+            acc[i][1] = _mm512_setzero_ps();
+        }
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            const __m512 b0{_mm512_loadu_ps(packB)}, b1{_mm512_loadu_ps(packB + 16)};
+            I_UNROLL
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const __m512 a{_mm512_set1_ps(packA[i])};
+                acc[i][0] = _mm512_fmadd_ps(a, b0, acc[i][0]);
+                acc[i][1] = _mm512_fmadd_ps(a, b1, acc[i][1]);
+            }
+            packA += MR;
+            packB += NR;
+        }
+        alignas(64) float tile[MR * NR];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            _mm512_store_ps(tile + i * NR, acc[i][0]);
+            _mm512_store_ps(tile + i * NR + 16, acc[i][1]);
+        }
+        addTile(tile, NR, matC, ldc, mr, nr, alpha);
+    }
+
+    I_TARGET_AVX512 inline std::complex<float> dotComplexAvx512(const std::size_t n, const std::complex<float> *x, const std::complex<float> *y, const bool conjX)
+    {
+        const float *valsX{reinterpret_cast<const float *>(x)}, *valsY{reinterpret_cast<const float *>(y)};
+        __m512 accP{_mm512_setzero_ps()}, accQ{_mm512_setzero_ps()};
+        std::size_t i{0};
+        for (; i + 8 <= n; i += 8)
+        {
+            const __m512 vx{_mm512_loadu_ps(valsX + 2 * i)}, vy{_mm512_loadu_ps(valsY + 2 * i)};
+            accP = _mm512_fmadd_ps(vx, vy, accP);
+            accQ = _mm512_fmadd_ps(vx, _mm512_permute_ps(vy, 0xb1), accQ);
+        }
+        alignas(64) float lanesP[16], lanesQ[16];
+        _mm512_store_ps(lanesP, accP);
+        _mm512_store_ps(lanesQ, accQ);
+        float pEven{0.0f}, pOdd{0.0f}, qEven{0.0f}, qOdd{0.0f};
+        for (std::size_t lane{0}; lane < 16; lane += 2)
+        {
+            pEven += lanesP[lane];
+            pOdd += lanesP[lane + 1];
+            qEven += lanesQ[lane];
+            qOdd += lanesQ[lane + 1];
+        }
+        float sumRe{conjX ? pEven + pOdd : pEven - pOdd}, sumIm{conjX ? qEven - qOdd : qEven + qOdd};
+        for (; i < n; ++i)
+        {
+            const float xIm{conjX ? -x[i].imag() : x[i].imag()};
+            sumRe += x[i].real() * y[i].real() - xIm * y[i].imag();
+            sumIm += x[i].real() * y[i].imag() + xIm * y[i].real();
+        }
+        return {sumRe, sumIm};
+    }
+
+    I_TARGET_AVX512 inline void axpyComplexAvx512(const std::size_t n, const std::complex<float> a, const std::complex<float> *x, std::complex<float> *y)
+    {
+        const float *valsX{reinterpret_cast<const float *>(x)};
+        float *valsY{reinterpret_cast<float *>(y)};
+        const __m512 aRe{_mm512_set1_ps(a.real())}, aIm{_mm512_set1_ps(a.imag())};
+        std::size_t i{0};
+        for (; i + 8 <= n; i += 8)
+        {
+            const __m512 vx{_mm512_loadu_ps(valsX + 2 * i)};
+            const __m512 prod{_mm512_fmaddsub_ps(aRe, vx, _mm512_mul_ps(aIm, _mm512_permute_ps(vx, 0xb1)))};
+            _mm512_storeu_ps(valsY + 2 * i, _mm512_add_ps(_mm512_loadu_ps(valsY + 2 * i), prod));
+        }
+        for (; i < n; ++i)
+        {
+            y[i] += std::complex<float>{a.real() * x[i].real() - a.imag() * x[i].imag(), a.real() * x[i].imag() + a.imag() * x[i].real()};
+        }
+    }
+
+    // 4 x 16 complex tile
+    I_TARGET_AVX512 inline void microKernelComplexAvx512(const std::size_t kc, const std::complex<float> *packA, const std::complex<float> *packB, std::complex<float> *matC, const std::size_t ldc,
+                                                          const std::size_t mr, const std::size_t nr, const std::complex<float> alpha)
+    {
+        constexpr std::size_t MR{4}, NR{16};
+        const float *valsA{reinterpret_cast<const float *>(packA)}, *valsB{reinterpret_cast<const float *>(packB)};
+        __m512 accRe[MR][2], accIm[MR][2];
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            accRe[i][0] = accRe[i][1] = accIm[i][0] = accIm[i][1] = _mm512_setzero_ps();
+        }
+        for (std::size_t p{0}; p < kc; ++p)
+        {
+            const __m512 b0{_mm512_loadu_ps(valsB)}, b1{_mm512_loadu_ps(valsB + 16)};
+            I_UNROLL
+            for (std::size_t i{0}; i < MR; ++i)
+            {
+                const __m512 aRe{_mm512_set1_ps(valsA[2 * i])}, aIm{_mm512_set1_ps(valsA[2 * i + 1])};
+                accRe[i][0] = _mm512_fmadd_ps(aRe, b0, accRe[i][0]);
+                accRe[i][1] = _mm512_fmadd_ps(aRe, b1, accRe[i][1]);
+                accIm[i][0] = _mm512_fmadd_ps(aIm, b0, accIm[i][0]);
+                accIm[i][1] = _mm512_fmadd_ps(aIm, b1, accIm[i][1]);
+            }
+            valsA += 2 * MR;
+            valsB += 2 * NR;
+        }
+        const __m512 ones{_mm512_set1_ps(1.0f)};
+        alignas(64) std::complex<float> tile[MR * NR];
+        float *valsTile{reinterpret_cast<float *>(tile)};
+        I_UNROLL
+        for (std::size_t i{0}; i < MR; ++i)
+        {
+            _mm512_store_ps(valsTile + 2 * i * NR, _mm512_fmaddsub_ps(ones, accRe[i][0], _mm512_permute_ps(accIm[i][0], 0xb1)));
+            _mm512_store_ps(valsTile + 2 * i * NR + 16, _mm512_fmaddsub_ps(ones, accRe[i][1], _mm512_permute_ps(accIm[i][1], 0xb1)));
+        }
+        addTile(tile, NR, matC, ldc, mr, nr, alpha);
+    }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+    // ******************** Dispatch (float & std::complex<float>) ********************
+    inline float dot(const std::size_t n, const float *x, const float *y)
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return dotAvx512(n, x, y);
+        case i_simd_level::avx2:
+            return dotAvx2(n, x, y);
+        default:
+            break;
+        }
+#endif
+        return dot<float>(n, x, y);
+    }
+
+    inline float dotc(const std::size_t n, const float *x, const float *y)
+    {
+        return dot(n, x, y);
+    }
+
+    inline void axpy(const std::size_t n, const float a, const float *x, float *y)
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return axpyAvx512(n, a, x, y);
+        case i_simd_level::avx2:
+            return axpyAvx2(n, a, x, y);
+        default:
+            break;
+        }
+#endif
+        axpy<float>(n, a, x, y);
+    }
+
+    inline std::complex<float> dotComplex(const std::size_t n, const std::complex<float> *x, const std::complex<float> *y, const bool conjX)
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return dotComplexAvx512(n, x, y, conjX);
+        case i_simd_level::avx2:
+            return dotComplexAvx2(n, x, y, conjX);
+        default:
+            break;
+        }
+#endif
+        float sumRe{0.0f}, sumIm{0.0f};
+        for (std::size_t i{0}; i < n; ++i)
+        {
+            const float xIm{conjX ? -x[i].imag() : x[i].imag()};
+            sumRe += x[i].real() * y[i].real() - xIm * y[i].imag();
+            sumIm += x[i].real() * y[i].imag() + xIm * y[i].real();
+        }
+        return {sumRe, sumIm};
+    }
+
+    inline std::complex<float> dot(const std::size_t n, const std::complex<float> *x, const std::complex<float> *y)
+    {
+        return dotComplex(n, x, y, false);
+    }
+
+    inline std::complex<float> dotc(const std::size_t n, const std::complex<float> *x, const std::complex<float> *y)
+    {
+        return dotComplex(n, x, y, true);
+    }
+
+    inline void axpy(const std::size_t n, const std::complex<float> a, const std::complex<float> *x, std::complex<float> *y)
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return axpyComplexAvx512(n, a, x, y);
+        case i_simd_level::avx2:
+            return axpyComplexAvx2(n, a, x, y);
+        default:
+            break;
+        }
+#endif
+        for (std::size_t i{0}; i < n; ++i)
+        {
+            y[i] += std::complex<float>{a.real() * x[i].real() - a.imag() * x[i].imag(), a.real() * x[i].imag() + a.imag() * x[i].real()};
+        }
+    }
+
+    template <>
+    inline i_gemm_micro<float> gemmMicroKernel<float>()
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return {8, 32, &microKernelAvx512};
+        case i_simd_level::avx2:
+            return {6, 16, &microKernelAvx2};
+        default:
+            break;
+        }
+#endif
+        return i_scalar_micro<float>::get();
+    }
+
+    template <>
+    inline i_gemm_micro<std::complex<float>> gemmMicroKernel<std::complex<float>>()
+    {
+#if I_SIMD_X86
+        switch (simdLevel())
+        {
+        case i_simd_level::avx512:
+            return {4, 16, &microKernelComplexAvx512};
+        case i_simd_level::avx2:
+            return {3, 8, &microKernelComplexAvx2};
+        default:
+            break;
+        }
+#endif
+        return i_scalar_micro<std::complex<float>>::get();
+    }
+} // namespace i_kernel
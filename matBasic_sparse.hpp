@@ -0,0 +1,282 @@
+#pragma once
+/*
+Mini Matrix Tools - Compressed Sparse Row (CSR) Matrix
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+Only the nonzeros are stored, row by row: row i holds values()[rowPtr()[i] : rowPtr()[i + 1]] at the columns
+colIndex()[rowPtr()[i] : rowPtr()[i + 1]]. Calibration systems have two nonzeros per row (a -1 & a lambda), so
+memory & work scale with nnz instead of rows * cols. The normal equations are assembled directly from the rows:
+A' * A costs sum(nnz(row)^2) and A' * b costs nnz * cols(b), neither touches a zero.
+
+Main Function List:
+[1] toSparseMatrix: i_dense_matrix<T> -> i_csr_matrix<T> (exact zeros dropped)
+[2] toDenseMatrix:  i_csr_matrix<T> -> i_dense_matrix<T>
+[3] transpose:      Conjugate transpose, still CSR
+[4] matMul:         Sparse * dense, one axpy per nonzero
+[5] gramMatrix:     A' * A (dense, Hermitian), O(nnz) for a bounded number of nonzeros per row
+[6] adjointMul:     A' * B (dense), O(nnz * cols(B))
+[7] sparseGramMatrix: A' * A kept sparse (CSR, both triangles), input of SparseCholeskyFactorization
+[8] leftDiv / pinv2: Sparse overloads, see matBasic_core.hpp
+*/
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_gemm.hpp"
+
+template <typename T>
+class i_csr_matrix
+{
+public:
+    i_csr_matrix() = default;
+
+    // All-zero nrows x ncols matrix, nonzeros can be added with appendRow after i_csr_matrix(0, ncols)
+    i_csr_matrix(const std::size_t nrows, const std::size_t ncols)
+        : m_rows{nrows}, m_cols{ncols}, m_rowPtr(nrows + 1, 0)
+    {
+    }
+
+    // From the three CSR arrays; the column indices of a row need not be sorted
+    i_csr_matrix(const std::size_t nrows, const std::size_t ncols, std::vector<std::size_t> rowPtr,
+                 std::vector<std::size_t> colIndex, std::vector<T> values)
+    {
+        bool valid{rowPtr.size() == nrows + 1 && rowPtr.front() == 0 && rowPtr.back() == colIndex.size() && colIndex.size() == values.size()};
+        for (std::size_t i{0}; valid && i < nrows; ++i)
+        {
+            valid = rowPtr[i] <= rowPtr[i + 1];
+        }
+        for (std::size_t p{0}; valid && p < colIndex.size(); ++p)
+        {
+            valid = colIndex[p] < ncols;
+        }
+        if (!valid)
+        {
+            std::cout << "Error when using i_csr_matrix: invalid row pointers or column indices.\n";
+            return;
+        }
+        m_rows = nrows;
+        m_cols = ncols;
+        m_rowPtr = std::move(rowPtr);
+        m_colIndex = std::move(colIndex);
+        m_values = std::move(values);
+    }
+
+    std::size_t rows() const { return m_rows; }
+    std::size_t cols() const { return m_cols; }
+    std::size_t nnz() const { return m_values.size(); }
+    bool empty() const { return m_rows == 0 || m_cols == 0; }
+
+    const std::vector<std::size_t> &rowPtr() const { return m_rowPtr; }
+    const std::vector<std::size_t> &colIndex() const { return m_colIndex; }
+    const std::vector<T> &values() const { return m_values; }
+
+    // Add a row at the bottom, entries as (column, value)
+    void appendRow(const std::vector<std::pair<std::size_t, T>> &entries)
+    {
+        for (const auto &entry : entries)
+        {
+            if (entry.first >= m_cols)
+            {
+                std::cout << "Error when using i_csr_matrix::appendRow: column index out of range.\n";
+                return;
+            }
+        }
+        for (const auto &entry : entries)
+        {
+            m_colIndex.push_back(entry.first);
+            m_values.push_back(entry.second);
+        }
+        m_rowPtr.push_back(m_values.size());
+        ++m_rows;
+    }
+
+private:
+    std::size_t m_rows{0};
+    std::size_t m_cols{0};
+    std::vector<std::size_t> m_rowPtr{0};
+    std::vector<std::size_t> m_colIndex;
+    std::vector<T> m_values;
+};
+
+template <typename T>
+i_csr_matrix<T> toSparseMatrix(const i_dense_matrix<T> &matG)
+{
+    const std::size_t nrows{matG.rows()}, ncols{matG.cols()};
+    std::vector<std::size_t> rowPtr(nrows + 1, 0), colIndex;
+    std::vector<T> values;
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        const T *rowG{matG.row(i)};
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            if (rowG[j] != T{})
+            {
+                colIndex.push_back(j);
+                values.push_back(rowG[j]);
+            }
+        }
+        rowPtr[i + 1] = values.size();
+    }
+    return i_csr_matrix<T>(nrows, ncols, std::move(rowPtr), std::move(colIndex), std::move(values));
+}
+
+template <typename T>
+i_dense_matrix<T> toDenseMatrix(const i_csr_matrix<T> &matG)
+{
+    i_dense_matrix<T> matD(matG.rows(), matG.cols());
+    for (std::size_t i{0}; i < matG.rows(); ++i)
+    {
+        for (std::size_t p{matG.rowPtr()[i]}; p < matG.rowPtr()[i + 1]; ++p)
+        {
+            matD(i, matG.colIndex()[p]) += matG.values()[p]; // Duplicate entries add up
+        }
+    }
+    return matD;
+}
+
+// Conjugate transpose (plain transpose for a real matrix), counting sort by column
+template <typename T>
+i_csr_matrix<T> transpose(const i_csr_matrix<T> &matG)
+{
+    const std::size_t nrows{matG.rows()}, ncols{matG.cols()}, nnz{matG.nnz()};
+    std::vector<std::size_t> rowPtr(ncols + 1, 0), colIndex(nnz);
+    std::vector<T> values(nnz);
+    for (std::size_t p{0}; p < nnz; ++p)
+    {
+        ++rowPtr[matG.colIndex()[p] + 1];
+    }
+    for (std::size_t j{0}; j < ncols; ++j)
+    {
+        rowPtr[j + 1] += rowPtr[j];
+    }
+    std::vector<std::size_t> next(rowPtr.begin(), rowPtr.end() - 1);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        for (std::size_t p{matG.rowPtr()[i]}; p < matG.rowPtr()[i + 1]; ++p)
+        {
+            const std::size_t q{next[matG.colIndex()[p]]++};
+            colIndex[q] = i;
+            values[q] = conjScalar(matG.values()[p]);
+        }
+    }
+    return i_csr_matrix<T>(ncols, nrows, std::move(rowPtr), std::move(colIndex), std::move(values));
+}
+
+// Sparse * dense: row i of the result = sum of A(i, j) * B(j, :) over the nonzeros of row i
+template <typename T>
+i_dense_matrix<T> matMul(const i_csr_matrix<T> &matA, const i_dense_matrix<T> &matB)
+{
+    i_dense_matrix<T> resMat;
+    if (matA.cols() != matB.rows())
+    {
+        std::cout << "Error when using matMul: dimension not match.\n";
+        return resMat;
+    }
+    const std::size_t ncolsB{matB.cols()};
+    resMat = i_dense_matrix<T>(matA.rows(), ncolsB);
+    for (std::size_t i{0}; i < matA.rows(); ++i)
+    {
+        for (std::size_t p{matA.rowPtr()[i]}; p < matA.rowPtr()[i + 1]; ++p)
+        {
+            i_kernel::axpy(ncolsB, matA.values()[p], matB.row(matA.colIndex()[p]), resMat.row(i));
+        }
+    }
+    return resMat;
+}
+
+// A' * A straight from the rows: every row r adds conj(A(r, i)) * A(r, j) to the lower triangle, then it is mirrored
+template <typename T>
+i_dense_matrix<T> gramMatrix(const i_csr_matrix<T> &matA)
+{
+    const std::size_t ncols{matA.cols()};
+    i_dense_matrix<T> matN(ncols, ncols);
+    for (std::size_t r{0}; r < matA.rows(); ++r)
+    {
+        const std::size_t pb{matA.rowPtr()[r]}, pe{matA.rowPtr()[r + 1]};
+        for (std::size_t p{pb}; p < pe; ++p)
+        {
+            const std::size_t i{matA.colIndex()[p]};
+            const T conjValue{conjScalar(matA.values()[p])};
+            for (std::size_t q{pb}; q < pe; ++q)
+            {
+                const std::size_t j{matA.colIndex()[q]};
+                if (j <= i)
+                {
+                    matN(i, j) += conjValue * matA.values()[q];
+                }
+            }
+        }
+    }
+    for (std::size_t i{0}; i < ncols; ++i)
+    {
+        for (std::size_t j{0}; j < i; ++j)
+        {
+            matN(j, i) = conjScalar(matN(i, j));
+        }
+    }
+    return matN;
+}
+
+// A' * A as CSR (row-by-row Gustavson product of A' & A): row j collects conj(A(r, j)) * A(r, :) over the nonzeros of column j.
+// Both triangles are stored, columns sorted; the pattern is that of the baseline graph when A is a calibration matrix
+template <typename T>
+i_csr_matrix<T> sparseGramMatrix(const i_csr_matrix<T> &matA)
+{
+    const std::size_t ncols{matA.cols()};
+    const i_csr_matrix<T> matAt = transpose(matA);
+    std::vector<std::size_t> rowPtr(ncols + 1, 0), colIndex, pattern, marker(ncols, ncols);
+    std::vector<T> values, accum(ncols);
+    for (std::size_t j{0}; j < ncols; ++j)
+    {
+        pattern.clear();
+        for (std::size_t p{matAt.rowPtr()[j]}; p < matAt.rowPtr()[j + 1]; ++p)
+        {
+            const std::size_t r{matAt.colIndex()[p]};
+            const T conjValue{matAt.values()[p]};
+            for (std::size_t q{matA.rowPtr()[r]}; q < matA.rowPtr()[r + 1]; ++q)
+            {
+                const std::size_t c{matA.colIndex()[q]};
+                if (marker[c] != j)
+                {
+                    marker[c] = j;
+                    accum[c] = T{};
+                    pattern.push_back(c);
+                }
+                accum[c] += conjValue * matA.values()[q];
+            }
+        }
+        std::sort(pattern.begin(), pattern.end());
+        for (const std::size_t c : pattern)
+        {
+            colIndex.push_back(c);
+            values.push_back(accum[c]);
+        }
+        rowPtr[j + 1] = values.size();
+    }
+    return i_csr_matrix<T>(ncols, ncols, std::move(rowPtr), std::move(colIndex), std::move(values));
+}
+
+// A' * B: row j of the result = sum of conj(A(r, j)) * B(r, :) over the nonzeros of column j
+template <typename T>
+i_dense_matrix<T> adjointMul(const i_csr_matrix<T> &matA, const i_dense_matrix<T> &matB)
+{
+    i_dense_matrix<T> resMat;
+    if (matA.rows() != matB.rows())
+    {
+        std::cout << "Error when using adjointMul: dimension not match.\n";
+        return resMat;
+    }
+    const std::size_t ncolsB{matB.cols()};
+    resMat = i_dense_matrix<T>(matA.cols(), ncolsB);
+    for (std::size_t r{0}; r < matA.rows(); ++r)
+    {
+        for (std::size_t p{matA.rowPtr()[r]}; p < matA.rowPtr()[r + 1]; ++p)
+        {
+            i_kernel::axpy(ncolsB, conjScalar(matA.values()[p]), matB.row(r), resMat.row(matA.colIndex()[p]));
+        }
+    }
+    return resMat;
+}
@@ -0,0 +1,384 @@
+#pragma once
+/*
+Mini Matrix Tools - Sparse Cholesky (LDL') Factorization
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+P * A * P' = L * D * L' for a sparse Hermitian (real: symmetric) positive definite A in CSR form, L unit lower
+triangular stored by columns, D real diagonal. No square roots, so the real & complex cases share one code path.
+The work is split in two phases:
+    analyze:   Approximate minimum degree ordering P [*1], elimination tree & nonzero count of every column of L [*2]
+    factorize: Numeric values only, up-looking row by row along the elimination tree [*2]
+analyze depends on the sparsity pattern alone: when only the values change (next calibration snapshot, same
+baselines) call factorize again and skip the analysis. The dense counterpart is CholeskyFactorization.
+
+Main Function List:
+[1] SparseCholeskyFactorization::analyze:          Symbolic phase, fill-reducing (AMD) or natural ordering
+[2] SparseCholeskyFactorization::factorize:        Numeric phase, false if a pivot fell below tolerance * max(diag(A))
+[3] SparseCholeskyFactorization::solve:            X = A \ B for any number of right-hand sides
+[4] i_sparse::amdOrder:                            The ordering on its own
+
+Reference:
+[*1] Patrick R. Amestoy, Timothy A. Davis, Iain S. Duff, An Approximate Minimum Degree Ordering Algorithm, SIAM J. Matrix Anal. Appl. 17(4), 1996
+[*2] Timothy A. Davis, Algorithm 849: A Concise Sparse Cholesky Factorization Package, ACM TOMS 31(4), 2005
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_gemm.hpp"
+#include "matBasic_sparse.hpp"
+
+namespace i_sparse
+{
+    // Approximate minimum degree on the quotient graph: every eliminated pivot p becomes an element whose variable
+    // list Lp is the union of its live neighbours & the elements it absorbs. The degree of a variable i in Lp is
+    // bounded by |Ai| + |Lp \ i| + sum of |Le \ Lp| over its other elements (the AMD approximate degree) instead of
+    // the exact degree, which would need the fill to be stored. Supervariables & dense-row detection are left out.
+    // Returns order: order[k] is the original index of the k-th pivot.
+    template <typename T>
+    std::vector<std::size_t> amdOrder(const i_csr_matrix<T> &matA)
+    {
+        const std::size_t n{matA.rows()}, none{static_cast<std::size_t>(-1)};
+        std::vector<std::vector<std::size_t>> varAdj(n), elemAdj(n), elemVars(n);
+        for (std::size_t i{0}; i < n; ++i)
+        {
+            for (std::size_t p{matA.rowPtr()[i]}; p < matA.rowPtr()[i + 1]; ++p)
+            {
+                const std::size_t j{matA.colIndex()[p]};
+                if (j != i)
+                {
+                    varAdj[i].push_back(j); // Pattern assumed symmetric, but add both directions in case only one triangle is stored
+                    varAdj[j].push_back(i);
+                }
+            }
+        }
+        std::vector<std::size_t> degree(n);
+        std::set<std::pair<std::size_t, std::size_t>> queue;
+        for (std::size_t i{0}; i < n; ++i)
+        {
+            std::sort(varAdj[i].begin(), varAdj[i].end());
+            varAdj[i].erase(std::unique(varAdj[i].begin(), varAdj[i].end()), varAdj[i].end());
+            degree[i] = varAdj[i].size();
+            queue.insert({degree[i], i});
+        }
+
+        std::vector<std::size_t> order, mark(n, none), wMark(n, none), w(n);
+        std::vector<char> eliminated(n, 0), absorbed(n, 0);
+        order.reserve(n);
+        for (std::size_t k{0}; k < n; ++k)
+        {
+            const std::size_t piv{queue.begin()->second};
+            queue.erase(queue.begin());
+            eliminated[piv] = 1;
+            order.push_back(piv);
+
+            // ******************** Step 1: new element Lp = Ap + absorbed elements ********************
+            std::vector<std::size_t> &listP{elemVars[piv]};
+            mark[piv] = k;
+            for (const std::size_t i : varAdj[piv])
+            {
+                if (!eliminated[i] && mark[i] != k)
+                {
+                    mark[i] = k;
+                    listP.push_back(i);
+                }
+            }
+            for (const std::size_t e : elemAdj[piv])
+            {
+                if (absorbed[e])
+                {
+                    continue;
+                }
+                for (const std::size_t i : elemVars[e])
+                {
+                    if (!eliminated[i] && mark[i] != k)
+                    {
+                        mark[i] = k;
+                        listP.push_back(i);
+                    }
+                }
+                absorbed[e] = 1;
+                std::vector<std::size_t>().swap(elemVars[e]);
+            }
+            std::vector<std::size_t>().swap(varAdj[piv]);
+            std::vector<std::size_t>().swap(elemAdj[piv]);
+
+            // ******************** Step 2: |Le \ Lp| for every element touching Lp ********************
+            for (const std::size_t i : listP)
+            {
+                for (const std::size_t e : elemAdj[i])
+                {
+                    if (absorbed[e])
+                    {
+                        continue;
+                    }
+                    if (wMark[e] != k)
+                    {
+                        wMark[e] = k;
+                        w[e] = elemVars[e].size();
+                    }
+                    --w[e];
+                }
+            }
+
+            // ******************** Step 3: prune the lists of Lp & update the approximate degrees ********************
+            const std::size_t sizeP{listP.size()}, remaining{n - k - 1};
+            for (const std::size_t i : listP)
+            {
+                std::vector<std::size_t> &elems{elemAdj[i]};
+                std::size_t external{0};
+                elems.erase(std::remove_if(elems.begin(), elems.end(), [&absorbed](const std::size_t e) { return absorbed[e] != 0; }), elems.end());
+                for (const std::size_t e : elems)
+                {
+                    external += wMark[e] == k ? w[e] : elemVars[e].size();
+                }
+                elems.push_back(piv);
+                std::vector<std::size_t> &vars{varAdj[i]};
+                vars.erase(std::remove_if(vars.begin(), vars.end(), [&](const std::size_t j) { return eliminated[j] || mark[j] == k; }), vars.end());
+
+                queue.erase({degree[i], i});
+                degree[i] = std::min({remaining - 1, degree[i] + sizeP - 1, vars.size() + sizeP - 1 + external});
+                queue.insert({degree[i], i});
+            }
+        }
+        return order;
+    }
+} // namespace i_sparse
+
+template <typename T>
+class SparseCholeskyFactorization
+{
+public:
+    using real_t = typename i_real_type<T>::type;
+
+    SparseCholeskyFactorization() = default;
+
+    // analyze + factorize; matA holds both triangles (e.g. sparseGramMatrix), only the lower one is read after ordering
+    explicit SparseCholeskyFactorization(const i_csr_matrix<T> &matA, const real_t tolerance = defaultTolerance<T>(), const bool fillReducing = true)
+    {
+        if (analyze(matA, fillReducing))
+        {
+            factorize(matA, tolerance);
+        }
+    }
+
+    bool analyzed() const { return !m_lp.empty(); }
+    bool positiveDefinite() const { return m_positiveDefinite; }
+    std::size_t size() const { return m_order.size(); }
+    std::size_t nnzL() const { return analyzed() ? m_lp.back() : 0; } // Strictly lower nonzeros, fill included
+    const std::vector<std::size_t> &permutation() const { return m_order; }
+    const std::vector<real_t> &diagonal() const { return m_d; }
+
+    // Symbolic phase: ordering, elimination tree & column pointers of L. Needs the pattern of matA only
+    bool analyze(const i_csr_matrix<T> &matA, const bool fillReducing = true)
+    {
+        const std::size_t nSize{matA.rows()};
+        m_lp.clear();
+        m_positiveDefinite = false;
+        if (matA.rows() != matA.cols())
+        {
+            std::cout << "Error when using SparseCholeskyFactorization: matrix is not square.\n";
+            return false;
+        }
+        m_order.resize(nSize);
+        if (fillReducing)
+        {
+            m_order = i_sparse::amdOrder(matA);
+        }
+        else
+        {
+            for (std::size_t i{0}; i < nSize; ++i)
+            {
+                m_order[i] = i;
+            }
+        }
+        m_inverseOrder.assign(nSize, 0);
+        for (std::size_t k{0}; k < nSize; ++k)
+        {
+            m_inverseOrder[m_order[k]] = k;
+        }
+
+        // Row k of L is the set of nodes reached from the entries of row k of P * A * P' walking up the elimination tree
+        m_parent.assign(nSize, npos);
+        std::vector<std::size_t> flag(nSize), count(nSize, 0);
+        for (std::size_t k{0}; k < nSize; ++k)
+        {
+            flag[k] = k;
+            const std::size_t row{m_order[k]};
+            for (std::size_t p{matA.rowPtr()[row]}; p < matA.rowPtr()[row + 1]; ++p)
+            {
+                for (std::size_t i{m_inverseOrder[matA.colIndex()[p]]}; i < k && flag[i] != k; i = m_parent[i])
+                {
+                    if (m_parent[i] == npos)
+                    {
+                        m_parent[i] = k;
+                    }
+                    ++count[i];
+                    flag[i] = k;
+                }
+            }
+        }
+        m_lp.assign(nSize + 1, 0);
+        for (std::size_t k{0}; k < nSize; ++k)
+        {
+            m_lp[k + 1] = m_lp[k] + count[k];
+        }
+        m_li.assign(m_lp.back(), 0);
+        m_lx.assign(m_lp.back(), T{});
+        m_d.assign(nSize, 0);
+        m_rowPtr = matA.rowPtr();
+        m_colIndex = matA.colIndex();
+        return true;
+    }
+
+    // Numeric phase, values of matA on the pattern given to analyze (compared entry by entry, false if it differs)
+    bool factorize(const i_csr_matrix<T> &matA, const real_t tolerance = defaultTolerance<T>())
+    {
+        const std::size_t nSize{size()};
+        m_positiveDefinite = false;
+        if (!analyzed() || matA.rowPtr() != m_rowPtr || matA.colIndex() != m_colIndex)
+        {
+            std::cout << "Error when using SparseCholeskyFactorization::factorize: pattern not match the analyzed one.\n";
+            return false;
+        }
+        real_t maxDiag{0};
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            for (std::size_t p{matA.rowPtr()[i]}; p < matA.rowPtr()[i + 1]; ++p)
+            {
+                if (matA.colIndex()[p] == i)
+                {
+                    maxDiag = std::max(maxDiag, static_cast<real_t>(std::real(matA.values()[p])));
+                }
+            }
+        }
+
+        // Row k: solve L(0:k, 0:k) * y = A(0:k, k) on the pattern of row k, then L(k, i) = conj(y(i)) / D(i)
+        std::vector<T> y(nSize, T{});
+        std::vector<std::size_t> flag(nSize), pattern(nSize), lnz(nSize, 0);
+        for (std::size_t k{0}; k < nSize; ++k)
+        {
+            std::size_t top{nSize};
+            flag[k] = k;
+            const std::size_t row{m_order[k]};
+            for (std::size_t p{matA.rowPtr()[row]}; p < matA.rowPtr()[row + 1]; ++p)
+            {
+                std::size_t i{m_inverseOrder[matA.colIndex()[p]]};
+                if (i > k)
+                {
+                    continue;
+                }
+                y[i] += conjScalar(matA.values()[p]); // A(i, k) = conj(A(k, i))
+                std::size_t len{0};
+                for (; i < k && flag[i] != k; i = m_parent[i])
+                {
+                    pattern[len++] = i;
+                    flag[i] = k;
+                }
+                while (len > 0)
+                {
+                    pattern[--top] = pattern[--len]; // Topological order, nearest to the root last
+                }
+            }
+            real_t diag{std::real(y[k])};
+            y[k] = T{};
+            for (; top < nSize; ++top)
+            {
+                const std::size_t i{pattern[top]};
+                const T yi{y[i]};
+                y[i] = T{};
+                const std::size_t pe{m_lp[i] + lnz[i]};
+                for (std::size_t p{m_lp[i]}; p < pe; ++p)
+                {
+                    y[m_li[p]] -= m_lx[p] * yi;
+                }
+                const T lki{conjScalar(yi) / m_d[i]};
+                diag -= std::real(lki * yi);
+                if (pe >= m_lp[i + 1])
+                {
+                    std::cout << "Error when using SparseCholeskyFactorization::factorize: fill outside the analyzed pattern.\n";
+                    return false;
+                }
+                m_li[pe] = k;
+                m_lx[pe] = lki;
+                ++lnz[i];
+            }
+            if (!(diag > tolerance * maxDiag))
+            {
+                return false;
+            }
+            m_d[k] = diag;
+        }
+        m_positiveDefinite = true;
+        return true;
+    }
+
+    // X = A \ B = P' * L'^-1 * D^-1 * L^-1 * P * B, one axpy over the right-hand sides per nonzero of L
+    i_dense_matrix<T> solve(const i_dense_matrix<T> &matB) const
+    {
+        const std::size_t nSize{size()}, nrhs{matB.cols()};
+        i_dense_matrix<T> matX;
+        if (matB.rows() != nSize)
+        {
+            std::cout << "Error when using SparseCholeskyFactorization::solve: row size not match.\n";
+            return matX;
+        }
+        if (!m_positiveDefinite)
+        {
+            std::cout << "Warning when using SparseCholeskyFactorization::solve: matrix is not positive definite.\n";
+            return matX;
+        }
+        i_dense_matrix<T> matY(nSize, nrhs);
+        for (std::size_t k{0}; k < nSize; ++k)
+        {
+            std::copy_n(matB.row(m_order[k]), nrhs, matY.row(k));
+        }
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            for (std::size_t p{m_lp[j]}; p < m_lp[j + 1]; ++p)
+            {
+                i_kernel::axpy(nrhs, -m_lx[p], matY.row(j), matY.row(m_li[p]));
+            }
+        }
+        for (std::size_t j{0}; j < nSize; ++j)
+        {
+            T *rowY{matY.row(j)};
+            for (std::size_t c{0}; c < nrhs; ++c)
+            {
+                rowY[c] /= m_d[j];
+            }
+        }
+        for (std::size_t j{nSize}; j > 0; --j)
+        {
+            for (std::size_t p{m_lp[j - 1]}; p < m_lp[j]; ++p)
+            {
+                i_kernel::axpy(nrhs, -conjScalar(m_lx[p]), matY.row(m_li[p]), matY.row(j - 1));
+            }
+        }
+        matX = i_dense_matrix<T>(nSize, nrhs);
+        for (std::size_t k{0}; k < nSize; ++k)
+        {
+            std::copy_n(matY.row(k), nrhs, matX.row(m_order[k]));
+        }
+        return matX;
+    }
+
+private:
+    static constexpr std::size_t npos{static_cast<std::size_t>(-1)};
+
+    std::vector<std::size_t> m_order;        // m_order[k]: original index of pivot k
+    std::vector<std::size_t> m_inverseOrder; // m_inverseOrder[m_order[k]] = k
+    std::vector<std::size_t> m_parent;       // Elimination tree, npos at a root
+    std::vector<std::size_t> m_lp;           // Column pointers of L
+    std::vector<std::size_t> m_li;           // Row indices of L, column by column
+    std::vector<T> m_lx;
+    std::vector<real_t> m_d;
+    std::vector<std::size_t> m_rowPtr;       // Pattern of the analyzed matrix
+    std::vector<std::size_t> m_colIndex;
+    bool m_positiveDefinite{false};
+};
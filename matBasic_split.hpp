@@ -0,0 +1,316 @@
+#pragma once
+/*
+Mini Matrix Tools - Split-Complex (SoA) Matrix
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+A complex matrix stored as two real planes (real parts & imaginary parts), each an aligned i_dense_matrix.
+Complex arithmetic becomes plain real multiply-adds on whole rows, so the real SIMD kernels of
+matBasic_simd.hpp run on it directly, without the shuffles interleaved std::complex data needs.
+
+Main Function List:
+[1] toSplitComplexMatrix: i_complex_dense_matrix / i_complex_matrix -> i_split_complex_matrix
+[2] toInterleavedMatrix:  i_split_complex_matrix -> i_complex_dense_matrix
+[3] transpose:            Conjugate transpose, plane by plane
+[4] matMul:               Four real GEMMs: (Ar + iAi)(Br + iBi) = (ArBr - AiBi) + i(ArBi + AiBr)
+[5] det / inv:            Partial pivoting LU, every row update is a pair of real axpys per plane
+[6] pinv:                 pinv(G) = inv(G' * G) * G' on split planes (WARNING: full-rank matrix only!)
+[7] rank / pinv2 / leftDiv / showMatrix: Converted to interleaved storage (see matBasic_complex.hpp)
+*/
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "matBasic_complex.hpp"
+
+using i_real_plane = i_dense_matrix<i_float_t>;
+
+class i_split_complex_matrix
+{
+public:
+    i_split_complex_matrix() = default;
+    i_split_complex_matrix(const std::size_t nrows, const std::size_t ncols)
+        : m_re(nrows, ncols), m_im(nrows, ncols)
+    {
+    }
+
+    std::size_t rows() const { return m_re.rows(); }
+    std::size_t cols() const { return m_re.cols(); }
+    bool empty() const { return m_re.empty(); }
+
+    i_real_plane &real() { return m_re; }
+    const i_real_plane &real() const { return m_re; }
+    i_real_plane &imag() { return m_im; }
+    const i_real_plane &imag() const { return m_im; }
+
+    i_complex_t get(const std::size_t i, const std::size_t j) const { return {m_re(i, j), m_im(i, j)}; }
+    void set(const std::size_t i, const std::size_t j, const i_complex_t value)
+    {
+        m_re(i, j) = value.real();
+        m_im(i, j) = value.imag();
+    }
+
+    void swapRows(const std::size_t i, const std::size_t k)
+    {
+        std::swap_ranges(m_re.row(i), m_re.row(i) + cols(), m_re.row(k));
+        std::swap_ranges(m_im.row(i), m_im.row(i) + cols(), m_im.row(k));
+    }
+
+private:
+    i_real_plane m_re;
+    i_real_plane m_im;
+};
+
+namespace i_kernel
+{
+    // y += a * x on split rows: four real axpys, each SIMD dispatched
+    inline void axpySplit(const std::size_t n, const i_float_t aRe, const i_float_t aIm,
+                          const i_float_t *xRe, const i_float_t *xIm, i_float_t *yRe, i_float_t *yIm)
+    {
+        axpy(n, aRe, xRe, yRe);
+        axpy(n, -aIm, xIm, yRe);
+        axpy(n, aRe, xIm, yIm);
+        axpy(n, aIm, xRe, yIm);
+    }
+
+    // x *= a on split rows
+    inline void scaleSplit(const std::size_t n, const i_float_t aRe, const i_float_t aIm, i_float_t *xRe, i_float_t *xIm)
+    {
+        for (std::size_t j{0}; j < n; ++j)
+        {
+            const i_float_t valRe{xRe[j]};
+            xRe[j] = aRe * valRe - aIm * xIm[j];
+            xIm[j] = aRe * xIm[j] + aIm * valRe;
+        }
+    }
+
+    // In-place P * G = L * U with partial pivoting (largest |G(i, k)| in column k). Returns false for a singular matrix
+    inline bool luFactorSplit(i_split_complex_matrix &matLU, std::vector<std::size_t> &permuteLU, bool &changeSign)
+    {
+        const std::size_t nSize{matLU.rows()};
+        i_real_plane &planeRe{matLU.real()}, &planeIm{matLU.imag()};
+        permuteLU.resize(nSize);
+        for (std::size_t i{0}; i < nSize; ++i)
+        {
+            permuteLU[i] = i;
+        }
+        changeSign = false;
+
+        for (std::size_t k{0}; k < nSize; ++k)
+        {
+            std::size_t pivot{k};
+            i_float_t maxv{0.0};
+            for (std::size_t i{k}; i < nSize; ++i)
+            {
+                const i_float_t currentv{planeRe(i, k) * planeRe(i, k) + planeIm(i, k) * planeIm(i, k)};
+                if (currentv > maxv)
+                {
+                    maxv = currentv;
+                    pivot = i;
+                }
+            }
+            if (maxv == 0.0)
+            {
+                return false;
+            }
+            if (pivot != k)
+            {
+                matLU.swapRows(pivot, k);
+                std::swap(permuteLU[pivot], permuteLU[k]);
+                changeSign = !changeSign;
+            }
+
+            const i_float_t pivotRe{planeRe(k, k) / maxv}, pivotIm{-planeIm(k, k) / maxv}; // 1 / U(k, k)
+            const std::size_t ntail{nSize - k - 1};
+            for (std::size_t i{k + 1}; i < nSize; ++i)
+            {
+                const i_float_t valRe{planeRe(i, k)}, valIm{planeIm(i, k)};
+                const i_float_t lRe{valRe * pivotRe - valIm * pivotIm}, lIm{valRe * pivotIm + valIm * pivotRe};
+                planeRe(i, k) = lRe;
+                planeIm(i, k) = lIm;
+                axpySplit(ntail, -lRe, -lIm, planeRe.row(k) + k + 1, planeIm.row(k) + k + 1, planeRe.row(i) + k + 1, planeIm.row(i) + k + 1);
+            }
+        }
+        return true;
+    }
+} // namespace i_kernel
+
+// Interleaved -> split planes
+i_split_complex_matrix toSplitComplexMatrix(const i_complex_dense_matrix &matG)
+{
+    i_split_complex_matrix resMat(matG.rows(), matG.cols());
+    for (std::size_t i{0}; i < matG.rows(); ++i)
+    {
+        const i_complex_t *rowG{matG.row(i)};
+        i_float_t *rowRe{resMat.real().row(i)}, *rowIm{resMat.imag().row(i)};
+        for (std::size_t j{0}; j < matG.cols(); ++j)
+        {
+            rowRe[j] = rowG[j].real();
+            rowIm[j] = rowG[j].imag();
+        }
+    }
+    return resMat;
+}
+
+i_split_complex_matrix toSplitComplexMatrix(const i_complex_matrix &matG)
+{
+    return toSplitComplexMatrix(toDenseMatrix(matG));
+}
+
+// Split planes -> interleaved
+i_complex_dense_matrix toInterleavedMatrix(const i_split_complex_matrix &matG)
+{
+    i_complex_dense_matrix resMat(matG.rows(), matG.cols());
+    for (std::size_t i{0}; i < matG.rows(); ++i)
+    {
+        const i_float_t *rowRe{matG.real().row(i)}, *rowIm{matG.imag().row(i)};
+        i_complex_t *rowRes{resMat.row(i)};
+        for (std::size_t j{0}; j < matG.cols(); ++j)
+        {
+            rowRes[j] = i_complex_t{rowRe[j], rowIm[j]};
+        }
+    }
+    return resMat;
+}
+
+void showMatrix(const i_split_complex_matrix &matG, const char *describe = nullptr, bool matlabFormat = false)
+{
+    showMatrix(toInterleavedMatrix(matG), describe, matlabFormat);
+}
+
+// Conjugate transpose, G' = conj(G^T): transpose both planes, negate the imaginary one
+i_split_complex_matrix transpose(const i_split_complex_matrix &matG)
+{
+    const std::size_t nrows{matG.rows()}, ncols{matG.cols()};
+    i_split_complex_matrix matGt(ncols, nrows);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        const i_float_t *rowRe{matG.real().row(i)}, *rowIm{matG.imag().row(i)};
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            matGt.real()(j, i) = rowRe[j];
+            matGt.imag()(j, i) = -rowIm[j];
+        }
+    }
+    return matGt;
+}
+
+// Matrix multiplication with four real GEMMs on the planes
+i_split_complex_matrix matMul(const i_split_complex_matrix &matA, const i_split_complex_matrix &matB)
+{
+    const std::size_t nrowsA{matA.rows()}, ncolsA{matA.cols()}, nrowsB{matB.rows()}, ncolsB{matB.cols()};
+    i_split_complex_matrix resMat;
+    if (ncolsA != nrowsB)
+    {
+        std::cout << "Error when using matMul: dimension not match.\n";
+        return resMat;
+    }
+    resMat = i_split_complex_matrix(nrowsA, ncolsB);
+    const i_real_plane &aRe{matA.real()}, &aIm{matA.imag()}, &bRe{matB.real()}, &bIm{matB.imag()};
+    i_real_plane &cRe{resMat.real()}, &cIm{resMat.imag()};
+    i_kernel::gemm(nrowsA, ncolsB, ncolsA, aRe.data(), aRe.stride(), false, bRe.data(), bRe.stride(), false, cRe.data(), cRe.stride());
+    i_kernel::gemm(nrowsA, ncolsB, ncolsA, aIm.data(), aIm.stride(), false, bIm.data(), bIm.stride(), false, cRe.data(), cRe.stride(), -1.0);
+    i_kernel::gemm(nrowsA, ncolsB, ncolsA, aRe.data(), aRe.stride(), false, bIm.data(), bIm.stride(), false, cIm.data(), cIm.stride());
+    i_kernel::gemm(nrowsA, ncolsB, ncolsA, aIm.data(), aIm.stride(), false, bRe.data(), bRe.stride(), false, cIm.data(), cIm.stride());
+    return resMat;
+}
+
+// LU decomposition-based matrix determinant calculation, det(G) = sign(P) * prod(diag(U))
+i_complex_t det(const i_split_complex_matrix &matG)
+{
+    i_complex_t detG = 0.0;
+    if (matG.rows() != matG.cols())
+    {
+        std::cout << "Error when using det: matrix is not square.\n";
+        return detG;
+    }
+    i_split_complex_matrix matLU{matG};
+    std::vector<std::size_t> permuteLU;
+    bool changeSign{false};
+    if (!i_kernel::luFactorSplit(matLU, permuteLU, changeSign))
+    {
+        return detG; // Singular matrix, det(G) = 0
+    }
+    i_float_t detRe{changeSign ? -1.0 : 1.0}, detIm{0.0};
+    for (std::size_t i{0}; i < matLU.rows(); ++i)
+    {
+        const i_float_t uRe{matLU.real()(i, i)}, uIm{matLU.imag()(i, i)};
+        const i_float_t newRe{detRe * uRe - detIm * uIm};
+        detIm = detRe * uIm + detIm * uRe;
+        detRe = newRe;
+    }
+    return {detRe, detIm};
+}
+
+// LU decomposition-based matrix inversion: solve L * U * X = P by row-wise forward & back substitution
+i_split_complex_matrix inv(const i_split_complex_matrix &matG)
+{
+    const std::size_t nrows{matG.rows()}, ncols{matG.cols()};
+    if (nrows != ncols)
+    {
+        std::cout << "Error when using inv: matrix is not square.\n";
+        return i_split_complex_matrix();
+    }
+    const std::size_t nSize{nrows};
+    i_split_complex_matrix matLU{matG};
+    std::vector<std::size_t> permuteLU;
+    bool changeSign{false};
+    if (!i_kernel::luFactorSplit(matLU, permuteLU, changeSign))
+    {
+        std::cout << "Warning when using inv: matrix is singular.\n";
+        return i_split_complex_matrix();
+    }
+
+    const i_real_plane &luRe{matLU.real()}, &luIm{matLU.imag()};
+    i_split_complex_matrix matX(nSize, nSize);
+    i_real_plane &xRe{matX.real()}, &xIm{matX.imag()};
+    for (std::size_t i{0}; i < nSize; ++i)
+    {
+        xRe(i, permuteLU[i]) = 1.0; // X = P
+    }
+    // Forward substitution, L has a unit diagonal
+    for (std::size_t k{0}; k < nSize; ++k)
+    {
+        for (std::size_t i{k + 1}; i < nSize; ++i)
+        {
+            i_kernel::axpySplit(nSize, -luRe(i, k), -luIm(i, k), xRe.row(k), xIm.row(k), xRe.row(i), xIm.row(i));
+        }
+    }
+    // Back substitution
+    for (std::size_t k{nSize}; k > 0; --k)
+    {
+        const std::size_t kk{k - 1};
+        const i_float_t uRe{luRe(kk, kk)}, uIm{luIm(kk, kk)}, uNorm{uRe * uRe + uIm * uIm};
+        i_kernel::scaleSplit(nSize, uRe / uNorm, -uIm / uNorm, xRe.row(kk), xIm.row(kk));
+        for (std::size_t i{0}; i < kk; ++i)
+        {
+            i_kernel::axpySplit(nSize, -luRe(i, kk), -luIm(i, kk), xRe.row(kk), xIm.row(kk), xRe.row(i), xIm.row(i));
+        }
+    }
+    return matX;
+}
+
+// Classic pseudoinversion pinv(G) = inv(G' * G) * G' (WARNING: full-rank matrix only!)
+i_split_complex_matrix pinv(const i_split_complex_matrix &matG)
+{
+    i_split_complex_matrix matGt = transpose(matG);
+    i_split_complex_matrix matGtG_inv = inv(matMul(matGt, matG));
+    return matMul(matGtG_inv, matGt);
+}
+
+// Calculate matrix rank (Cholesky decomposition), on interleaved storage
+std::size_t rank(const i_split_complex_matrix &matG, const i_float_t tolerance = defaultTolerance<i_float_t>())
+{
+    return rank(toInterleavedMatrix(matG), tolerance);
+}
+
+// Moore-Penrose pseudoinversion (same as pinv(G) in MATLAB), on interleaved storage
+i_split_complex_matrix pinv2(const i_split_complex_matrix &matG, const i_float_t tolerance = defaultTolerance<i_float_t>())
+{
+    return toSplitComplexMatrix(pinv2(toInterleavedMatrix(matG), tolerance));
+}
+
+// Calculate left division x = A \ b, on interleaved storage
+i_split_complex_matrix leftDiv(const i_split_complex_matrix &matA, const i_split_complex_matrix &matb, const i_float_t tolerance = defaultTolerance<i_float_t>())
+{
+    return toSplitComplexMatrix(leftDiv(toInterleavedMatrix(matA), toInterleavedMatrix(matb), tolerance));
+}
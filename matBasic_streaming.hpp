@@ -0,0 +1,397 @@
+#pragma once
+/*
+Mini Matrix Tools - Streaming Least Squares
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+x = argmin ||W * (A * x - b)|| while the rows of A & b keep arriving, without rebuilding the system.
+Only the n x n triangular factor R of the rows seen so far (A' * W^2 * A = R' * R) and z = Q' * W * b are kept [*1]:
+    single rows / short blocks: every new row is rotated into R with n Givens rotations, O(n^2) per row
+    blocks of at least n rows: [R; rows] is refactored by the blocked Householder QR (see matBasic_qr.hpp)
+The current solution is one back substitution R * x = z, O(n^2) per right-hand side.
+An exponential forgetting factor 0 < lambda <= 1 weights the row added k rows ago by sqrt(lambda)^k, so the
+solution follows a slowly drifting system. A regularization delta > 0 starts from R = sqrt(delta) * I, i.e.
+x = argmin ||W * (A * x - b)||^2 + lambda^k * delta * ||x||^2, which is solvable before n independent rows arrived.
+A sliding window over the last w rows instead keeps the Cholesky factor of A' * A (see matBasic_cholesky.hpp):
+a new row is a rank-1 update, the row leaving the window a rank-1 downdate, so one step costs O(n^2) instead of
+O(w * n^2 + n^3). A downdate that would lose positive definiteness marks the factor stale; the next solve
+refactors the Gram matrix A' * A, which is kept up to date on the side.
+
+Main Function List:
+[1] StreamingLeastSquares::addRow / addRows: Append one row or a row block of A & b
+[2] StreamingLeastSquares::solve:            Current least squares solution, any number of right-hand sides
+[3] StreamingLeastSquares::residualNorm2:    Weighted residual sum of squares of every right-hand side (full rank R)
+[4] StreamingLeastSquares::merge:            Combine two solvers fed with different rows (no forgetting)
+[5] SlidingWindowLeastSquares::addRow:       Append one row, the oldest row leaves once the window is full
+[6] SlidingWindowLeastSquares::solve:        Least squares solution over the rows in the window
+
+Reference:
+[*1] Ake Bjorck, Numerical Methods for Least Squares Problems, SIAM 1996, section 3.2 (updating the QR factorization)
+*/
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_cholesky.hpp"
+#include "matBasic_qr.hpp"
+
+template <typename T>
+class StreamingLeastSquares
+{
+public:
+    using real_t = typename i_real_type<T>::type;
+
+    StreamingLeastSquares() = default;
+
+    StreamingLeastSquares(const std::size_t ncols, const std::size_t nrhs = 1, const real_t forgetting = 1.0, const real_t regularization = 0.0)
+        : m_forgetting{forgetting}, m_regularization{regularization}
+    {
+        if (!(forgetting > 0 && forgetting <= 1))
+        {
+            std::cout << "Error when using StreamingLeastSquares: forgetting factor should be in (0, 1].\n";
+            m_forgetting = 1.0;
+        }
+        m_r = i_dense_matrix<T>(ncols, ncols);
+        m_z = i_dense_matrix<T>(ncols, nrhs);
+        reset();
+    }
+
+    std::size_t cols() const { return m_r.rows(); }
+    std::size_t rhs() const { return m_z.cols(); }
+    std::size_t count() const { return m_count; } // Rows added since construction / reset
+    real_t forgetting() const { return m_forgetting; }
+    const i_dense_matrix<T> &upper() const { return m_r; }
+    const std::vector<real_t> &residualNorm2() const { return m_residual; }
+
+    // Forget every row, back to R = sqrt(delta) * I
+    void reset()
+    {
+        const std::size_t ncols{cols()};
+        for (std::size_t i{0}; i < ncols; ++i)
+        {
+            std::fill_n(m_r.row(i), ncols, T{});
+            std::fill_n(m_z.row(i), rhs(), T{});
+            m_r(i, i) = T{std::sqrt(m_regularization)};
+        }
+        m_residual.assign(rhs(), 0);
+        m_count = 0;
+    }
+
+    // One row: rowA holds cols() values, rowb holds rhs() values
+    void addRow(const T *rowA, const T *rowb)
+    {
+        m_rowA.assign(rowA, rowA + cols());
+        m_rowb.assign(rowb, rowb + rhs());
+        ageFactor(std::sqrt(m_forgetting));
+        rotateRow(m_rowA.data(), m_rowb.data());
+        ++m_count;
+    }
+
+    // Row block, the same as adding the rows of matA & matb one by one from top to bottom
+    void addRows(const i_dense_matrix<T> &matA, const i_dense_matrix<T> &matb)
+    {
+        const std::size_t ncols{cols()}, nrhs{rhs()}, nAdd{matA.rows()};
+        if (matA.cols() != ncols || matb.cols() != nrhs)
+        {
+            std::cout << "Error when using StreamingLeastSquares::addRows: column size not match.\n";
+            return;
+        }
+        if (matb.rows() != nAdd)
+        {
+            std::cout << "Error when using StreamingLeastSquares::addRows: row size not match.\n";
+            return;
+        }
+        if (nAdd < ncols || ncols == 0)
+        {
+            for (std::size_t i{0}; i < nAdd; ++i)
+            {
+                addRow(matA.row(i), matb.row(i));
+            }
+            return;
+        }
+
+        // Stack [w^nAdd * R, w^nAdd * z; w^(nAdd - 1 - i) * rows], w = sqrt(lambda), & refactor
+        const real_t weight{std::sqrt(m_forgetting)};
+        i_dense_matrix<T> stackA(ncols + nAdd, ncols), stackb(ncols + nAdd, nrhs);
+        ageFactor(std::pow(weight, static_cast<real_t>(nAdd)));
+        for (std::size_t i{0}; i < ncols; ++i)
+        {
+            std::copy_n(m_r.row(i) + i, ncols - i, stackA.row(i) + i);
+            std::copy_n(m_z.row(i), nrhs, stackb.row(i));
+        }
+        real_t rowWeight{1};
+        for (std::size_t i{nAdd}; i > 0; --i)
+        {
+            const T scale{rowWeight};
+            for (std::size_t j{0}; j < ncols; ++j)
+            {
+                stackA(ncols + i - 1, j) = scale * matA(i - 1, j);
+            }
+            for (std::size_t j{0}; j < nrhs; ++j)
+            {
+                stackb(ncols + i - 1, j) = scale * matb(i - 1, j);
+            }
+            rowWeight *= weight;
+        }
+        const QRFactorization<T> factorQR(stackA);
+        const i_dense_matrix<T> matQtb{factorQR.applyAdjointQ(stackb)};
+        for (std::size_t i{0}; i < ncols; ++i)
+        {
+            std::copy_n(factorQR.packedQR().row(i) + i, ncols - i, m_r.row(i) + i);
+            std::copy_n(matQtb.row(i), nrhs, m_z.row(i));
+        }
+        for (std::size_t i{ncols}; i < ncols + nAdd; ++i)
+        {
+            for (std::size_t j{0}; j < nrhs; ++j)
+            {
+                m_residual[j] += std::norm(matQtb(i, j)); // The part of Q' * b that no x can reach
+            }
+        }
+        m_count += nAdd;
+    }
+
+    // Fold in every row other has seen, as if they had been added here: [R; R_other] is refactored like a row block.
+    // This is the reduction step of a tall-skinny QR (see matBasic_tsqr.hpp). lambda = 1 only, regularizations add up
+    void merge(const StreamingLeastSquares &other)
+    {
+        if (other.cols() != cols() || other.rhs() != rhs())
+        {
+            std::cout << "Error when using StreamingLeastSquares::merge: column size not match.\n";
+            return;
+        }
+        if (m_forgetting != 1 || other.m_forgetting != 1)
+        {
+            std::cout << "Error when using StreamingLeastSquares::merge: forgetting factor should be 1.\n";
+            return;
+        }
+        const std::size_t count{m_count + other.m_count};
+        addRows(other.m_r, other.m_z);
+        for (std::size_t j{0}; j < rhs(); ++j)
+        {
+            m_residual[j] += other.m_residual[j];
+        }
+        m_count = count;
+    }
+
+    // false if some |R(i, i)| <= tolerance * max|R(i, i)|, i.e. the rows seen so far do not determine x
+    bool fullRank(const real_t tolerance = defaultTolerance<T>()) const
+    {
+        real_t maxDiag{0};
+        for (std::size_t i{0}; i < cols(); ++i)
+        {
+            maxDiag = std::max(maxDiag, static_cast<real_t>(std::abs(m_r(i, i))));
+        }
+        for (std::size_t i{0}; i < cols(); ++i)
+        {
+            if (!(std::abs(m_r(i, i)) > tolerance * maxDiag))
+            {
+                return false;
+            }
+        }
+        return maxDiag > 0;
+    }
+
+    // X = R \ z by back substitution
+    i_dense_matrix<T> solve(const real_t tolerance = defaultTolerance<T>()) const
+    {
+        const std::size_t ncols{cols()}, nrhs{rhs()};
+        i_dense_matrix<T> matX;
+        if (!fullRank(tolerance))
+        {
+            std::cout << "Warning when using StreamingLeastSquares::solve: matrix is rank deficient.\n";
+            return matX;
+        }
+        matX = i_dense_matrix<T>(ncols, nrhs);
+        for (std::size_t i{ncols}; i > 0; --i)
+        {
+            const std::size_t ii{i - 1};
+            T *rowX{matX.row(ii)};
+            std::copy_n(m_z.row(ii), nrhs, rowX);
+            for (std::size_t q{ii + 1}; q < ncols; ++q)
+            {
+                i_kernel::axpy(nrhs, -m_r(ii, q), matX.row(q), rowX);
+            }
+            const T diagInv{T{1} / m_r(ii, ii)};
+            for (std::size_t j{0}; j < nrhs; ++j)
+            {
+                rowX[j] *= diagInv;
+            }
+        }
+        return matX;
+    }
+
+private:
+    // Multiply everything seen so far by scale (forgetting), skipped for lambda = 1
+    void ageFactor(const real_t scale)
+    {
+        if (scale == 1)
+        {
+            return;
+        }
+        for (std::size_t i{0}; i < cols(); ++i)
+        {
+            T *rowR{m_r.row(i)};
+            for (std::size_t j{i}; j < cols(); ++j)
+            {
+                rowR[j] *= scale;
+            }
+            T *rowZ{m_z.row(i)};
+            for (std::size_t j{0}; j < rhs(); ++j)
+            {
+                rowZ[j] *= scale;
+            }
+        }
+        for (real_t &value : m_residual)
+        {
+            value *= scale * scale;
+        }
+    }
+
+    // [R, z; a, b] -> [R', z'; 0, b'] with one Givens rotation per column: G = [c, s; -conj(s), c], c real,
+    // zeroes a(j) against R(j, j). What is left of b is residual
+    void rotateRow(T *rowA, T *rowb)
+    {
+        const std::size_t ncols{cols()}, nrhs{rhs()};
+        for (std::size_t j{0}; j < ncols; ++j)
+        {
+            const T valA{rowA[j]};
+            if (valA == T{})
+            {
+                continue;
+            }
+            T *rowR{m_r.row(j)};
+            T *rowZ{m_z.row(j)};
+            const real_t absR{std::abs(rowR[j])}, norm{std::hypot(absR, static_cast<real_t>(std::abs(valA)))};
+            const T phase{absR == 0 ? T{1} : rowR[j] / absR};
+            const real_t c{absR / norm};
+            const T s{phase * conjScalar(valA) / norm}, sc{conjScalar(s)};
+            rowR[j] = phase * norm;
+            for (std::size_t k{j + 1}; k < ncols; ++k)
+            {
+                const T valR{rowR[k]};
+                rowR[k] = c * valR + s * rowA[k];
+                rowA[k] = c * rowA[k] - sc * valR;
+            }
+            for (std::size_t k{0}; k < nrhs; ++k)
+            {
+                const T valZ{rowZ[k]};
+                rowZ[k] = c * valZ + s * rowb[k];
+                rowb[k] = c * rowb[k] - sc * valZ;
+            }
+        }
+        for (std::size_t k{0}; k < nrhs; ++k)
+        {
+            m_residual[k] += std::norm(rowb[k]);
+        }
+    }
+
+    i_dense_matrix<T> m_r; // Upper triangle of R, the strict lower triangle stays zero
+    i_dense_matrix<T> m_z; // Q' * W * b, top n rows
+    std::vector<real_t> m_residual; // Rotated-out part of W * b, squared, per right-hand side
+    std::vector<T> m_rowA, m_rowb; // Row workspace of addRow
+    real_t m_forgetting{1.0};
+    real_t m_regularization{0.0};
+    std::size_t m_count{0};
+};
+
+template <typename T>
+class SlidingWindowLeastSquares
+{
+public:
+    using real_t = typename i_real_type<T>::type;
+
+    SlidingWindowLeastSquares() = default;
+
+    SlidingWindowLeastSquares(const std::size_t ncols, const std::size_t window, const std::size_t nrhs = 1, const real_t tolerance = defaultTolerance<T>())
+        : m_rowsA(window, ncols), m_rowsb(window, nrhs), m_gram(ncols, ncols), m_atb(ncols, nrhs), m_rowX(ncols), m_tolerance{tolerance}
+    {
+    }
+
+    std::size_t cols() const { return m_gram.rows(); }
+    std::size_t rhs() const { return m_atb.cols(); }
+    std::size_t window() const { return m_rowsA.rows(); }
+    std::size_t count() const { return m_count; } // Rows currently in the window
+
+    // One row: rowA holds cols() values, rowb holds rhs() values
+    void addRow(const T *rowA, const T *rowb)
+    {
+        if (window() == 0)
+        {
+            return;
+        }
+        modify(rowA, rowb, T{1}); // Update before the downdate, A' * A never gets smaller than the window
+        if (m_factorValid)
+        {
+            m_factor.update(m_rowX.data());
+        }
+        if (m_count == window())
+        {
+            removeOldest();
+        }
+        const std::size_t slot{(m_head + m_count) % window()};
+        std::copy_n(rowA, cols(), m_rowsA.row(slot));
+        std::copy_n(rowb, rhs(), m_rowsb.row(slot));
+        ++m_count;
+    }
+
+    // Drop the oldest row of the window
+    void removeOldest()
+    {
+        if (m_count == 0)
+        {
+            return;
+        }
+        modify(m_rowsA.row(m_head), m_rowsb.row(m_head), T{-1});
+        if (m_factorValid)
+        {
+            m_factorValid = m_factor.downdate(m_rowX.data()); // Lost positive definiteness: refactor on the next solve
+        }
+        m_head = (m_head + 1) % window();
+        --m_count;
+    }
+
+    // X = (A' * A) \ (A' * b) over the window, Cholesky solve with the kept factor
+    i_dense_matrix<T> solve()
+    {
+        if (!m_factorValid && m_count >= cols())
+        {
+            m_factor = CholeskyFactorization<T>(m_gram, m_tolerance);
+            m_factorValid = m_factor.positiveDefinite();
+        }
+        if (!m_factorValid)
+        {
+            std::cout << "Warning when using SlidingWindowLeastSquares::solve: matrix is rank deficient.\n";
+            return i_dense_matrix<T>();
+        }
+        return m_factor.solve(m_atb);
+    }
+
+private:
+    // A' * A += sign * x * x' & A' * b += sign * x * b with x = a', a one row of A, left in m_rowX
+    void modify(const T *rowA, const T *rowb, const T sign)
+    {
+        for (std::size_t i{0}; i < cols(); ++i)
+        {
+            m_rowX[i] = conjScalar(rowA[i]);
+        }
+        for (std::size_t i{0}; i < cols(); ++i)
+        {
+            const T valX{sign * m_rowX[i]};
+            i_kernel::axpy(i + 1, valX, rowA, m_gram.row(i)); // Lower triangle only: G(i, 0:i) += conj(a(i)) * a(0:i)
+            i_kernel::axpy(rhs(), valX, rowb, m_atb.row(i));
+        }
+    }
+
+    i_dense_matrix<T> m_rowsA, m_rowsb; // Ring buffer of the rows in the window, oldest at m_head
+    i_dense_matrix<T> m_gram; // Lower triangle of A' * A over the window
+    i_dense_matrix<T> m_atb; // A' * b over the window
+    CholeskyFactorization<T> m_factor;
+    std::vector<T> m_rowX;
+    real_t m_tolerance{defaultTolerance<T>()};
+    std::size_t m_head{0};
+    std::size_t m_count{0};
+    bool m_factorValid{false};
+};
@@ -0,0 +1,349 @@
+#pragma once
+/*
+Mini Matrix Tools - Fast Text Import / Export
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+MATLAB style text "name = [a, b; c, d];" and CSV "a,b\nc,d", real & complex ("1.5-2i", "3+0i"), written & read in bulk:
+    writing: std::to_chars into a 64 KB buffer, handed to the stream one buffer at a time (no per-element operator<<)
+    reading: the whole text is scanned once with std::from_chars, no locale, no stream state
+to_chars gives the shortest text that reads back to the same value, so write -> read is exact (also inf / nan / -0).
+The reader takes both forms: an optional "name =" & brackets; ',', spaces or tabs between columns; ';' or a new line
+between rows; '%' starts a comment. One matrix per text: after ']' only ';', blanks & comments may follow.
+Complex values are "re+imi", "re-imi" or "imi" ('j' works as well); a real matrix refuses complex values.
+
+Main Function List:
+[1] writeMatrixText: Matrix -> std::ostream or file, MATLAB or CSV
+[2] parseMatrixText: Text -> matrix, MATLAB or CSV (detected)
+[3] readMatrixText:  File -> matrix
+*/
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "matBasic_dense.hpp"
+
+enum class i_text_format : int
+{
+    matlab = 0, // name = [a, b; c, d];
+    csv = 1     // a,b newline c,d
+};
+
+namespace i_text
+{
+    constexpr std::size_t bufferSize{1u << 16};
+    constexpr std::size_t maxNumberLength{64}; // Longest to_chars output of a double is 24 characters
+
+    // Collects the text & hands it to the stream in large pieces
+    class writer
+    {
+    public:
+        explicit writer(std::ostream &os) : m_os{os} { m_buffer.reserve(bufferSize); }
+        writer(const writer &) = delete;
+        writer &operator=(const writer &) = delete;
+        ~writer() { flush(); }
+
+        void put(const char *text, const std::size_t len)
+        {
+            reserve(len);
+            m_buffer.append(text, len);
+        }
+        void put(const char *text) { put(text, std::strlen(text)); }
+
+        template <typename R>
+        void number(const R value)
+        {
+            reserve(maxNumberLength);
+            char digits[maxNumberLength];
+            const std::to_chars_result res{std::to_chars(digits, digits + maxNumberLength, value)};
+            m_buffer.append(digits, res.ptr);
+        }
+
+        template <typename R>
+        void number(const std::complex<R> value)
+        {
+            number(value.real());
+            if (!std::signbit(value.imag()))
+            {
+                m_buffer.push_back('+');
+            }
+            number(value.imag());
+            m_buffer.push_back('i');
+        }
+
+        void flush()
+        {
+            m_os.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+            m_buffer.clear();
+        }
+
+    private:
+        void reserve(const std::size_t len)
+        {
+            if (m_buffer.size() + len + 2 > bufferSize)
+            {
+                flush();
+            }
+        }
+
+        std::ostream &m_os;
+        std::string m_buffer;
+    };
+
+    // from_chars refuses a leading '+', MATLAB & CSV writers may put one
+    template <typename R>
+    const char *parseReal(const char *first, const char *last, R &value)
+    {
+        if (first < last && *first == '+')
+        {
+            ++first;
+        }
+        const std::from_chars_result res{std::from_chars(first, last, value)};
+        return res.ec == std::errc{} ? res.ptr : nullptr;
+    }
+
+    // One element: "re", "imi", "re+imi" or "re-imi"; nullptr on a syntax error
+    template <typename T>
+    const char *parseValue(const char *first, const char *last, T &value, bool &isComplex)
+    {
+        using real_t = typename i_real_type<T>::type;
+        real_t re{0}, im{0};
+        const char *pos{parseReal(first, last, re)};
+        isComplex = false;
+        if (!pos)
+        {
+            return nullptr;
+        }
+        if (pos < last && (*pos == 'i' || *pos == 'j'))
+        {
+            std::swap(re, im);
+            isComplex = true;
+            ++pos;
+        }
+        else if (pos < last && (*pos == '+' || *pos == '-'))
+        {
+            pos = parseReal(pos, last, im);
+            if (!pos || pos == last || (*pos != 'i' && *pos != 'j'))
+            {
+                return nullptr;
+            }
+            isComplex = true;
+            ++pos;
+        }
+        if constexpr (std::is_same<T, real_t>::value)
+        {
+            value = re;
+        }
+        else
+        {
+            value = T{re, im};
+        }
+        return pos;
+    }
+} // namespace i_text
+
+// Shortest round-trip text of every element, MATLAB "name = [...];" (name may be nullptr: "[...]") or CSV
+template <typename T>
+bool writeMatrixText(std::ostream &os, const i_dense_matrix<T> &matG, const i_text_format format = i_text_format::matlab, const char *name = nullptr)
+{
+    const bool matlab{format == i_text_format::matlab};
+    const char *colSep{matlab ? ", " : ","}, *rowSep{matlab ? ";\n" : "\n"};
+    {
+        i_text::writer out(os);
+        if (matlab)
+        {
+            if (name)
+            {
+                out.put(name);
+                out.put(" = ");
+            }
+            out.put("[");
+        }
+        for (std::size_t i{0}; i < matG.rows(); ++i)
+        {
+            const T *rowG{matG.row(i)};
+            for (std::size_t j{0}; j < matG.cols(); ++j)
+            {
+                if (j > 0)
+                {
+                    out.put(colSep);
+                }
+                out.number(rowG[j]);
+            }
+            if (matlab ? i + 1 < matG.rows() : true)
+            {
+                out.put(rowSep);
+            }
+        }
+        if (matlab)
+        {
+            out.put(name ? "];\n" : "]\n");
+        }
+    }
+    return static_cast<bool>(os);
+}
+
+template <typename T>
+bool writeMatrixText(const std::string &path, const i_dense_matrix<T> &matG, const i_text_format format = i_text_format::matlab, const char *name = nullptr)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Error when using writeMatrixText: cannot open " << path << ".\n";
+        return false;
+    }
+    return writeMatrixText(file, matG, format, name);
+}
+
+// MATLAB or CSV text -> matrix; an empty matrix & a message on a syntax error or rows of different lengths
+template <typename T>
+i_dense_matrix<T> parseMatrixText(const std::string &text)
+{
+    const char *pos{text.data()}, *last{text.data() + text.size()};
+    const auto isBlank = [](const char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    const auto error = [&](const char *what) {
+        std::cout << "Error when using parseMatrixText: " << what << " at offset " << pos - text.data() << ".\n";
+        return i_dense_matrix<T>();
+    };
+
+    // Optional "name =" and '['
+    const char *start{pos};
+    while (start < last && (isBlank(*start) || *start == '\n'))
+    {
+        ++start;
+    }
+    const char *equal{std::find(start, last, '=')}, *bracket{std::find(start, last, '[')};
+    if (equal < bracket && bracket < last)
+    {
+        start = equal + 1;
+    }
+    while (start < last && (isBlank(*start) || *start == '\n'))
+    {
+        ++start;
+    }
+    const bool inBracket{start < last && *start == '['};
+    pos = inBracket ? start + 1 : start;
+
+    std::vector<T> values;
+    std::size_t ncols{0}, rowLength{0}, nrows{0};
+    bool closed{false};
+    const auto endRow = [&]() {
+        if (rowLength == 0)
+        {
+            return true; // Blank line or separator right after another one
+        }
+        if (nrows > 0 && rowLength != ncols)
+        {
+            return false;
+        }
+        ncols = rowLength;
+        rowLength = 0;
+        ++nrows;
+        return true;
+    };
+    while (pos < last && !closed)
+    {
+        const char c{*pos};
+        if (isBlank(c) || c == ',')
+        {
+            ++pos;
+        }
+        else if (c == ';' || c == '\n')
+        {
+            if (!endRow())
+            {
+                return error("rows have different lengths");
+            }
+            ++pos;
+        }
+        else if (c == '%')
+        {
+            pos = std::find(pos, last, '\n');
+        }
+        else if (c == ']' && inBracket)
+        {
+            closed = true;
+            ++pos;
+        }
+        else
+        {
+            T value{};
+            bool isComplex{false};
+            const char *next{i_text::parseValue(pos, last, value, isComplex)};
+            if (!next)
+            {
+                return error("not a number");
+            }
+            if (isComplex && std::is_same<T, typename i_real_type<T>::type>::value)
+            {
+                return error("complex value in a real matrix");
+            }
+            values.push_back(value);
+            ++rowLength;
+            pos = next;
+        }
+    }
+    if (inBracket && !closed)
+    {
+        return error("missing ']'");
+    }
+    while (closed && pos < last) // Only ';', blanks & comments may follow the matrix
+    {
+        if (isBlank(*pos) || *pos == ';' || *pos == '\n')
+        {
+            ++pos;
+        }
+        else if (*pos == '%')
+        {
+            pos = std::find(pos, last, '\n');
+        }
+        else
+        {
+            return error("unexpected text after ']'");
+        }
+    }
+    if (!endRow())
+    {
+        return error("rows have different lengths");
+    }
+
+    i_dense_matrix<T> matG(nrows, ncols);
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        std::copy_n(values.data() + i * ncols, ncols, matG.row(i));
+    }
+    return matG;
+}
+
+template <typename T>
+i_dense_matrix<T> readMatrixText(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Error when using readMatrixText: cannot open " << path << ".\n";
+        return i_dense_matrix<T>();
+    }
+    file.seekg(0, std::ios::end);
+    const std::streamoff size{file.tellg()};
+    if (size < 0)
+    {
+        std::cout << "Error when using readMatrixText: cannot read " << path << ".\n";
+        return i_dense_matrix<T>();
+    }
+    std::string text(static_cast<std::size_t>(size), '\0');
+    file.seekg(0);
+    if (!file.read(&text[0], static_cast<std::streamsize>(text.size())))
+    {
+        std::cout << "Error when using readMatrixText: cannot read " << path << ".\n";
+        return i_dense_matrix<T>();
+    }
+    return parseMatrixText<T>(text);
+}
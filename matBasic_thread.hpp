@@ -0,0 +1,456 @@
+#pragma once
+/*
+Mini Matrix Tools - Work-Stealing Thread Pool
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+One library-owned pool, created on first use. Every worker owns a task deque: it pops its own tasks
+from the back (LIFO, cache-warm) and steals from the front of the others (FIFO, large chunks) [*1].
+The thread that calls parallelFor runs the first chunk itself and helps with queued tasks while it
+waits, so nested parallelFor calls cannot deadlock.
+setThreadCount / setThreadAffinity restart the workers: call them only while no other thread is inside parallelFor,
+submit or a task graph, work in flight on another thread during a reconfiguration is undefined behavior.
+Kernels only go parallel above i_parallel_min_work multiply-adds: small inputs stay on the calling thread.
+
+Main Function List:
+[1] setThreadCount / threadCount: Number of threads used by the kernels, including the calling thread (1 = serial)
+[2] setThreadAffinity:            Pin worker i to cpus[i % cpus.size()] (Linux only, an empty list unpins)
+[3] parallelFor:                  Split [begin, end) into chunks of about grain (at most 4 per thread), body(chunkBegin, chunkEnd) on the pool
+[4] i_task_graph:                 Tasks with tile read / write sets, run in dependency order as soon as their inputs are ready
+
+Reference:
+[*1] Robert D. Blumofe, Charles E. Leiserson, Scheduling Multithreaded Computations by Work Stealing, J. ACM 46(5), 1999
+[*2] Alfredo Buttari, Julien Langou, Jakub Kurzak, Jack Dongarra, A Class of Parallel Tiled Linear Algebra Algorithms for Multicore Architectures, Parallel Computing 35(1), 2009
+*/
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+constexpr std::size_t i_parallel_min_work{1u << 21}; // Multiply-adds (about 128^3) below which a kernel stays single-threaded
+
+class i_thread_pool
+{
+public:
+    using task_t = std::function<void()>;
+
+    i_thread_pool()
+        : m_threadCount{std::max<std::size_t>(1, std::thread::hardware_concurrency())}
+    {
+    }
+
+    ~i_thread_pool()
+    {
+        std::lock_guard<std::mutex> guard{m_configLock};
+        stopWorkers();
+    }
+
+    i_thread_pool(const i_thread_pool &) = delete;
+    i_thread_pool &operator=(const i_thread_pool &) = delete;
+
+    std::size_t threadCount() const { return m_threadCount.load(std::memory_order_relaxed); }
+
+    void setThreadCount(const std::size_t nthreads)
+    {
+        std::lock_guard<std::mutex> guard{m_configLock};
+        stopWorkers();
+        m_threadCount.store(std::max<std::size_t>(1, nthreads), std::memory_order_relaxed);
+    }
+
+    void setThreadAffinity(const std::vector<int> &cpus)
+    {
+        std::lock_guard<std::mutex> guard{m_configLock};
+        stopWorkers();
+        m_affinity = cpus;
+    }
+
+    // body(chunkBegin, chunkEnd) for chunks of [begin, end); returns when every chunk is done.
+    // grain sets the chunk count (ceil(count / grain), at most 4 per thread), so a chunk may be shorter than grain:
+    // count = 5, grain = 4 gives two chunks of 3 and 2
+    template <typename F>
+    void parallelFor(const std::size_t begin, const std::size_t end, const std::size_t grain, F &&body)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+        const std::size_t count{end - begin}, minChunk{std::max<std::size_t>(1, grain)};
+        const std::size_t nthreads{threadCount()};
+        const std::size_t nchunks{std::min((count + minChunk - 1) / minChunk, nthreads * 4)};
+        if (nthreads == 1 || nchunks < 2 || inGraphTask())
+        {
+            body(begin, end);
+            return;
+        }
+        startWorkers();
+
+        const std::size_t chunk{(count + nchunks - 1) / nchunks};
+        auto remaining = std::make_shared<std::atomic<std::size_t>>(0);
+        for (std::size_t b{begin + chunk}; b < end; b += chunk)
+        {
+            remaining->fetch_add(1);
+            const std::size_t e{std::min(b + chunk, end)};
+            push([&body, remaining, b, e]() {
+                body(b, e);
+                remaining->fetch_sub(1, std::memory_order_release);
+            });
+        }
+        body(begin, std::min(begin + chunk, end));
+        helpUntil([&remaining]() { return remaining->load(std::memory_order_acquire) == 0; });
+    }
+
+    // Queue one task (workers start on first use); threadCount() must be above 1
+    void submit(task_t task)
+    {
+        startWorkers();
+        push(std::move(task));
+    }
+
+    // Run queued tasks on the calling thread until done() holds
+    template <typename F>
+    void helpUntil(F &&done)
+    {
+        while (!done())
+        {
+            if (!runOneTask())
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // True while this thread runs a task-graph node: parallelFor stays serial there, the graph already keeps every thread busy
+    static bool &inGraphTask()
+    {
+        thread_local bool flag{false};
+        return flag;
+    }
+
+private:
+    struct worker_queue
+    {
+        std::mutex lock;
+        std::deque<task_t> tasks;
+    };
+
+    static int &workerIndex()
+    {
+        thread_local int index{-1}; // -1: not a worker of this pool
+        return index;
+    }
+
+    void startWorkers()
+    {
+        if (m_running.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> guard{m_configLock}; // Same lock as stopWorkers
+        if (m_running.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        const std::size_t nworkers{threadCount() - 1};
+        m_queues.clear();
+        for (std::size_t i{0}; i < nworkers; ++i)
+        {
+            m_queues.push_back(std::make_unique<worker_queue>());
+        }
+        m_stop = false;
+        for (std::size_t i{0}; i < nworkers; ++i)
+        {
+            m_workers.emplace_back([this, i]() { workerLoop(i); });
+            pinWorker(i);
+        }
+        m_running.store(true, std::memory_order_release);
+    }
+
+    // Caller holds m_configLock
+    void stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> sleepGuard{m_sleepLock};
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::thread &worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+        m_queues.clear();
+        m_pending = 0;
+        m_running.store(false, std::memory_order_release);
+    }
+
+    void pinWorker(const std::size_t i)
+    {
+#if defined(__linux__)
+        if (m_affinity.empty())
+        {
+            return;
+        }
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(m_affinity[i % m_affinity.size()], &cpuSet);
+        pthread_setaffinity_np(m_workers[i].native_handle(), sizeof(cpu_set_t), &cpuSet);
+#else
+        (void)i;
+#endif
+    }
+
+    void push(task_t task)
+    {
+        const int self{workerIndex()};
+        const std::size_t target{self >= 0 ? static_cast<std::size_t>(self) : m_nextQueue.fetch_add(1) % m_queues.size()};
+        {
+            std::lock_guard<std::mutex> guard{m_queues[target]->lock};
+            m_queues[target]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> sleepGuard{m_sleepLock};
+            ++m_pending;
+        }
+        m_wake.notify_one();
+    }
+
+    // Own queue from the back first, then steal from the front of the others
+    bool runOneTask()
+    {
+        const int self{workerIndex()};
+        const std::size_t nqueues{m_queues.size()}, first{self >= 0 ? static_cast<std::size_t>(self) : 0};
+        for (std::size_t q{0}; q < nqueues; ++q)
+        {
+            const std::size_t victim{(first + q) % nqueues};
+            task_t task;
+            {
+                std::lock_guard<std::mutex> guard{m_queues[victim]->lock};
+                std::deque<task_t> &tasks{m_queues[victim]->tasks};
+                if (tasks.empty())
+                {
+                    continue;
+                }
+                if (q == 0 && self >= 0)
+                {
+                    task = std::move(tasks.back());
+                    tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> sleepGuard{m_sleepLock};
+                --m_pending;
+            }
+            task();
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(const std::size_t index)
+    {
+        workerIndex() = static_cast<int>(index);
+        while (true)
+        {
+            if (runOneTask())
+            {
+                continue;
+            }
+            std::unique_lock<std::mutex> sleepGuard{m_sleepLock};
+            m_wake.wait(sleepGuard, [this]() { return m_stop || m_pending > 0; });
+            if (m_stop)
+            {
+                return;
+            }
+        }
+    }
+
+    std::atomic<std::size_t> m_threadCount;
+    std::vector<int> m_affinity;
+    std::vector<std::unique_ptr<worker_queue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::atomic<bool> m_running{false};
+    std::atomic<std::size_t> m_nextQueue{0};
+    std::mutex m_configLock, m_sleepLock; // m_configLock serializes starting & stopping the workers
+    std::condition_variable m_wake;
+    std::size_t m_pending{0}; // Queued tasks, guarded by m_sleepLock
+    bool m_stop{false};
+};
+
+inline i_thread_pool &threadPool()
+{
+    static i_thread_pool pool;
+    return pool;
+}
+
+inline std::size_t threadCount()
+{
+    return threadPool().threadCount();
+}
+
+inline void setThreadCount(const std::size_t nthreads)
+{
+    threadPool().setThreadCount(nthreads);
+}
+
+inline void setThreadAffinity(const std::vector<int> &cpus)
+{
+    threadPool().setThreadAffinity(cpus);
+}
+
+template <typename F>
+void parallelFor(const std::size_t begin, const std::size_t end, const std::size_t grain, F &&body)
+{
+    threadPool().parallelFor(begin, end, grain, std::forward<F>(body));
+}
+
+// Dependency graph of tasks on tiles, run by the pool as soon as the inputs of a task are ready [*2].
+// Tasks are added in sequential program order with the tiles they read & write; read-after-write,
+// write-after-read & write-after-write edges are derived from that order, so running the tasks one by
+// one in insertion order is always a valid schedule (that is what a single thread does).
+// A finished task runs its most urgent released successor itself and queues the others.
+class i_task_graph
+{
+public:
+    explicit i_task_graph(const std::size_t ntiles)
+        : m_lastWriter(ntiles, npos), m_readers(ntiles)
+    {
+    }
+
+    // priority: larger runs earlier among the ready successors of a task (e.g. panels on the critical path)
+    void addTask(std::function<void()> body, const std::vector<std::size_t> &reads, const std::vector<std::size_t> &writes, const int priority = 0)
+    {
+        const std::size_t id{m_nodes.size()};
+        m_nodes.push_back(node{std::move(body), {}, 0, priority});
+        for (const std::size_t tile : reads)
+        {
+            addEdge(m_lastWriter[tile], id);
+            m_readers[tile].push_back(id);
+        }
+        for (const std::size_t tile : writes)
+        {
+            addEdge(m_lastWriter[tile], id);
+            for (const std::size_t reader : m_readers[tile])
+            {
+                addEdge(reader, id);
+            }
+            m_readers[tile].clear();
+            m_lastWriter[tile] = id;
+        }
+    }
+
+    std::size_t size() const { return m_nodes.size(); }
+
+    // Run every task & wait for them; the calling thread works too
+    void run()
+    {
+        const std::size_t ntasks{m_nodes.size()};
+        i_thread_pool &pool{threadPool()};
+        if (pool.threadCount() == 1 || ntasks < 2)
+        {
+            for (node &task : m_nodes)
+            {
+                runBody(task);
+            }
+            return;
+        }
+        m_remaining.reset(new std::atomic<std::size_t>[ntasks]);
+        for (std::size_t i{0}; i < ntasks; ++i)
+        {
+            m_remaining[i].store(m_nodes[i].predecessors, std::memory_order_relaxed);
+        }
+        m_unfinished.store(ntasks);
+        for (std::size_t i{0}; i < ntasks; ++i)
+        {
+            if (m_nodes[i].predecessors == 0)
+            {
+                pool.submit([this, i]() { execute(i); });
+            }
+        }
+        pool.helpUntil([this]() { return m_unfinished.load(std::memory_order_acquire) == 0; });
+    }
+
+private:
+    static constexpr std::size_t npos{static_cast<std::size_t>(-1)};
+
+    struct node
+    {
+        std::function<void()> body;
+        std::vector<std::size_t> successors;
+        std::size_t predecessors;
+        int priority;
+    };
+
+    void addEdge(const std::size_t from, const std::size_t to)
+    {
+        if (from == npos || from == to)
+        {
+            return;
+        }
+        std::vector<std::size_t> &successors{m_nodes[from].successors};
+        if (successors.empty() || successors.back() != to) // Edges to one task are added one after another
+        {
+            successors.push_back(to);
+            ++m_nodes[to].predecessors;
+        }
+    }
+
+    static void runBody(node &task)
+    {
+        bool &inTask{i_thread_pool::inGraphTask()};
+        const bool outer{inTask};
+        inTask = true;
+        task.body();
+        inTask = outer;
+    }
+
+    void execute(std::size_t id)
+    {
+        while (id != npos)
+        {
+            runBody(m_nodes[id]);
+            std::size_t next{npos};
+            for (const std::size_t succ : m_nodes[id].successors)
+            {
+                if (m_remaining[succ].fetch_sub(1, std::memory_order_acq_rel) != 1)
+                {
+                    continue; // Still waits for another input
+                }
+                if (next == npos)
+                {
+                    next = succ;
+                    continue;
+                }
+                std::size_t queued{succ};
+                if (m_nodes[queued].priority > m_nodes[next].priority)
+                {
+                    std::swap(queued, next);
+                }
+                threadPool().submit([this, queued]() { execute(queued); });
+            }
+            m_unfinished.fetch_sub(1, std::memory_order_release);
+            id = next;
+        }
+    }
+
+    std::vector<node> m_nodes;
+    std::vector<std::size_t> m_lastWriter;
+    std::vector<std::vector<std::size_t>> m_readers;
+    std::unique_ptr<std::atomic<std::size_t>[]> m_remaining;
+    std::atomic<std::size_t> m_unfinished{0};
+};
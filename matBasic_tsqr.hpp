@@ -0,0 +1,159 @@
+#pragma once
+/*
+Mini Matrix Tools - Out-of-Core Tall-Skinny QR Least Squares
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+x = A \ b for A with far more rows than fit in memory, m >> n. A & b are read once, block by block, and never held
+as a whole [*1][*2]:
+    every worker keeps its own n x n factor R_w & z_w = Q_w' * b (a StreamingLeastSquares, see matBasic_streaming.hpp)
+    worker w takes the next row block [A_k, b_k] & refactors [R_w, z_w; A_k, b_k] by the blocked Householder QR
+    the workers' factors are merged pairwise in a binary tree, log2(workers) levels: [R_u; R_w] -> R
+    x = R \ z, the rows of Q' * b below R give the residual sum of squares
+The blocks come from a callback (called by one thread at a time, in order), from matrices in memory, or from two
+matrix files (see matBasic_file.hpp) mapped without copying, so reading overlaps the QR of the other workers.
+Peak memory is O(workers * (block + n) * n) besides the mapped pages, which stay clean & can be dropped by the system.
+Unlike A' * A the condition number is not squared, the result matches leftDiv on the whole matrix.
+
+Main Function List:
+[1] i_row_block_source: Callback filling the next row block of A & b, returns the rows filled (0 at the end)
+[2] tsqrFactor:         Factor R & Q' * b of all blocks, returned as a StreamingLeastSquares (solve, residualNorm2, count)
+[3] tsqrLeftDiv:        x = A \ b, from a callback, matrices or matrix files
+
+Reference:
+[*1] James Demmel, Laura Grigori, Mark Hoemmen, Julien Langou, Communication-optimal Parallel and Sequential QR and LU Factorizations, SIAM J. Sci. Comput. 34(1), 2012
+[*2] Ake Bjorck, Numerical Methods for Least Squares Problems, SIAM 1996, section 3.2 (updating the QR factorization)
+*/
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "matBasic_dense.hpp"
+#include "matBasic_file.hpp"
+#include "matBasic_streaming.hpp"
+#include "matBasic_thread.hpp"
+
+constexpr std::size_t i_tsqr_block_bytes{1u << 23}; // Default row block size, 8 MB of A per worker
+
+// Fill the first rows of blockA (block x n) & blockb (block x nrhs), return how many, 0 when A is exhausted
+template <typename T>
+using i_row_block_source = std::function<std::size_t(i_dense_matrix<T> &blockA, i_dense_matrix<T> &blockb)>;
+
+template <typename T>
+StreamingLeastSquares<T> tsqrFactor(const std::size_t ncols, const std::size_t nrhs, const i_row_block_source<T> &source, std::size_t blockRows = 0)
+{
+    if (blockRows == 0)
+    {
+        blockRows = std::max<std::size_t>(2 * ncols, i_tsqr_block_bytes / (i_dense_matrix<T>::paddedStride(ncols) * sizeof(T) + 1));
+    }
+    blockRows = std::max<std::size_t>(blockRows, std::max<std::size_t>(ncols, 1)); // Shorter blocks would take the Givens path
+    const std::size_t nWorkers{threadCount()};
+    std::vector<StreamingLeastSquares<T>> partial(nWorkers, StreamingLeastSquares<T>(ncols, nrhs));
+    std::mutex sourceLock;
+    bool finished{false};
+
+    parallelFor(0, nWorkers, 1, [&](const std::size_t wb, const std::size_t we) {
+        i_dense_matrix<T> blockA(blockRows, ncols), blockb(blockRows, nrhs);
+        for (std::size_t w{wb}; w < we; ++w)
+        {
+            while (true)
+            {
+                std::size_t nFilled{0};
+                {
+                    std::lock_guard<std::mutex> guard(sourceLock);
+                    if (finished)
+                    {
+                        break;
+                    }
+                    nFilled = std::min(source(blockA, blockb), blockRows);
+                    finished = nFilled == 0;
+                }
+                if (nFilled == blockRows)
+                {
+                    partial[w].addRows(blockA, blockb);
+                }
+                else
+                {
+                    for (std::size_t i{0}; i < nFilled; ++i)
+                    {
+                        partial[w].addRow(blockA.row(i), blockb.row(i)); // A short last block
+                    }
+                }
+            }
+        }
+    });
+
+    // Binary reduction tree, the merges of one level run in parallel
+    for (std::size_t step{1}; step < nWorkers; step *= 2)
+    {
+        parallelFor(0, (nWorkers + 2 * step - 1) / (2 * step), 1, [&](const std::size_t pb, const std::size_t pe) {
+            for (std::size_t p{pb}; p < pe; ++p)
+            {
+                const std::size_t w{p * 2 * step};
+                if (w + step < nWorkers)
+                {
+                    partial[w].merge(partial[w + step]);
+                }
+            }
+        });
+    }
+    return partial[0];
+}
+
+// Blocks copied from matA & matb, e.g. matrices mapped by mapMatrixFile
+template <typename T>
+StreamingLeastSquares<T> tsqrFactor(const i_dense_matrix<T> &matA, const i_dense_matrix<T> &matb, const std::size_t blockRows = 0)
+{
+    if (matA.rows() != matb.rows())
+    {
+        std::cout << "Error when using tsqrFactor: row size not match.\n";
+        return StreamingLeastSquares<T>(matA.cols(), matb.cols());
+    }
+    std::size_t nextRow{0};
+    const i_row_block_source<T> source{[&](i_dense_matrix<T> &blockA, i_dense_matrix<T> &blockb) {
+        const std::size_t nFilled{std::min(blockA.rows(), matA.rows() - nextRow)};
+        for (std::size_t i{0}; i < nFilled; ++i)
+        {
+            std::copy_n(matA.row(nextRow + i), matA.cols(), blockA.row(i));
+            std::copy_n(matb.row(nextRow + i), matb.cols(), blockb.row(i));
+        }
+        nextRow += nFilled;
+        return nFilled;
+    }};
+    return tsqrFactor<T>(matA.cols(), matb.cols(), source, blockRows);
+}
+
+template <typename T>
+i_dense_matrix<T> tsqrLeftDiv(const std::size_t ncols, const std::size_t nrhs, const i_row_block_source<T> &source,
+                              const typename i_real_type<T>::type tolerance = defaultTolerance<T>(), const std::size_t blockRows = 0)
+{
+    return tsqrFactor<T>(ncols, nrhs, source, blockRows).solve(tolerance);
+}
+
+template <typename T>
+i_dense_matrix<T> tsqrLeftDiv(const i_dense_matrix<T> &matA, const i_dense_matrix<T> &matb,
+                              const typename i_real_type<T>::type tolerance = defaultTolerance<T>(), const std::size_t blockRows = 0)
+{
+    if (matA.rows() != matb.rows())
+    {
+        std::cout << "Error when using tsqrLeftDiv: row size not match.\n";
+        return i_dense_matrix<T>();
+    }
+    return tsqrFactor(matA, matb, blockRows).solve(tolerance);
+}
+
+// A & b stored by writeMatrixFile / i_matrix_file_writer, mapped & read block by block
+template <typename T>
+i_dense_matrix<T> tsqrLeftDiv(const std::string &pathA, const std::string &pathB,
+                              const typename i_real_type<T>::type tolerance = defaultTolerance<T>(), const std::size_t blockRows = 0)
+{
+    const i_dense_matrix<T> matA{mapMatrixFile<T>(pathA)}, matb{mapMatrixFile<T>(pathB)};
+    if (matA.empty() || matb.empty())
+    {
+        return i_dense_matrix<T>();
+    }
+    return tsqrLeftDiv(matA, matb, tolerance, blockRows);
+}
@@ -0,0 +1,194 @@
+#pragma once
+/*
+Mini Matrix Tools - Sherman-Morrison-Woodbury Low-Rank Updates
+Vesion: 0.9 - 2021.11.18 by Fanseline
+https://ferryyoungfan.github.io
+
+inv(A + U * V') & (A + U * V') \ B from an inverse or LU factorization of A that is already known, U & V n x k [*1]:
+    inv(A + U * V') = inv(A) - inv(A) * U * inv(C) * V' * inv(A),   C = I + V' * inv(A) * U   (k x k capacitance)
+O(n^2 * k) instead of an O(n^3) inv on the whole matrix; k = 1 is the Sherman-Morrison formula.
+The update cancels when C is (nearly) singular compared with its parts, i.e. A + U * V' is much closer to
+singular than A (k = 1: v' * inv(A) * u close to -1). C is factored by LU and
+    capacitanceRatio = min|U_C(i, i)| / (1 + max|V' * inv(A) * U|)
+measures this; at or below the tolerance A + U * V' is formed & factored again instead, O(n^3), and
+i_woodbury_info::refactored tells the caller.
+This threshold is not a rank tolerance: the update loses about log10(1 / capacitanceRatio) digits, so it
+defaults to woodburyTolerance<T>() = sqrt(eps) (1.5e-8 in double, 3.5e-4 in float), keeping at least half of them.
+
+Main Function List:
+[1] woodburyInverse: inv(A + U * V') from inv(A)
+[2] woodburySolve:   (A + U * V') \ B from LUFactorization(A), any number of right-hand sides
+[3] woodburyTolerance: Default capacitance-ratio threshold of the fallback, sqrt(eps)
+
+Reference:
+[*1] William W. Hager, Updating the Inverse of a Matrix, SIAM Review 31(2), 1989
+*/
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include "matBasic_dense.hpp"
+#include "matBasic_gemm.hpp"
+#include "matBasic_lu.hpp"
+
+struct i_woodbury_info
+{
+    double capacitanceRatio{0.0}; // min|U_C(i, i)| / (1 + max|V' * inv(A) * U|), near 0 for an unstable update
+    bool refactored{false};       // The update was unstable, the result comes from a new factorization of A + U * V'
+};
+
+// Default capacitance ratio below which the update is refactored instead: sqrt(eps), much looser than defaultTolerance<T>()
+template <typename T>
+typename i_real_type<T>::type woodburyTolerance()
+{
+    return std::sqrt(std::numeric_limits<typename i_real_type<T>::type>::epsilon());
+}
+
+namespace i_woodbury
+{
+    // C = I + V' * Z with Z = inv(A) * U, factored; ratio gets the capacitance ratio
+    template <typename T>
+    LUFactorization<T> capacitance(const i_dense_matrix<T> &matV, const i_dense_matrix<T> &matZ, double &ratio)
+    {
+        using real_t = typename i_real_type<T>::type;
+        const std::size_t nRank{matV.cols()};
+        i_dense_matrix<T> matC(nRank, nRank);
+        i_kernel::gemm(nRank, nRank, matV.rows(), matV.data(), matV.stride(), true, matZ.data(), matZ.stride(), false, matC.data(), matC.stride());
+        real_t maxVZ{0};
+        for (std::size_t i{0}; i < nRank; ++i)
+        {
+            for (std::size_t j{0}; j < nRank; ++j)
+            {
+                maxVZ = std::max(maxVZ, static_cast<real_t>(std::abs(matC(i, j))));
+            }
+            matC(i, i) += T{1};
+        }
+        LUFactorization<T> factorC(matC);
+        real_t minPivot{nRank == 0 ? real_t{1} : std::abs(factorC.packedLU()(0, 0))};
+        for (std::size_t i{1}; i < nRank; ++i)
+        {
+            minPivot = std::min(minPivot, static_cast<real_t>(std::abs(factorC.packedLU()(i, i))));
+        }
+        ratio = factorC.singular() ? 0.0 : static_cast<double>(minPivot / (1 + maxVZ));
+        return factorC;
+    }
+
+    // A + U * V'
+    template <typename T>
+    i_dense_matrix<T> addLowRank(i_dense_matrix<T> matA, const i_dense_matrix<T> &matU, const i_dense_matrix<T> &matV)
+    {
+        i_kernel::gemm(matA.rows(), matA.cols(), matU.cols(), matU.data(), matU.stride(), false, matV.data(), matV.stride(), true, matA.data(), matA.stride());
+        return matA;
+    }
+
+    template <typename T>
+    bool sizeCheck(const std::size_t nSize, const i_dense_matrix<T> &matU, const i_dense_matrix<T> &matV, const char *name)
+    {
+        if (matU.rows() != nSize || matV.rows() != nSize || matU.cols() != matV.cols())
+        {
+            std::cout << "Error when using " << name << ": dimension not match.\n";
+            return false;
+        }
+        return true;
+    }
+} // namespace i_woodbury
+
+// inv(A + U * V') from matAinv = inv(A); the fallback recovers A as inv(inv(A))
+template <typename T>
+i_dense_matrix<T> woodburyInverse(const i_dense_matrix<T> &matAinv, const i_dense_matrix<T> &matU, const i_dense_matrix<T> &matV,
+                                  const typename i_real_type<T>::type tolerance = woodburyTolerance<T>(), i_woodbury_info *info = nullptr)
+{
+    const std::size_t nSize{matAinv.rows()}, nRank{matU.cols()};
+    i_woodbury_info result;
+    if (matAinv.cols() != nSize || !i_woodbury::sizeCheck(nSize, matU, matV, "woodburyInverse"))
+    {
+        return i_dense_matrix<T>();
+    }
+    i_dense_matrix<T> matZ(nSize, nRank), matW(nRank, nSize);
+    i_kernel::gemm(nSize, nRank, nSize, matAinv.data(), matAinv.stride(), false, matU.data(), matU.stride(), false, matZ.data(), matZ.stride()); // Z = inv(A) * U
+    const LUFactorization<T> factorC{i_woodbury::capacitance(matV, matZ, result.capacitanceRatio)};
+
+    i_dense_matrix<T> resMat;
+    if (result.capacitanceRatio > tolerance)
+    {
+        i_kernel::gemm(nRank, nSize, nSize, matV.data(), matV.stride(), true, matAinv.data(), matAinv.stride(), false, matW.data(), matW.stride()); // W = V' * inv(A)
+        const i_dense_matrix<T> matCW{factorC.solve(matW)};
+        resMat = matAinv;
+        i_kernel::gemm(nSize, nSize, nRank, matZ.data(), matZ.stride(), false, matCW.data(), matCW.stride(), false, resMat.data(), resMat.stride(), T{-1});
+    }
+    else
+    {
+        result.refactored = true;
+        const LUFactorization<T> factorAinv(matAinv);
+        const LUFactorization<T> factorNew(factorAinv.singular() ? LUFactorization<T>() : LUFactorization<T>(i_woodbury::addLowRank(factorAinv.inverse(), matU, matV)));
+        if (factorNew.empty() || factorNew.singular())
+        {
+            std::cout << "Warning when using woodburyInverse: matrix is singular.\n";
+        }
+        else
+        {
+            resMat = factorNew.inverse();
+        }
+    }
+    if (info)
+    {
+        *info = result;
+    }
+    return resMat;
+}
+
+// X = (A + U * V') \ B from factorA = LUFactorization(A); the fallback rebuilds A from the factors
+template <typename T>
+i_dense_matrix<T> woodburySolve(const LUFactorization<T> &factorA, const i_dense_matrix<T> &matU, const i_dense_matrix<T> &matV, const i_dense_matrix<T> &matB,
+                                const typename i_real_type<T>::type tolerance = woodburyTolerance<T>(), i_woodbury_info *info = nullptr)
+{
+    const std::size_t nSize{factorA.size()}, nRank{matU.cols()}, nrhs{matB.cols()};
+    i_woodbury_info result;
+    if (!i_woodbury::sizeCheck(nSize, matU, matV, "woodburySolve"))
+    {
+        return i_dense_matrix<T>();
+    }
+    if (matB.rows() != nSize)
+    {
+        std::cout << "Error when using woodburySolve: row size not match.\n";
+        return i_dense_matrix<T>();
+    }
+    LUFactorization<T> factorC;
+    i_dense_matrix<T> matZ;
+    if (!factorA.singular())
+    {
+        matZ = factorA.solve(matU); // Z = A \ U
+        factorC = i_woodbury::capacitance(matV, matZ, result.capacitanceRatio);
+    }
+
+    i_dense_matrix<T> matX;
+    if (result.capacitanceRatio > tolerance)
+    {
+        // X = Y - Z * (C \ (V' * Y)), Y = A \ B
+        matX = factorA.solve(matB);
+        i_dense_matrix<T> matVY(nRank, nrhs);
+        i_kernel::gemm(nRank, nrhs, nSize, matV.data(), matV.stride(), true, matX.data(), matX.stride(), false, matVY.data(), matVY.stride());
+        const i_dense_matrix<T> matCVY{factorC.solve(matVY)};
+        i_kernel::gemm(nSize, nrhs, nRank, matZ.data(), matZ.stride(), false, matCVY.data(), matCVY.stride(), false, matX.data(), matX.stride(), T{-1});
+    }
+    else
+    {
+        result.refactored = true;
+        const LUFactorization<T> factorNew(i_woodbury::addLowRank(factorA.reconstruct(), matU, matV));
+        if (factorNew.singular())
+        {
+            std::cout << "Warning when using woodburySolve: matrix is singular.\n";
+        }
+        else
+        {
+            matX = factorNew.solve(matB);
+        }
+    }
+    if (info)
+    {
+        *info = result;
+    }
+    return matX;
+}